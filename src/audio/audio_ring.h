@@ -0,0 +1,95 @@
+#ifndef AUDIO_RING_H
+#define AUDIO_RING_H
+
+#include <stdint.h>
+#include <atomic>
+#include "ay_chip.h"
+
+// ═══════════════════════════════════════════════════════════
+// 🔁 AUDIO RING (V3.145): эмулятор → Audio Task без блокировок
+// ═══════════════════════════════════════════════════════════
+//
+// Раньше: один слот accumFrame + frameReady под noInterrupts().
+// - Audio Task не успел → кадр молча перезаписан
+// - Эмулятор опоздал → тишина
+// - Запрет прерываний каждый кадр на обоих ядрах
+//
+// Теперь: кольцо на N кадров, один писатель (loop, core 1) и один
+// читатель (Task_Audio). Индексы - std::atomic (acquire/release),
+// слоты пишутся/читаются на месте (без лишнего копирования).
+//
+// Переполнение (читатель отстал): новый кадр отбрасывается (overrun).
+// Опустошение (писатель опоздал): читатель играет тишину (underrun).
+// ═══════════════════════════════════════════════════════════
+
+static const int AUDIO_MAX_EDGES = 1024;   // = ZXSpectrum::MAX_BEEPER_EDGES
+static const int AUDIO_MAX_AY_WRITES = 256; // = ZXSpectrum::MAX_AY_WRITES (V3.148)
+
+// V3.150: один вид кадра - фронты beeper и EAR (лента) в одном логе
+struct AudioFrame {
+  uint8_t startLevel;        // Уровни в начале кадра: бит 0 beeper, бит 1 EAR
+  uint16_t count;            // Число фронтов
+  uint32_t frameLen;         // Длина кадра в t-states
+  uint32_t submitUs;         // V3.149: время commitWrite (мкс, младшие 32 бита) → возраст кадра
+  uint32_t edges[AUDIO_MAX_EDGES];   // t-state | BeeperSynth::EDGE_EAR
+  // V3.148: AY - записи регистров кадра
+  uint16_t ayCount;
+  bool ayResync;             // Сначала принять ayRegs (на начало кадра) целиком
+  uint8_t ayRegs[16];
+  AYWrite ay[AUDIO_MAX_AY_WRITES];
+};
+
+template <typename T, int N>
+class SPSCRing {
+  static_assert((N & (N - 1)) == 0, "SPSCRing size must be a power of two");
+
+public:
+  SPSCRing() : head(0), tail(0), overruns(0), underruns(0) {}
+
+  // ═══ ПИСАТЕЛЬ ═══
+  // Слот для записи или nullptr если кольцо полно (считается overrun)
+  T* beginWrite() {
+    uint32_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) >= (uint32_t)N) {
+      overruns.fetch_add(1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    return &slots[h & (N - 1)];
+  }
+  // Опубликовать слот, полученный из beginWrite()
+  void commitWrite() {
+    head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  // ═══ ЧИТАТЕЛЬ ═══
+  // Самый старый кадр или nullptr если пусто (считается underrun)
+  const T* beginRead() {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    if (head.load(std::memory_order_acquire) == t) {
+      underruns.fetch_add(1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    return &slots[t & (N - 1)];
+  }
+  // Освободить слот, полученный из beginRead()
+  void endRead() {
+    tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  // ═══ СОСТОЯНИЕ (из любого потока, приблизительно) ═══
+  int fill() const {
+    return (int)(head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire));
+  }
+  static constexpr int capacity() { return N; }
+  uint32_t overrunCount() const { return overruns.load(std::memory_order_relaxed); }
+  uint32_t underrunCount() const { return underruns.load(std::memory_order_relaxed); }
+
+private:
+  T slots[N];
+  std::atomic<uint32_t> head;       // Пишет только писатель
+  std::atomic<uint32_t> tail;       // Пишет только читатель
+  std::atomic<uint32_t> overruns;
+  std::atomic<uint32_t> underruns;
+};
+
+#endif // AUDIO_RING_H
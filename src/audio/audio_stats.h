@@ -0,0 +1,165 @@
+#ifndef AUDIO_STATS_H
+#define AUDIO_STATS_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <atomic>
+
+// ═══════════════════════════════════════════════════════════
+// 📊 AUDIO STATS (V3.149): задержка и опустошение звукового потока
+// ═══════════════════════════════════════════════════════════
+//
+// Audio Task на каждый свой буфер сообщает: сыграл кадр (с возрастом
+// кадра в кольце и заполнением) или вставил тишину. Эмулятор - что
+// кадр не влез в кольцо (перезапись/отброс).
+//
+// Два уровня:
+// - накопительные счётчики с запуска (played/silence/overwrites/idle)
+// - окно (с прошлого takeWindow): возраст кадра min/avg/max,
+//   заполнение кольца min/avg/max + гистограмма уровней
+//
+// Тишина дольше IDLE_AFTER буферов подряд = эмулятор стоит (пауза,
+// меню, браузер) → считается idle, а не underrun.
+//
+// Писатель один (Audio Task), читатель - loop(): все поля atomic
+// relaxed, окно сбрасывает сам писатель по запросу читателя.
+// Исключение - перезаписи: их считает эмулятор (другой поток), поэтому
+// окно перезаписей читатель забирает exchange(0), писатель его не трогает.
+// Без Arduino зависимостей - время передаётся снаружи (мкс).
+// ═══════════════════════════════════════════════════════════
+
+struct AudioStatsWindow {
+  uint32_t played;           // Кадров сыграно в окне
+  uint32_t silence;          // Вставлено тишины (эмулятор опоздал)
+  uint32_t overwrites;       // Кадров не влезло в кольцо
+  uint32_t ageMinUs, ageAvgUs, ageMaxUs;   // Возраст кадра при воспроизведении
+  uint8_t fillMin, fillMax;  // Заполнение кольца при взятии кадра
+  uint16_t fillAvgX10;       // Среднее ×10
+  uint32_t fillHist[9];      // Гистограмма заполнения 0..8
+};
+
+class AudioStats {
+public:
+  static const int MAX_FILL = 8;       // Ячеек гистограммы - 1
+  static const int IDLE_AFTER = 25;    // 0.5 с тишины подряд → idle
+
+  AudioStats() { reset(); }
+
+  void reset() {
+    played.store(0); silence.store(0); overwrites.store(0); idle.store(0);
+    lastAgeUs.store(0);
+    wOverwrites.store(0);
+    silenceStreak = 0;
+    clearWindow();
+    resetReq.store(false);
+  }
+
+  // ═══ AUDIO TASK ═══
+  // Сыгран кадр: ageUs - сколько кадр пролежал в кольце, fill - заполнение
+  void notePlayed(uint32_t ageUs, int fill) {
+    serviceReset();
+    silenceStreak = 0;
+    played.fetch_add(1, std::memory_order_relaxed);
+    lastAgeUs.store(ageUs, std::memory_order_relaxed);
+
+    wPlayed.fetch_add(1, std::memory_order_relaxed);
+    wAgeSum.fetch_add(ageUs, std::memory_order_relaxed);
+    if (ageUs < wAgeMin.load(std::memory_order_relaxed)) wAgeMin.store(ageUs, std::memory_order_relaxed);
+    if (ageUs > wAgeMax.load(std::memory_order_relaxed)) wAgeMax.store(ageUs, std::memory_order_relaxed);
+    noteFill(fill);
+  }
+
+  // Кадра нет - играем тишину
+  void noteSilence() {
+    serviceReset();
+    if (silenceStreak < IDLE_AFTER) {
+      silenceStreak++;
+      silence.fetch_add(1, std::memory_order_relaxed);
+      wSilence.fetch_add(1, std::memory_order_relaxed);
+      noteFill(0);
+    } else {
+      idle.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  // ═══ ЭМУЛЯТОР ═══
+  // Кадр не влез в кольцо
+  void noteOverwrite() {
+    overwrites.fetch_add(1, std::memory_order_relaxed);
+    wOverwrites.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // ═══ ЧИТАТЕЛЬ (loop) ═══
+  uint32_t framesPlayed() const { return played.load(std::memory_order_relaxed); }
+  uint32_t silenceInserted() const { return silence.load(std::memory_order_relaxed); }
+  uint32_t overwriteCount() const { return overwrites.load(std::memory_order_relaxed); }
+  uint32_t idleFrames() const { return idle.load(std::memory_order_relaxed); }
+  uint32_t lastFrameAgeUs() const { return lastAgeUs.load(std::memory_order_relaxed); }
+
+  // Снять окно и попросить писателя начать новое
+  void takeWindow(AudioStatsWindow& w) {
+    w.played = wPlayed.load(std::memory_order_relaxed);
+    w.silence = wSilence.load(std::memory_order_relaxed);
+    // Счётчик другого потока: забрать и обнулить одной операцией (без потерь)
+    w.overwrites = wOverwrites.exchange(0, std::memory_order_relaxed);
+    uint32_t n = w.played ? w.played : 1;
+    w.ageMinUs = w.played ? wAgeMin.load(std::memory_order_relaxed) : 0;
+    w.ageMaxUs = wAgeMax.load(std::memory_order_relaxed);
+    w.ageAvgUs = (uint32_t)(wAgeSum.load(std::memory_order_relaxed) / n);
+    uint32_t pulls = w.played + w.silence;
+    w.fillMin = pulls ? wFillMin.load(std::memory_order_relaxed) : 0;
+    w.fillMax = wFillMax.load(std::memory_order_relaxed);
+    w.fillAvgX10 = pulls ? (uint16_t)(wFillSum.load(std::memory_order_relaxed) * 10 / pulls) : 0;
+    for (int i = 0; i <= MAX_FILL; i++) w.fillHist[i] = wFillHist[i].load(std::memory_order_relaxed);
+    resetReq.store(true, std::memory_order_release);
+  }
+
+  // Одна строка для HUD: "A age 12/21/40 fill 1/2.0/3 u0 o0"
+  static void formatHud(const AudioStatsWindow& w, char* out, size_t size) {
+    snprintf(out, size, "A %u/%u/%ums f%u/%u.%u/%u u%u o%u",
+             (unsigned)(w.ageMinUs / 1000), (unsigned)(w.ageAvgUs / 1000), (unsigned)(w.ageMaxUs / 1000),
+             w.fillMin, w.fillAvgX10 / 10, w.fillAvgX10 % 10, w.fillMax,
+             (unsigned)w.silence, (unsigned)w.overwrites);
+  }
+
+private:
+  void noteFill(int fill) {
+    if (fill < 0) fill = 0;
+    if (fill > MAX_FILL) fill = MAX_FILL;
+    wFillSum.fetch_add(fill, std::memory_order_relaxed);
+    if ((uint8_t)fill < wFillMin.load(std::memory_order_relaxed)) wFillMin.store(fill, std::memory_order_relaxed);
+    if ((uint8_t)fill > wFillMax.load(std::memory_order_relaxed)) wFillMax.store(fill, std::memory_order_relaxed);
+    wFillHist[fill].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Окно сбрасывает писатель (читатель только просит)
+  void serviceReset() {
+    if (resetReq.load(std::memory_order_acquire)) {
+      clearWindow();
+      resetReq.store(false, std::memory_order_relaxed);
+    }
+  }
+
+  void clearWindow() {
+    wPlayed.store(0); wSilence.store(0);  // wOverwrites - в takeWindow
+    wAgeSum.store(0); wAgeMin.store(0xFFFFFFFF); wAgeMax.store(0);
+    wFillSum.store(0); wFillMin.store(0xFF); wFillMax.store(0);
+    for (int i = 0; i <= MAX_FILL; i++) wFillHist[i].store(0);
+  }
+
+  // Накопительные
+  std::atomic<uint32_t> played, silence, overwrites, idle;
+  std::atomic<uint32_t> lastAgeUs;
+  int silenceStreak;           // Только писатель
+
+  // Окно
+  std::atomic<uint32_t> wPlayed, wSilence, wOverwrites;
+  std::atomic<uint32_t> wAgeSum;        // мкс; окно ~1 с - переполнения нет
+  std::atomic<uint32_t> wAgeMin, wAgeMax;
+  std::atomic<uint32_t> wFillSum;
+  std::atomic<uint8_t> wFillMin, wFillMax;
+  std::atomic<uint32_t> wFillHist[MAX_FILL + 1];
+  std::atomic<bool> resetReq;
+};
+
+#endif // AUDIO_STATS_H
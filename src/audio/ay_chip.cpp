@@ -0,0 +1,202 @@
+#include "ay_chip.h"
+#include <string.h>
+
+// Логарифмический ЦАП AY (16 уровней, нормировка к CHANNEL_MAX = 4000)
+static const int16_t ayVolume[16] = {
+  0, 40, 58, 84, 123, 182, 258, 429, 506, 820, 1169, 1491, 1970, 2541, 3222, 4000
+};
+
+const uint8_t AYChip::REG_MASK[16] = {
+  0xFF, 0x0F, 0xFF, 0x0F, 0xFF, 0x0F, 0x1F, 0xFF,
+  0x1F, 0x1F, 0x1F, 0xFF, 0xFF, 0x0F, 0xFF, 0xFF
+};
+
+// DC-блокер как у beeper: R = 0.995, Q15
+static const int32_t DC_R_Q15 = 32604;
+
+AYChip::AYChip() {
+  reset();
+}
+
+void AYChip::reset() {
+  memset(regs, 0, sizeof(regs));
+  regs[7] = 0xFF;              // Всё выключено
+  active = false;
+  for (int c = 0; c < 3; c++) {
+    tonePeriod[c] = 1;
+    toneCnt[c] = 0;
+    toneOut[c] = 0;
+  }
+  noisePeriod = 2;
+  noiseCnt = 0;
+  noiseRng = 1;
+  noiseOut = 0;
+  envPeriod = 2;
+  envCnt = 0;
+  envPos = 0;
+  envDir = -1;
+  envHolding = true;
+  tickFrac = 0;
+  lastMix = 0;
+  dcPrevIn = 0;
+  dcPrevOut = 0;
+}
+
+void AYChip::writeReg(uint8_t reg, uint8_t val) {
+  active = true;
+  applyReg(reg, val);
+}
+
+void AYChip::applyReg(uint8_t reg, uint8_t val) {
+  reg &= 0x0F;
+  val &= REG_MASK[reg];
+  regs[reg] = val;
+
+  switch (reg) {
+    case 0: case 1: case 2: case 3: case 4: case 5: {
+      int c = reg >> 1;
+      uint16_t p = regs[c * 2] | ((uint16_t)regs[c * 2 + 1] << 8);
+      tonePeriod[c] = p ? p : 1;
+      break;
+    }
+    case 6:
+      noisePeriod = (val ? val : 1) * 2;
+      break;
+    case 11: case 12: {
+      uint32_t p = regs[11] | ((uint32_t)regs[12] << 8);
+      // Полная рампа (16 шагов) = 256·EP тактов → шаг = 16·EP = 2·EP тиков clock/8
+      envPeriod = (p ? p : 1) * 2;
+      break;
+    }
+    case 13:
+      envRestart();            // Запись формы ВСЕГДА перезапускает огибающую
+      break;
+  }
+}
+
+void AYChip::syncRegs(const uint8_t* regs16) {
+  uint8_t oldShape = regs[13];
+  for (uint8_t r = 0; r < 13; r++) applyReg(r, regs16[r]);
+  if ((regs16[13] & 0x0F) != oldShape) applyReg(13, regs16[13]);
+  regs[14] = regs16[14];
+  regs[15] = regs16[15];
+
+  // Сброс эмулятора шлёт нули каждый раз (48K игры тоже) - синтез
+  // включается только если каналу есть что играть (громкость/огибающая)
+  for (int c = 0; c < 3; c++) {
+    if (regs[8 + c] & 0x1F) active = true;
+  }
+}
+
+void AYChip::envRestart() {
+  envCnt = 0;
+  envHolding = false;
+  if (regs[13] & 0x04) {       // Attack: снизу вверх
+    envPos = 0;
+    envDir = 1;
+  } else {
+    envPos = 15;
+    envDir = -1;
+  }
+}
+
+void AYChip::envStep() {
+  if (envHolding) return;
+  envPos += envDir;
+  if (envPos >= 0 && envPos <= 15) return;
+
+  // Конец цикла: поведение по битам Continue/Attack/Alternate/Hold
+  uint8_t sh = regs[13];
+  if (!(sh & 0x08)) {          // Continue = 0: один цикл, затем 0
+    envHolding = true;
+    envPos = 0;
+  } else if (sh & 0x01) {      // Hold: замираем на конечном уровне
+    envHolding = true;
+    bool attack = (sh & 0x04) != 0;
+    bool alternate = (sh & 0x02) != 0;
+    envPos = (attack != alternate) ? 15 : 0;
+  } else if (sh & 0x02) {      // Alternate: треугольник
+    envDir = -envDir;
+    envPos += envDir;
+  } else {                     // Пила
+    envPos = (envDir > 0) ? 0 : 15;
+  }
+}
+
+void AYChip::renderFrame(const AYWrite* writes, int count, uint32_t frameLen,
+                         int16_t* out, int outCount, int volume) {
+  if (!active && count == 0) return;
+  if (frameLen == 0) frameLen = 69888;
+  if (outCount < 1) return;
+  if (volume < 0) volume = 0;
+  if (volume > 10) volume = 10;
+
+  // Тиков clock/8 на сэмпл (Q16): время кадра эмулятора / сэмплы кадра
+  // (DRC растягивает кадр - высота тона следует за темпом, как у beeper)
+  const uint32_t stepQ16 = (uint32_t)(((uint64_t)frameLen * (CLOCK_HZ / 8) << 16) /
+                                      ((uint64_t)CPU_HZ * outCount));
+  const int32_t gain = volume * 6554;  // vol/10 в Q16
+
+  int w = 0;
+  for (int s = 0; s < outCount; s++) {
+    // ═══ 1) Записи, попавшие в этот сэмпл ═══
+    while (w < count &&
+           (uint32_t)(((uint64_t)writes[w].t * outCount) / frameLen) <= (uint32_t)s) {
+      writeReg(writes[w].reg, writes[w].val);
+      w++;
+    }
+
+    // ═══ 2) Тики генераторов + усреднение ═══
+    tickFrac += stepQ16;
+    int ticks = tickFrac >> 16;
+    tickFrac &= 0xFFFF;
+
+    const uint8_t mixer = regs[7];
+    int32_t sum = 0;
+    for (int t = 0; t < ticks; t++) {
+      for (int c = 0; c < 3; c++) {
+        if (++toneCnt[c] >= tonePeriod[c]) {
+          toneCnt[c] = 0;
+          toneOut[c] ^= 1;
+        }
+      }
+      if (++noiseCnt >= noisePeriod) {
+        noiseCnt = 0;
+        // LFSR 17 бит: x^17 + x^14 + 1
+        noiseRng = (noiseRng >> 1) | (((noiseRng ^ (noiseRng >> 3)) & 1) << 16);
+        noiseOut = noiseRng & 1;
+      }
+      if (++envCnt >= envPeriod) {
+        envCnt = 0;
+        envStep();
+      }
+
+      for (int c = 0; c < 3; c++) {
+        // Канал звучит: (тон ИЛИ тон выключен) И (шум ИЛИ шум выключен)
+        bool on = (toneOut[c] | ((mixer >> c) & 1)) & (noiseOut | ((mixer >> (c + 3)) & 1));
+        if (on) {
+          uint8_t amp = regs[8 + c];
+          sum += ayVolume[(amp & 0x10) ? envPos : (amp & 0x0F)];
+        }
+      }
+    }
+    int32_t x = ticks ? sum / ticks : lastMix;
+    lastMix = x;
+
+    // ═══ 3) DC-блокер + громкость + микс с beeper ═══
+    int32_t y = x - dcPrevIn + ((dcPrevOut * DC_R_Q15) >> 15);
+    dcPrevIn = x;
+    dcPrevOut = y;
+
+    int32_t v = out[s] + ((y * gain) >> 16);
+    if (v > 32767) v = 32767;
+    if (v < -32768) v = -32768;
+    out[s] = (int16_t)v;
+  }
+
+  // Записи с t за концом кадра (runForFrame перебрал t-states)
+  while (w < count) {
+    writeReg(writes[w].reg, writes[w].val);
+    w++;
+  }
+}
@@ -0,0 +1,89 @@
+#ifndef AY_CHIP_H
+#define AY_CHIP_H
+
+#include <stdint.h>
+
+// ═══════════════════════════════════════════════════════════
+// 🎹 AY-3-8912 PSG (V3.148): лог записей → PCM в Audio Task
+// ═══════════════════════════════════════════════════════════
+//
+// Эмулятор НЕ синтезирует звук: z80_out на 0xBFFD только пишет
+// {t-state, регистр, значение} в лог кадра (см. ZXSpectrum::z80_out).
+// Audio Task проигрывает лог на своём буфере:
+//
+// 1) Запись в момент t применяется к сэмплу t * outCount / frameLen
+// 2) Генераторы (3 тона, шум LFSR 17 бит, огибающая 16 форм) тикают
+//    на clock/8 (~221 kHz), ~14 тиков на сэмпл @16 kHz
+// 3) Выход тиков усредняется (box-фильтр против алиасинга ультразвука),
+//    логарифмический ЦАП (таблица AY), DC-блокер, громкость
+// 4) Результат ПРИБАВЛЯЕТСЯ к буферу beeper (с насыщением)
+//
+// Всё целочисленное. Пока в AY ни разу не писали - renderFrame()
+// сразу выходит (48K игры без AY не платят за синтез).
+// Без Arduino зависимостей - собирается и на хосте.
+// ═══════════════════════════════════════════════════════════
+
+// Одна запись в регистр AY (t-states от начала кадра)
+struct AYWrite {
+  uint32_t t;
+  uint8_t reg;     // 0..15
+  uint8_t val;
+};
+
+class AYChip {
+public:
+  static const uint32_t CLOCK_HZ = 1773400;   // AY в 128K / большинство 48K интерфейсов
+  static const uint32_t CPU_HZ = 3500000;     // Z80 48K
+  static const int CHANNEL_MAX = 4000;        // Пик одного канала (3 канала ≈ beeper)
+
+  AYChip();
+
+  // Сбросить регистры и генераторы
+  void reset();
+
+  // Кадр записей → ПРИБАВИТЬ к out[outCount].
+  // writes: по возрастанию t; frameLen: длина кадра в t-states
+  // volume: 0..10 (как у beeper)
+  void renderFrame(const AYWrite* writes, int count, uint32_t frameLen,
+                   int16_t* out, int outCount, int volume);
+
+  // Принять состояние регистров целиком (после сброса эмулятора или
+  // переполнения лога). Огибающая перезапускается только если форма другая.
+  // Синтез не включает, пока все громкости 0 (сброс AY - не запись)
+  void syncRegs(const uint8_t* regs16);
+
+  bool isActive() const { return active; }
+
+  // Значимые биты регистров (чтение 0xFFFD возвращает значение с маской)
+  static const uint8_t REG_MASK[16];
+
+private:
+  void writeReg(uint8_t reg, uint8_t val);   // Запись программы: active = true
+  void applyReg(uint8_t reg, uint8_t val);   // Регистр + производные периоды
+  void envRestart();
+  void envStep();
+
+  uint8_t regs[16];
+  bool active;                 // Была запись (или ресинхронизация с громкостью)
+
+  // Генераторы (единицы - тики clock/8)
+  uint16_t tonePeriod[3];
+  uint16_t toneCnt[3];
+  uint8_t toneOut[3];
+  uint16_t noisePeriod;        // Уже ×2 (шум тактуется clock/16)
+  uint16_t noiseCnt;
+  uint32_t noiseRng;           // LFSR 17 бит
+  uint8_t noiseOut;
+  uint32_t envPeriod;          // Уже ×2 (шаг огибающей = 16·EP тактов, рампа = 256·EP)
+  uint32_t envCnt;
+  int8_t envPos;               // 0..15
+  int8_t envDir;               // +1 / -1
+  bool envHolding;
+
+  uint32_t tickFrac;           // Дробная часть тиков (Q16)
+  int32_t lastMix;             // Выход при 0 тиков в сэмпле
+  int32_t dcPrevIn;            // DC-блокер: x[n-1]
+  int32_t dcPrevOut;           // DC-блокер: y[n-1]
+};
+
+#endif // AY_CHIP_H
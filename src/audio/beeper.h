@@ -4,16 +4,49 @@
 #include <Arduino.h>
 #include <driver/i2s.h>
 
-// Simple I2S beeper for ZX Spectrum
-// Outputs audio buffer (312 samples per frame @ 15.6 KHz = 50 fps)
+// ═══════════════════════════════════════════════════════════
+// 🔊 I2S STREAMING BEEPER (V3.147)
+// ═══════════════════════════════════════════════════════════
+//
+// Альтернатива M5Cardputer.Speaker.playRaw() + опрос isPlaying():
+// - DMA дескрипторы всегда заполнены (tx_desc_auto_clear → при
+//   опоздании играет тишина, а не мусор)
+// - write() блокируется в i2s_write пока в DMA нет места →
+//   Audio Task спит, никаких vTaskDelay(1) и щелей между буферами
+// - Задержка = I2S_DMA_BUF_COUNT × I2S_DMA_BUF_LEN сэмплов
+//
+// Включается build флагом -DI2S_SPEAKER_ENABLED (platformio.ini).
+// Без флага используется M5Cardputer.Speaker (как раньше).
+// ═══════════════════════════════════════════════════════════
+
+// Пины встроенного усилителя Cardputer (NS4168)
+#ifndef I2S_SPEAKER_SERIAL_CLOCK
+#define I2S_SPEAKER_SERIAL_CLOCK      41   // BCLK
+#endif
+#ifndef I2S_SPEAKER_LEFT_RIGHT_CLOCK
+#define I2S_SPEAKER_LEFT_RIGHT_CLOCK  43   // LRCK / WS
+#endif
+#ifndef I2S_SPEAKER_SERIAL_DATA
+#define I2S_SPEAKER_SERIAL_DATA       42   // DATA
+#endif
+
+// Глубина DMA (задержка): 4 × 160 = 640 сэмплов = 40 мс @16 kHz
+#ifndef I2S_DMA_BUF_COUNT
+#define I2S_DMA_BUF_COUNT 4
+#endif
+#ifndef I2S_DMA_BUF_LEN
+#define I2S_DMA_BUF_LEN 160    // Сэмплов на дескриптор (макс. 1024)
+#endif
+
 class Beeper {
 private:
   i2s_port_t i2s_num = I2S_NUM_0;
-  int sampleRate = 15600;  // 312 samples * 50 fps
+  int sampleRate = 16000;
   bool initialized = false;
 
 public:
-  bool init() {
+  bool init(int rate = 16000) {
+    sampleRate = rate;
     #ifdef I2S_SPEAKER_ENABLED
     i2s_config_t i2s_config = {
       .mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_TX),
@@ -22,10 +55,10 @@ public:
       .channel_format = I2S_CHANNEL_FMT_ONLY_LEFT,
       .communication_format = I2S_COMM_FORMAT_STAND_I2S,
       .intr_alloc_flags = ESP_INTR_FLAG_LEVEL1,
-      .dma_buf_count = 8,
-      .dma_buf_len = 256,
+      .dma_buf_count = I2S_DMA_BUF_COUNT,
+      .dma_buf_len = I2S_DMA_BUF_LEN,
       .use_apll = false,
-      .tx_desc_auto_clear = true,
+      .tx_desc_auto_clear = true,   // Опоздали → DMA играет нули
       .fixed_mclk = 0
     };
 
@@ -43,12 +76,15 @@ public:
 
     if (i2s_set_pin(i2s_num, &pin_config) != ESP_OK) {
       Serial.println("Failed to set I2S pins");
+      i2s_driver_uninstall(i2s_num);
       return false;
     }
 
     i2s_zero_dma_buffer(i2s_num);
     initialized = true;
-    Serial.println("I2S Beeper initialized");
+    Serial.printf("I2S Beeper initialized: %d Hz, DMA %d x %d samples (%d ms)\n",
+                  sampleRate, I2S_DMA_BUF_COUNT, I2S_DMA_BUF_LEN,
+                  I2S_DMA_BUF_COUNT * I2S_DMA_BUF_LEN * 1000 / sampleRate);
     return true;
     #else
     Serial.println("I2S Beeper disabled (no I2S_SPEAKER_ENABLED)");
@@ -56,21 +92,18 @@ public:
     #endif
   }
 
-  // Write audio buffer (312 samples, 8-bit)
-  // Convert to 16-bit stereo for I2S
-  void write(const uint8_t *audioBuffer, size_t len) {
-    if (!initialized) return;
+  bool isReady() const { return initialized; }
 
-    #ifdef I2S_SPEAKER_ENABLED
-    int16_t samples[312];
-    for (size_t i = 0; i < len && i < 312; i++) {
-      // Convert 8-bit to 16-bit signed
-      samples[i] = (int16_t)((audioBuffer[i] - 128) << 8);
-    }
+  // Записать PCM (моно 16-бит). Блокируется пока в DMA нет места -
+  // именно это задаёт темп Audio Task. Возвращает записанные сэмплы.
+  size_t write(const int16_t* samples, size_t count) {
+    if (!initialized) return 0;
 
-    size_t bytesWritten;
-    i2s_write(i2s_num, samples, len * sizeof(int16_t), &bytesWritten, portMAX_DELAY);
+    size_t bytesWritten = 0;
+    #ifdef I2S_SPEAKER_ENABLED
+    i2s_write(i2s_num, samples, count * sizeof(int16_t), &bytesWritten, portMAX_DELAY);
     #endif
+    return bytesWritten / sizeof(int16_t);
   }
 
   void silence() {
@@ -83,4 +116,3 @@ public:
 };
 
 #endif // BEEPER_H
-
@@ -0,0 +1,118 @@
+#include "beeper_synth.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// DC-блокер: y = x - x[n-1] + R·y[n-1], R = 0.995 (срез ~13 Гц @16 kHz), Q15
+static const int32_t DC_R_Q15 = 32604;
+
+BeeperSynth::BeeperSynth() : earAmp(AMP) {
+  memset(blit, 0, sizeof(blit));
+  reset();
+}
+
+void BeeperSynth::setEarGain(int q8) {
+  if (q8 < 0) q8 = 0;
+  if (q8 > 512) q8 = 512;
+  earAmp = (AMP * q8) >> 8;
+}
+
+void BeeperSynth::init() {
+  // Окно Blackman · sinc со срезом 0.45·fs, центр ядра между отсчётами 7 и 8.
+  // Фаза p сдвигает ядро на p/32 сэмпла позже.
+  const double cutoff = 0.45 * 2.0;   // Относительно Найквиста
+  for (int p = 0; p < PHASES; p++) {
+    double frac = (double)p / PHASES;
+    double raw[TAPS];
+    double sum = 0.0;
+    for (int k = 0; k < TAPS; k++) {
+      double x = (double)k - (TAPS / 2 - 1) - frac;   // Расстояние от центра
+      double s = (x == 0.0) ? 1.0 : sin(M_PI * cutoff * x) / (M_PI * cutoff * x);
+      double w = (x + TAPS / 2.0) / TAPS;              // 0..1 по окну
+      double win = (w <= 0.0 || w >= 1.0) ? 0.0
+                 : 0.42 - 0.5 * cos(2.0 * M_PI * w) + 0.08 * cos(4.0 * M_PI * w);
+      raw[k] = s * win;
+      sum += raw[k];
+    }
+
+    // Квантуем в Q15 с нормировкой: сумма фазы = 32768 ровно
+    int32_t qsum = 0;
+    int peak = 0;
+    for (int k = 0; k < TAPS; k++) {
+      blit[p][k] = (int16_t)lrint(raw[k] / sum * 32768.0);
+      qsum += blit[p][k];
+      if (abs(blit[p][k]) > abs(blit[p][peak])) peak = k;
+    }
+    blit[p][peak] += (int16_t)(32768 - qsum);  // Ошибку округления - в пик
+  }
+  reset();
+}
+
+void BeeperSynth::reset() {
+  memset(deltas, 0, sizeof(deltas));
+  integrator = 0;
+  dcPrevIn = 0;
+  dcPrevOut = 0;
+  level = 0;
+}
+
+inline void BeeperSynth::addStep(uint32_t pos32, int32_t delta) {
+  int idx = pos32 >> 5;            // PHASES = 32
+  const int16_t* k = blit[pos32 & (PHASES - 1)];
+  int32_t* d = &deltas[idx];
+  for (int i = 0; i < TAPS; i++) {
+    d[i] += delta * k[i];
+  }
+}
+
+void BeeperSynth::renderFrame(const uint32_t* edges, int count, uint8_t startLevel,
+                              uint32_t frameLen, int16_t* out, int outCount, int volume) {
+  if (frameLen == 0) frameLen = 69888;
+  if (outCount < 1) outCount = 1;
+  if (outCount > MAX_OUT) outCount = MAX_OUT;
+  if (volume < 0) volume = 0;
+  if (volume > 10) volume = 10;
+
+  // Уровень разошёлся (фронты потеряны при переполнении) → ступенька в t=0
+  startLevel &= 3;
+  if ((startLevel ^ level) & 1) {
+    addStep(0, (level & 1) ? -AMP : AMP);
+    level ^= 1;
+  }
+  if ((startLevel ^ level) & 2) {
+    addStep(0, (level & 2) ? -earAmp : earAmp);
+    level ^= 2;
+  }
+
+  // ═══ 1) ФРОНТЫ → BLIT в буфер дельт ═══
+  // pos32 = t * outCount * 32 / frameLen (позиция в 1/32 сэмпла)
+  const uint32_t maxPos32 = (uint32_t)outCount * PHASES - 1;
+  for (int e = 0; e < count; e++) {
+    uint32_t t = edges[e] & ~EDGE_EAR;
+    uint8_t bit = (edges[e] & EDGE_EAR) ? 2 : 1;
+    int32_t amp = (bit == 2) ? earAmp : AMP;
+    uint32_t pos32 = (uint32_t)(((uint64_t)t * outCount * PHASES) / frameLen);
+    if (pos32 > maxPos32) pos32 = maxPos32;
+    addStep(pos32, (level & bit) ? -amp : amp);
+    level ^= bit;
+  }
+
+  // ═══ 2) ИНТЕГРАТОР + DC-БЛОКЕР + ГРОМКОСТЬ ═══
+  const int32_t gain = volume * 6554;  // vol/10 в Q16
+  for (int s = 0; s < outCount; s++) {
+    integrator += deltas[s];
+    int32_t x = integrator >> 15;                          // Уровень 0..AMP(+earAmp)
+    int32_t y = x - dcPrevIn + ((dcPrevOut * DC_R_Q15) >> 15);
+    dcPrevIn = x;
+    dcPrevOut = y;
+
+    int32_t v = (y * gain) >> 16;
+    if (v > 32767) v = 32767;
+    if (v < -32768) v = -32768;
+    out[s] = (int16_t)v;
+  }
+
+  // ═══ 3) ХВОСТ ЯДРА → в начало следующего кадра ═══
+  memmove(deltas, deltas + outCount, TAPS * sizeof(int32_t));
+  memset(deltas + TAPS, 0, MAX_OUT * sizeof(int32_t));
+}
@@ -0,0 +1,71 @@
+#ifndef BEEPER_SYNTH_H
+#define BEEPER_SYNTH_H
+
+#include <stdint.h>
+
+// ═══════════════════════════════════════════════════════════
+// 🎼 BEEPER SYNTH (V3.144): фронты beeper → band-limited PCM
+// ═══════════════════════════════════════════════════════════
+//
+// Эмулятор пишет t-state КАЖДОГО переключения бита 4 порта 0xFE
+// (см. ZXSpectrum::z80_out). Здесь фронты превращаются в PCM @16 kHz:
+//
+// 1) Фронт в момент t → позиция сэмпла pos = t * 320 / frameLen
+//    (целая часть + фаза 1/32 сэмпла)
+// 2) В буфер дельт добавляется BLIT (окно·sinc, 16 отсчётов) для этой
+//    фазы, умноженный на скачок амплитуды
+// 3) Интегратор превращает BLIT в band-limited ступеньку (BLEP),
+//    хвост ядра переносится в следующий кадр
+// 4) DC-блокер убирает постоянную составляющую (beeper 0/1)
+//
+// V3.150: источников два - beeper (бит 4 порта 0xFE) и EAR (сигнал
+// ленты при загрузке). Фронт EAR помечен старшим битом (EDGE_EAR),
+// его ступенька = AMP × earGain. Один синтез и одна громкость на оба.
+//
+// Таблица BLIT: 32 фазы × 16 отсчётов Q15, сумма каждой фазы = 32768
+// ровно (интегратор не дрейфует). Вся обработка кадра - целочисленная.
+// Без Arduino зависимостей - собирается и на хосте.
+// ═══════════════════════════════════════════════════════════
+
+class BeeperSynth {
+public:
+  static const int SPPF = 320;          // Сэмплов на кадр (номинал)
+  static const int MAX_OUT = SPPF + 4;  // V3.146: DRC может растянуть кадр
+  static const int TAPS = 16;           // Длина ядра BLIT
+  static const int PHASES = 32;         // Суб-сэмпловых фаз
+  static const int AMP = 9000;          // Амплитуда ступеньки
+  static const uint32_t EDGE_EAR = 0x80000000u;  // V3.150: фронт EAR (лента), не beeper
+
+  BeeperSynth();
+
+  // Построить таблицу BLIT (один раз, вне аудио цикла)
+  void init();
+
+  // Сбросить состояние (перенос, интегратор, DC-блокер)
+  void reset();
+
+  // V3.150: громкость ленты относительно beeper (Q8, 256 = как beeper)
+  void setEarGain(int q8);
+
+  // Кадр фронтов → out[320].
+  // edges: t-states фронтов (по возрастанию) от начала кадра, | EDGE_EAR для ленты
+  // startLevel: уровни в начале кадра (бит 0 beeper, бит 1 EAR) - ресинхронизация
+  // frameLen: длина кадра в t-states (обычно 69888)
+  // outCount: сколько сэмплов выдать (320 ± DRC поправка, ≤ MAX_OUT)
+  // volume: 0..10
+  void renderFrame(const uint32_t* edges, int count, uint8_t startLevel,
+                   uint32_t frameLen, int16_t* out, int outCount, int volume);
+
+private:
+  void addStep(uint32_t pos32, int32_t delta);
+
+  int16_t blit[PHASES][TAPS];     // Q15
+  int32_t deltas[MAX_OUT + TAPS]; // Q15 × амплитуда; хвост → следующий кадр
+  int32_t integrator;             // Текущий уровень (Q15 × амплитуда)
+  int32_t dcPrevIn;               // DC-блокер: x[n-1]
+  int32_t dcPrevOut;              // DC-блокер: y[n-1]
+  uint8_t level;                  // Текущие уровни: бит 0 beeper, бит 1 EAR
+  int32_t earAmp;                 // V3.150: ступенька EAR (AMP × gain)
+};
+
+#endif // BEEPER_SYNTH_H
@@ -0,0 +1,191 @@
+#include "wav_recorder.h"
+
+// Global WAV recorder
+WavRecorder wavRecorder;
+
+static const size_t WAV_HEADER_BYTES = 44;
+static const char* const REC_DIR = "/ZXrecordings";
+
+static inline void put16(uint8_t* p, uint16_t v) { p[0] = v; p[1] = v >> 8; }
+static inline void put32(uint8_t* p, uint32_t v) { p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24; }
+
+WavRecorder::WavRecorder()
+  : queue(nullptr), stage(nullptr), staged(0), recording(false),
+    stopRequested(false), jobActive(false), sampleRate(16000), dataBytes(0),
+    overrunBase(0), userDone(nullptr), userCtx(nullptr) {
+  filePath[0] = '\0';
+}
+
+bool WavRecorder::start(uint32_t rate) {
+  if (jobActive) return false;  // Прошлый файл ещё дописывается
+
+  // Буферы - один раз, навсегда (Audio Task может держать указатель)
+  if (!queue) {
+    queue = new SPSCRing<WavBlock, QUEUE_BLOCKS>();
+    stage = (uint8_t*)malloc(STAGE_BYTES + sizeof(WavBlock::pcm));
+    if (!queue || !stage) {
+      Serial.println("❌ REC: out of memory");
+      delete queue;
+      free(stage);
+      queue = nullptr;
+      stage = nullptr;
+      return false;
+    }
+  }
+
+  // Остатки прошлой записи (если были) - выбросить
+  while (queue->fill() > 0) {
+    queue->beginRead();
+    queue->endRead();
+  }
+
+  sampleRate = rate;
+  dataBytes = 0;
+  staged = 0;
+  filePath[0] = '\0';
+  stopRequested = false;
+  overrunBase = queue->overrunCount();
+
+  BusJob job = {"wav-record", step, done, this};
+  if (!busScheduler.submit(job)) return false;
+  jobActive = true;
+
+  recording.store(true, std::memory_order_release);
+  Serial.println("🎙️  REC: started");
+  return true;
+}
+
+void WavRecorder::stop() {
+  if (!jobActive) return;
+  recording.store(false, std::memory_order_release);
+  stopRequested = true;
+}
+
+uint32_t WavRecorder::droppedBlocks() const {
+  return queue ? queue->overrunCount() - overrunBase : 0;
+}
+
+void WavRecorder::push(const int16_t* pcm, int count) {
+  if (!recording.load(std::memory_order_acquire)) return;
+  WavBlock* b = queue->beginWrite();   // nullptr → overrun (считается)
+  if (!b) return;
+  if (count > (int)(sizeof(b->pcm) / sizeof(int16_t))) count = sizeof(b->pcm) / sizeof(int16_t);
+  b->count = count;
+  memcpy(b->pcm, pcm, count * sizeof(int16_t));
+  queue->commitWrite();
+}
+
+void WavRecorder::fillHeader(uint8_t* h) const {
+  memcpy(h, "RIFF", 4);
+  put32(h + 4, 36 + dataBytes);
+  memcpy(h + 8, "WAVEfmt ", 8);
+  put32(h + 16, 16);                 // Размер fmt
+  put16(h + 20, 1);                  // PCM
+  put16(h + 22, 1);                  // Моно
+  put32(h + 24, sampleRate);
+  put32(h + 28, sampleRate * 2);     // Байт в секунду
+  put16(h + 32, 2);                  // Байт на сэмпл
+  put16(h + 34, 16);                 // Бит на сэмпл
+  memcpy(h + 36, "data", 4);
+  put32(h + 40, dataBytes);
+}
+
+bool WavRecorder::openNext() {
+  if (!SD.exists(REC_DIR) && !SD.mkdir(REC_DIR)) {
+    Serial.println("❌ REC: failed to create /ZXrecordings");
+    return false;
+  }
+
+  // Следующий свободный номер (как у скриншотов)
+  int maxNum = 0;
+  File dir = SD.open(REC_DIR);
+  if (dir) {
+    File f = dir.openNextFile();
+    while (f) {
+      String name = f.name();
+      if (name.startsWith("rec_") && name.endsWith(".wav")) {
+        int num = name.substring(4, name.indexOf(".wav")).toInt();
+        if (num > maxNum) maxNum = num;
+      }
+      f.close();
+      f = dir.openNextFile();
+    }
+    dir.close();
+  }
+
+  snprintf(filePath, sizeof(filePath), "%s/rec_%03d.wav", REC_DIR, maxNum + 1);
+  file = SD.open(filePath, FILE_WRITE);
+  if (!file) {
+    Serial.printf("❌ REC: failed to create %s\n", filePath);
+    return false;
+  }
+  Serial.printf("🎙️  REC: writing %s\n", filePath);
+  return true;
+}
+
+void WavRecorder::drainQueue() {
+  // Забираем блоки, пока есть место (буфер = STAGE_BYTES + один блок)
+  while (staged <= STAGE_BYTES && queue->fill() > 0) {
+    const WavBlock* b = queue->beginRead();
+    if (!b) break;
+    size_t bytes = b->count * sizeof(int16_t);
+    memcpy(stage + staged, b->pcm, bytes);
+    staged += bytes;
+    dataBytes += bytes;
+    queue->endRead();
+  }
+}
+
+BusJobResult WavRecorder::step(void* ctx, size_t maxBytes, size_t* bytesDone) {
+  WavRecorder* r = (WavRecorder*)ctx;
+
+  // Первый шаг: каталог + файл; заголовок (пока с нулевыми размерами) -
+  // начало буфера, чтобы куски данных писались по выровненным смещениям
+  if (!r->file) {
+    if (!r->openNext()) return BUS_JOB_ERROR;
+    r->fillHeader(r->stage);
+    r->staged = WAV_HEADER_BYTES;
+    return BUS_JOB_MORE;
+  }
+
+  r->drainQueue();
+
+  // Финал: запись остановлена и очередь пуста → пишем всё, что осталось
+  bool final = r->stopRequested && r->queue->fill() == 0;
+  size_t n = final ? r->staged : (r->staged & ~(size_t)511);
+  if (!final && n < WRITE_MIN) return BUS_JOB_IDLE;
+  if (n > maxBytes) n = maxBytes;   // maxBytes кратен 512
+
+  if (n > 0) {
+    size_t written = r->file.write(r->stage, n);
+    *bytesDone = written;
+    if (written != n) {
+      Serial.printf("❌ REC: write failed (%u/%u)\n", (unsigned)written, (unsigned)n);
+      return BUS_JOB_ERROR;
+    }
+    memmove(r->stage, r->stage + n, r->staged - n);
+    r->staged -= n;
+  }
+
+  if (final && r->staged == 0) {
+    // Исправляем размеры RIFF/data в заголовке
+    uint8_t header[WAV_HEADER_BYTES];
+    r->fillHeader(header);
+    r->file.seek(0);
+    r->file.write(header, sizeof(header));
+    r->file.close();
+    return BUS_JOB_DONE;
+  }
+  return BUS_JOB_MORE;
+}
+
+void WavRecorder::done(void* ctx, bool ok) {
+  WavRecorder* r = (WavRecorder*)ctx;
+  r->recording.store(false, std::memory_order_release);
+  if (r->file) r->file.close();
+  r->jobActive = false;
+  Serial.printf("%s REC: %s, %u samples, %u dropped blocks\n", ok ? "✅" : "❌",
+                r->filePath[0] ? r->filePath : "(no file)",
+                r->samplesWritten(), r->droppedBlocks());
+  if (r->userDone) r->userDone(r->userCtx, ok);
+}
@@ -0,0 +1,86 @@
+#ifndef WAV_RECORDER_H
+#define WAV_RECORDER_H
+
+#include <Arduino.h>
+#include <SD.h>
+#include <atomic>
+#include "audio_ring.h"
+#include "beeper_synth.h"
+#include "../external_display/spi_bus_scheduler.h"
+
+// ═══════════════════════════════════════════════════════════
+// 🎙️ WAV RECORDER (V3.151): запись того, что играет Audio Task
+// ═══════════════════════════════════════════════════════════
+//
+// Audio Task после синтеза (beeper + EAR + AY, громкость уже применена)
+// отдаёт буфер в push() - копия в lock-free кольцо, без ожидания.
+// Кольцо полно (SD не успевает) → буфер отбрасывается и считается.
+//
+// Писатель - потоковая задача busScheduler (loop, окно простоя шины):
+// - копит PCM в буфере 8 KB, пишет кусками кратными 512 байт
+//   (заголовок WAV - часть первого куска, смещения файла выровнены)
+// - данных нет → BUS_JOB_IDLE (окно достаётся другим задачам)
+// - stop(): дописывает остаток, исправляет размеры в заголовке, close
+//
+// Файлы: /ZXrecordings/rec_001.wav ... (моно, 16 бит, 16 kHz)
+// ═══════════════════════════════════════════════════════════
+
+struct WavBlock {
+  uint16_t count;              // Сэмплов в блоке
+  int16_t pcm[BeeperSynth::MAX_OUT];  // Буфер Audio Task целиком (320 ± DRC)
+};
+
+class WavRecorder {
+public:
+  static const int QUEUE_BLOCKS = 16;        // 16 × 20 мс = 320 мс запаса
+  static const size_t STAGE_BYTES = 8192;    // Буфер писателя
+  static const size_t WRITE_MIN = 4096;      // Меньше - ждём накопления
+
+  WavRecorder();
+
+  // ═══ LOOP ═══
+  // Начать запись (false: SD занята прошлой записью / нет памяти / очередь шины)
+  bool start(uint32_t sampleRate);
+  // Остановить: остаток допишется в фоне, потом вызовется done
+  void stop();
+  inline bool isRecording() const { return recording.load(std::memory_order_relaxed); }
+  inline bool isBusy() const { return jobActive; }   // Запись или финализация
+
+  // По завершении файла: done(ctx, ok) из loop (через busScheduler)
+  void setDoneCallback(BusJobDoneFn fn, void* ctx) { userDone = fn; userCtx = ctx; }
+  const char* path() const { return filePath; }
+  uint32_t samplesWritten() const { return dataBytes / 2; }
+  uint32_t droppedBlocks() const;
+
+  // ═══ AUDIO TASK ═══
+  // Не блокирует: нет места в кольце → блок отброшен
+  void push(const int16_t* pcm, int count);
+
+private:
+  static BusJobResult step(void* ctx, size_t maxBytes, size_t* bytesDone);
+  static void done(void* ctx, bool ok);
+  bool openNext();
+  void fillHeader(uint8_t* h) const;
+  void drainQueue();
+
+  SPSCRing<WavBlock, QUEUE_BLOCKS>* queue;   // Выделяется при первом start()
+  uint8_t* stage;                            // STAGE_BYTES + запас на блок
+  size_t staged;
+
+  std::atomic<bool> recording;
+  bool stopRequested;
+  bool jobActive;
+  File file;
+  char filePath[40];
+  uint32_t sampleRate;
+  uint32_t dataBytes;          // PCM байт (без заголовка), включая ещё не записанные
+  uint32_t overrunBase;        // queue->overrunCount() на момент start()
+
+  BusJobDoneFn userDone;
+  void* userCtx;
+};
+
+// Глобальный рекордер (как busScheduler)
+extern WavRecorder wavRecorder;
+
+#endif // WAV_RECORDER_H
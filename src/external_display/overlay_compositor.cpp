@@ -0,0 +1,137 @@
+#include "overlay_compositor.h"
+
+// Global overlay compositor
+OverlayCompositor overlayCompositor;
+
+OverlayCompositor::OverlayCompositor() {
+  for (int i = 0; i < OVERLAY_LAYER_COUNT; i++) {
+    layers[i].style = {0, 0, 0, 0, TFT_WHITE, false, 1, 0, 0};
+  }
+}
+
+void OverlayCompositor::configure(OverlayLayer layer, const OverlayStyle& s) {
+  Layer& l = layers[layer];
+  if (memcmp(&l.style, &s, sizeof(OverlayStyle)) == 0) return;  // Ничего не изменилось
+
+  if (l.allocated && (l.style.w != s.w || l.style.h != s.h)) {
+    l.sprite.deleteSprite();
+    l.allocated = false;
+  }
+  l.style = s;
+  l.tileDirty = true;
+}
+
+bool OverlayCompositor::ensureTile(Layer& l) {
+  if (l.allocated) return true;
+  if (l.style.w <= 0 || l.style.h <= 0) return false;
+
+  // Маленькие тайлы держим во внутренней RAM (быстрый memcpy)
+  l.sprite.setPsram(false);
+  l.sprite.setColorDepth(16);
+  if (!l.sprite.createSprite(l.style.w, l.style.h)) {
+    Serial.printf("⚠️  Overlay: tile %dx%d allocation failed\n", l.style.w, l.style.h);
+    return false;
+  }
+  l.allocated = true;
+  l.tileDirty = true;
+  return true;
+}
+
+void OverlayCompositor::renderTile(Layer& l) {
+  const OverlayStyle& s = l.style;
+
+  // Непрозрачная чёрная плашка с рамкой (как раньше рисовали на дисплее)
+  l.sprite.fillScreen(BLACK);
+  l.sprite.drawRect(0, 0, s.w, s.h, s.borderColor);
+  if (s.doubleBorder) {
+    l.sprite.drawRect(1, 1, s.w - 2, s.h - 2, s.borderColor);
+  }
+  l.sprite.setTextSize(s.textSize);
+  l.sprite.setTextColor(l.textColor);
+
+  // V3.149: строки по '\n' - каждая со смещения textX
+  const int lineH = 8 * s.textSize + 2;
+  int y = s.textY;
+  const char* p = l.text;
+  while (true) {
+    const char* nl = strchr(p, '\n');
+    char line[sizeof(l.text)];
+    size_t len = nl ? (size_t)(nl - p) : strlen(p);
+    memcpy(line, p, len);
+    line[len] = '\0';
+    l.sprite.setCursor(s.textX, y);
+    l.sprite.print(line);
+    if (!nl) break;
+    p = nl + 1;
+    y += lineH;
+  }
+
+  l.tileDirty = false;
+}
+
+void OverlayCompositor::show(OverlayLayer layer, const char* text, uint16_t textColor) {
+  Layer& l = layers[layer];
+
+  if (!l.visible || l.textColor != textColor || strncmp(l.text, text, sizeof(l.text) - 1) != 0) {
+    strncpy(l.text, text, sizeof(l.text) - 1);
+    l.text[sizeof(l.text) - 1] = '\0';
+    l.textColor = textColor;
+    l.tileDirty = true;
+    l.visible = true;
+  }
+}
+
+void OverlayCompositor::hide(OverlayLayer layer) {
+  Layer& l = layers[layer];
+  l.visible = false;
+}
+
+void OverlayCompositor::compose(uint16_t* fb, int fbW, int fbH) {
+  for (int i = 0; i < OVERLAY_LAYER_COUNT; i++) {
+    Layer& l = layers[i];
+    l.composedH = 0;
+    if (!l.visible) continue;
+    if (!ensureTile(l)) continue;
+    if (l.tileDirty) renderTile(l);
+
+    const OverlayStyle& s = l.style;
+    const uint16_t* tile = (const uint16_t*)l.sprite.getBuffer();
+    if (!tile) continue;
+
+    // Клиппинг по frameBuffer
+    int x0 = s.x < 0 ? 0 : s.x;
+    int y0 = s.y < 0 ? 0 : s.y;
+    int x1 = (s.x + s.w > fbW) ? fbW : s.x + s.w;
+    int y1 = (s.y + s.h > fbH) ? fbH : s.y + s.h;
+    if (x0 >= x1 || y0 >= y1) continue;
+
+    // Спрайт хранит пиксели в том же порядке байт, что и frameBuffer
+    // (swap565) → простое копирование строк
+    size_t rowBytes = (x1 - x0) * sizeof(uint16_t);
+    for (int y = y0; y < y1; y++) {
+      memcpy(&fb[y * fbW + x0], &tile[(y - s.y) * s.w + (x0 - s.x)], rowBytes);
+    }
+    l.composedY = y0;
+    l.composedH = y1 - y0;
+  }
+}
+
+void OverlayCompositor::markDirtyRows(uint8_t* lineDirty, int fbH) const {
+  for (int i = 0; i < OVERLAY_LAYER_COUNT; i++) {
+    const Layer& l = layers[i];
+
+    // Прошлое положение: стираем (или обновляем) то, что было вписано
+    for (int y = l.composedY; y < l.composedY + l.composedH && y < fbH; y++) {
+      lineDirty[y] = 1;
+    }
+
+    // Текущее положение видимого слоя
+    if (l.visible) {
+      int y0 = l.style.y < 0 ? 0 : l.style.y;
+      int y1 = l.style.y + l.style.h;
+      for (int y = y0; y < y1 && y < fbH; y++) {
+        lineDirty[y] = 1;
+      }
+    }
+  }
+}
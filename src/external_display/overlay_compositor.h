@@ -0,0 +1,84 @@
+#ifndef OVERLAY_COMPOSITOR_H
+#define OVERLAY_COMPOSITOR_H
+
+#include <Arduino.h>
+#include "LGFX_ILI9488.h"
+
+// ═══════════════════════════════════════════════════════════
+// 🪟 OVERLAY COMPOSITOR (V3.138)
+// ═══════════════════════════════════════════════════════════
+//
+// Бейдж "PP"/zoom, уведомления и плашка PAUSE раньше рисовались
+// ПОСЛЕ pushImage отдельными fillRect/drawRect/print → несколько
+// SPI транзакций на кадр + мерцание текста.
+//
+// Теперь каждый элемент живёт в маленьком тайле (LGFX_Sprite):
+// - тайл перерисовывается ТОЛЬКО когда меняется его содержимое
+// - compose() копирует видимые тайлы в frameBuffer (memcpy по строкам)
+// - дисплей получает всё ОДНИМ pushImage
+//
+// Координаты слоёв - в системе frameBuffer (не дисплея!)
+// ═══════════════════════════════════════════════════════════
+
+enum OverlayLayer {
+  OVERLAY_BADGE = 0,       // "PP" / "x1.5" (правый верхний угол)
+  OVERLAY_NOTIFICATION,    // Асинхронные уведомления (Volume, Sound...)
+  OVERLAY_PAUSE,           // Плашка "PAUSE" по центру
+  OVERLAY_HUD,             // V3.142: Телеметрия кадра (нижняя строка)
+  OVERLAY_LAYER_COUNT
+};
+
+struct OverlayStyle {
+  int16_t x, y;            // Позиция в frameBuffer
+  int16_t w, h;            // Размер тайла
+  uint16_t borderColor;    // Цвет рамки
+  bool doubleBorder;       // Двойная рамка (как у PAUSE)
+  uint8_t textSize;        // Размер шрифта
+  int16_t textX, textY;    // Смещение текста внутри тайла
+};
+
+class OverlayCompositor {
+public:
+  OverlayCompositor();
+
+  // Настройка геометрии слоя (вызывать до первого show)
+  void configure(OverlayLayer layer, const OverlayStyle& style);
+
+  // Показать слой с текстом (тайл перерисуется только если текст/цвет изменились)
+  void show(OverlayLayer layer, const char* text, uint16_t textColor);
+
+  // Спрятать слой
+  void hide(OverlayLayer layer);
+
+  bool isVisible(OverlayLayer layer) const { return layers[layer].visible; }
+
+  // Вписать видимые слои в frameBuffer (fbW × fbH, RGB565 как у спрайта)
+  void compose(uint16_t* fb, int fbW, int fbH);
+
+  // V3.139: Пометить строки frameBuffer под слоями (видимыми сейчас или
+  // в прошлом compose) - их нужно перерисовать и отправить на дисплей
+  void markDirtyRows(uint8_t* lineDirty, int fbH) const;
+
+private:
+  struct Layer {
+    OverlayStyle style;
+    LGFX_Sprite sprite;
+    bool allocated = false;
+    bool visible = false;
+    bool tileDirty = true;   // Тайл нужно перерисовать
+    char text[96] = {0};     // V3.149: '\n' = новая строка (HUD в 2 строки)
+    uint16_t textColor = 0;
+    int16_t composedY = 0;   // Строки, занятые в прошлом compose()
+    int16_t composedH = 0;   // (0 = слой не был вписан)
+  };
+
+  bool ensureTile(Layer& l);
+  void renderTile(Layer& l);
+
+  Layer layers[OVERLAY_LAYER_COUNT];
+};
+
+// Глобальный композитор (как externalDisplay)
+extern OverlayCompositor overlayCompositor;
+
+#endif // OVERLAY_COMPOSITOR_H
@@ -0,0 +1,172 @@
+#include "spi_bus_scheduler.h"
+#include <SD.h>
+
+// Global SPI bus scheduler
+SPIBusScheduler busScheduler;
+
+SPIBusScheduler::SPIBusScheduler()
+  : jobHead(0), jobCount(0), bytesPerMs(300), displayStartUs(0), windowStartUs(0) {
+  memset(&stats, 0, sizeof(stats));
+}
+
+bool SPIBusScheduler::submit(const BusJob& job) {
+  if (jobCount >= MAX_JOBS) {
+    Serial.printf("⚠️  BUS: queue full, job '%s' rejected\n", job.name);
+    return false;
+  }
+  jobs[(jobHead + jobCount) % MAX_JOBS] = job;
+  jobCount++;
+  return true;
+}
+
+size_t SPIBusScheduler::chunkFor(int32_t remainingUs) const {
+  // Сколько байт успеем за оставшееся окно (по измеренной скорости)
+  size_t bytes = (size_t)remainingUs * bytesPerMs / 1000;
+  bytes &= ~(CHUNK_MIN - 1);  // Кратно сектору
+  if (bytes < CHUNK_MIN) return 0;
+  if (bytes > CHUNK_MAX) bytes = CHUNK_MAX;
+  return bytes;
+}
+
+void SPIBusScheduler::finishHead(bool ok) {
+  BusJob job = jobs[jobHead];
+  jobHead = (jobHead + 1) % MAX_JOBS;
+  jobCount--;
+  if (!ok) {
+    Serial.printf("❌ BUS: job '%s' failed\n", job.name);
+  }
+  if (job.done) job.done(job.ctx, ok);
+}
+
+bool SPIBusScheduler::runIdle(uint32_t deadlineUs) {
+  int idleStreak = 0;  // V3.151: подряд задач без работы
+  while (jobCount > 0 && idleStreak < jobCount) {
+    int32_t remaining = (int32_t)(deadlineUs - micros()) - (int32_t)SAFETY_US;
+    size_t maxBytes = remaining > 0 ? chunkFor(remaining) : 0;
+    if (maxBytes == 0) {
+      stats.deferred++;
+      break;  // Окно слишком короткое - продолжим в следующем кадре
+    }
+
+    BusJob& job = jobs[jobHead];
+    size_t bytesDone = 0;
+    uint32_t t0 = micros();
+    BusJobResult res = job.step(job.ctx, maxBytes, &bytesDone);
+    uint32_t dt = micros() - t0;
+
+    stats.sdUs += dt;
+    stats.sdBytes += bytesDone;
+    stats.chunks++;
+
+    // Обновляем оценку скорости (EMA 1/4) по полноценным кускам
+    if (bytesDone >= CHUNK_MIN && dt > 0) {
+      uint32_t measured = (uint32_t)((uint64_t)bytesDone * 1000 / dt);
+      if (measured < 50) measured = 50;  // Не даём оценке схлопнуться
+      bytesPerMs = (bytesPerMs * 3 + measured) / 4;
+    }
+
+    if (res == BUS_JOB_IDLE) {
+      // V3.151: в конец очереди - следующая задача получит окно
+      BusJob idle = jobs[jobHead];
+      jobHead = (jobHead + 1) % MAX_JOBS;
+      jobs[(jobHead + jobCount - 1) % MAX_JOBS] = idle;
+      stats.chunks--;  // Пустой шаг - не кусок
+      idleStreak++;
+      continue;
+    }
+    idleStreak = 0;
+
+    if (res != BUS_JOB_MORE) {
+      finishHead(res == BUS_JOB_DONE);
+    }
+  }
+  return jobCount > 0;
+}
+
+BusStats SPIBusScheduler::takeStats() {
+  uint32_t now = micros();
+  BusStats out = stats;
+  out.windowUs = now - windowStartUs;
+  out.pending = jobCount;
+  memset(&stats, 0, sizeof(stats));
+  windowStartUs = now;
+  return out;
+}
+
+// ═══════════════════════════════════════════════════════════
+// Встроенная задача: запись буфера в файл
+// ═══════════════════════════════════════════════════════════
+
+struct FileWriteJob {
+  char path[64];
+  const uint8_t* data;
+  size_t len;
+  size_t offset;
+  File file;
+  bool opened;
+  bool freeData;
+  BusJobDoneFn userDone;
+  void* userCtx;
+};
+
+static BusJobResult fileWriteStep(void* ctx, size_t maxBytes, size_t* bytesDone) {
+  FileWriteJob* j = (FileWriteJob*)ctx;
+
+  // Первый шаг: только открытие файла (FAT lookup тоже занимает шину)
+  if (!j->opened) {
+    j->file = SD.open(j->path, FILE_WRITE);
+    if (!j->file) {
+      Serial.printf("❌ BUS: failed to create %s\n", j->path);
+      return BUS_JOB_ERROR;
+    }
+    j->opened = true;
+    return BUS_JOB_MORE;
+  }
+
+  size_t toWrite = j->len - j->offset;
+  if (toWrite > maxBytes) toWrite = maxBytes;
+  size_t written = j->file.write(j->data + j->offset, toWrite);
+  *bytesDone = written;
+  if (written != toWrite) {
+    Serial.printf("❌ BUS: write failed at %u/%u (%s)\n", (unsigned)j->offset, (unsigned)j->len, j->path);
+    return BUS_JOB_ERROR;
+  }
+  j->offset += written;
+
+  if (j->offset >= j->len) {
+    j->file.close();
+    j->opened = false;
+    return BUS_JOB_DONE;
+  }
+  return BUS_JOB_MORE;
+}
+
+static void fileWriteDone(void* ctx, bool ok) {
+  FileWriteJob* j = (FileWriteJob*)ctx;
+  if (j->opened) j->file.close();
+  if (j->freeData) free((void*)j->data);
+  if (j->userDone) j->userDone(j->userCtx, ok);
+  delete j;
+}
+
+bool SPIBusScheduler::submitFileWrite(const char* path, const uint8_t* data, size_t len, bool freeData,
+                                      BusJobDoneFn done, void* doneCtx) {
+  FileWriteJob* j = new FileWriteJob();
+  strncpy(j->path, path, sizeof(j->path) - 1);
+  j->path[sizeof(j->path) - 1] = '\0';
+  j->data = data;
+  j->len = len;
+  j->offset = 0;
+  j->opened = false;
+  j->freeData = freeData;
+  j->userDone = done;
+  j->userCtx = doneCtx;
+
+  BusJob job = {"file-write", fileWriteStep, fileWriteDone, j};
+  if (!submit(job)) {
+    if (freeData) free((void*)data);
+    delete j;
+    return false;
+  }
+  return true;
+}
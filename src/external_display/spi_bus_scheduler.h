@@ -0,0 +1,108 @@
+#ifndef SPI_BUS_SCHEDULER_H
+#define SPI_BUS_SCHEDULER_H
+
+#include <Arduino.h>
+
+// ═══════════════════════════════════════════════════════════
+// 🚦 SPI BUS SCHEDULER (V3.140): SD-карта ↔ дисплей на SPI3_HOST
+// ═══════════════════════════════════════════════════════════
+//
+// Дисплей (bus_shared = true, use_lock = true) и SD-карта сидят на
+// одной шине. Любая SD операция посреди кадра = остановка эмуляции
+// или рендера (пропуск кадра, щелчок в звуке).
+//
+// Планировщик:
+// - ставит SD задачи в очередь (submit / submitFileWrite)
+// - выполняет их ТОЛЬКО в окне простоя между кадрами (runIdle)
+// - режет большие передачи на куски, которые влезают в окно
+//   (размер куска по измеренной скорости SD)
+// - считает занятость шины: дисплей / SD / простой
+//
+// Всё выполняется в loop() (один поток) → блокировок не нужно.
+//
+// V3.151: долгоживущие (потоковые) задачи возвращают BUS_JOB_IDLE,
+// когда данных нет - задача уходит в конец очереди и не держит окно.
+// ═══════════════════════════════════════════════════════════
+
+enum BusJobResult {
+  BUS_JOB_MORE = 0,   // Шаг выполнен, есть ещё работа
+  BUS_JOB_DONE,       // Задача завершена
+  BUS_JOB_ERROR,      // Ошибка - задача снимается
+  BUS_JOB_IDLE        // V3.151: Работы пока нет (потоковая задача) - в конец очереди
+};
+
+// Один шаг задачи: сделать НЕ БОЛЬШЕ maxBytes SD-ввода/вывода.
+// В *bytesDone вернуть сколько реально передано (для оценки скорости).
+typedef BusJobResult (*BusJobStepFn)(void* ctx, size_t maxBytes, size_t* bytesDone);
+
+// Вызывается один раз по завершении (ok = false при ошибке)
+typedef void (*BusJobDoneFn)(void* ctx, bool ok);
+
+struct BusJob {
+  const char* name;     // Для логов
+  BusJobStepFn step;
+  BusJobDoneFn done;    // Может быть nullptr
+  void* ctx;
+};
+
+// Статистика шины за окно (обычно 1 секунда)
+struct BusStats {
+  uint32_t windowUs;    // Длительность окна
+  uint32_t displayUs;   // Время pushImage
+  uint32_t sdUs;        // Время SD шагов
+  uint32_t sdBytes;     // Передано байт SD
+  uint32_t chunks;      // Выполнено шагов
+  uint32_t deferred;    // Раз окно было слишком коротким для шага
+  uint8_t pending;      // Задач в очереди
+};
+
+class SPIBusScheduler {
+public:
+  static const int MAX_JOBS = 8;
+  static const size_t CHUNK_MIN = 512;       // Сектор SD
+  static const size_t CHUNK_MAX = 16384;
+  static const uint32_t SAFETY_US = 1000;    // Запас до следующего кадра
+
+  SPIBusScheduler();
+
+  // Поставить задачу в очередь (false если очередь полна)
+  bool submit(const BusJob& job);
+
+  // Встроенная задача: записать буфер в файл кусками.
+  // freeData = true → буфер освобождается (free) после записи.
+  // done(doneCtx, ok) вызывается по завершении.
+  bool submitFileWrite(const char* path, const uint8_t* data, size_t len, bool freeData,
+                       BusJobDoneFn done = nullptr, void* doneCtx = nullptr);
+
+  // Обрамление передачи кадра на дисплей (учёт занятости шины)
+  inline void beginDisplay() { displayStartUs = micros(); }
+  inline void endDisplay() { stats.displayUs += micros() - displayStartUs; }
+
+  // Выполнять SD задачи пока до deadlineUs (micros()) остаётся время.
+  // Возвращает true если в очереди ещё есть работа.
+  bool runIdle(uint32_t deadlineUs);
+
+  inline bool busy() const { return jobCount > 0; }
+  inline int pending() const { return jobCount; }
+
+  // Снять статистику за прошедшее окно и начать новое
+  BusStats takeStats();
+
+private:
+  size_t chunkFor(int32_t remainingUs) const;
+  void finishHead(bool ok);
+
+  BusJob jobs[MAX_JOBS];
+  int jobHead;
+  int jobCount;
+
+  uint32_t bytesPerMs;      // Оценка скорости SD (EMA)
+  uint32_t displayStartUs;
+  uint32_t windowStartUs;
+  BusStats stats;
+};
+
+// Глобальный планировщик (как externalDisplay)
+extern SPIBusScheduler busScheduler;
+
+#endif // SPI_BUS_SCHEDULER_H
@@ -0,0 +1,96 @@
+#include "joystick_poller.h"
+
+// Global joystick poller
+JoystickPoller joystickPoller;
+
+static const uint32_t CENTER_PACKED = (127u << 8) | 127u;
+
+JoystickPoller::JoystickPoller()
+  : addr(JOYSTICK2_ADDR), present(false), busClock(0), packed(CENTER_PACKED), errors(0),
+    directions(0) {}
+
+uint8_t JoystickPoller::toDirections(const Joystick2Data& d) {
+  // Модуль стоит повёрнутым: обе оси ИНВЕРТИРОВАНЫ (как было в QAOP маппинге)
+  uint8_t bits = 0;
+  if (d.y < DEAD_LOW) bits |= KEMPSTON_DOWN;    // Физический UP → вниз в игре
+  if (d.y > DEAD_HIGH) bits |= KEMPSTON_UP;     // Физический DOWN → вверх
+  if (d.x < DEAD_LOW) bits |= KEMPSTON_RIGHT;   // Физический LEFT → вправо
+  if (d.x > DEAD_HIGH) bits |= KEMPSTON_LEFT;   // Физический RIGHT → влево
+  if (d.button) bits |= KEMPSTON_FIRE;
+  return bits;
+}
+
+bool JoystickPoller::readRegs(uint8_t reg, uint8_t* buf, int len) {
+  Wire.beginTransmission(addr);
+  Wire.write(reg);
+  if (Wire.endTransmission(false) != 0) return false;   // Repeated start
+  if (Wire.requestFrom((int)addr, len) != len) return false;
+  for (int i = 0; i < len; i++) buf[i] = Wire.read();
+  return true;
+}
+
+bool JoystickPoller::sample(Joystick2Data& out) {
+  uint8_t xy[2];
+  uint8_t btn;
+  // Burst: X (0x10) и Y (0x11) одной транзакцией
+  if (!readRegs(REG_ADC_X_8, xy, 2)) return false;
+  if (!readRegs(REG_BUTTON, &btn, 1)) return false;
+  out.x = xy[0];
+  out.y = xy[1];
+  out.button = (btn == 0) ? 1 : 0;  // ВНИМАНИЕ: 0 = нажата (инвертировано!)
+  return true;
+}
+
+bool JoystickPoller::begin(int sda, int scl, uint8_t address) {
+  addr = address;
+
+  // Сначала 400 kHz, не отвечает - 100 kHz (как было)
+  const uint32_t clocks[2] = {I2C_FAST, I2C_SLOW};
+  Joystick2Data first = {127, 127, 0};
+  for (int i = 0; i < 2 && !present; i++) {
+    if (i == 0) {
+      Wire.begin(sda, scl, clocks[i]);
+    } else {
+      Wire.setClock(clocks[i]);
+    }
+    Wire.setTimeOut(5);   // мс: зависшее устройство не держит задачу долго
+    delay(20);
+
+    Wire.beginTransmission(addr);
+    if (Wire.endTransmission() == 0 && sample(first)) {
+      present = true;
+      busClock = clocks[i];
+    }
+  }
+  if (!present) return false;
+
+  packed.store(first.x | (first.y << 8) | ((uint32_t)first.button << 16) | (1u << 24),
+               std::memory_order_release);
+  directions.store(toDirections(first), std::memory_order_release);
+
+  // Core 0: эмуляция (loop) и Audio Task живут на core 1
+  xTaskCreatePinnedToCore(taskEntry, "Task_Joystick", 3072, this, 1, nullptr, 0);
+  return true;
+}
+
+void JoystickPoller::taskEntry(void* pv) {
+  JoystickPoller* self = (JoystickPoller*)pv;
+  TickType_t wake = xTaskGetTickCount();
+
+  while (true) {
+    Joystick2Data d;
+    if (self->sample(d)) {
+      uint32_t prev = self->packed.load(std::memory_order_relaxed);
+      uint32_t value = d.x | (d.y << 8) | ((uint32_t)d.button << 16);
+      if ((prev & 0x00FFFFFF) != value) {
+        // Новое значение + следующий seq одной записью
+        uint32_t seq = ((prev >> 24) + 1) & 0xFF;
+        self->packed.store(value | (seq << 24), std::memory_order_release);
+        self->directions.store(toDirections(d), std::memory_order_release);
+      }
+    } else {
+      self->errors.fetch_add(1, std::memory_order_relaxed);
+    }
+    vTaskDelayUntil(&wake, pdMS_TO_TICKS(PERIOD_MS));
+  }
+}
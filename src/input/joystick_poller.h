@@ -0,0 +1,113 @@
+#ifndef JOYSTICK_POLLER_H
+#define JOYSTICK_POLLER_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <atomic>
+
+// ═══════════════════════════════════════════════════════════
+// 🕹️ JOYSTICK POLLER (V3.152): Joystick2Unit в фоновой задаче
+// ═══════════════════════════════════════════════════════════
+//
+// Раньше readJoystick2() делал 3 блокирующие I2C транзакции @100 kHz
+// (X, Y, кнопка) прямо в loop() каждый кадр - сотни мкс на кадр.
+//
+// Теперь:
+// - задача на core 0 (эмуляция и звук - core 1), приоритет 1, 100 Гц
+// - X и Y одним burst чтением (регистры 0x10-0x11), кнопка - вторым;
+//   шина 400 kHz (если устройство не отвечает - откат на 100 kHz)
+// - состояние публикуется ОДНИМ atomic словом: seq | btn | y | x
+//   (seq растёт при каждом изменении → читатель видит события)
+// - эмулятор читает только кэш: одна атомарная загрузка, без I2C
+//
+// V3.154: + готовый байт направлений в раскладке Kempston (порт 0x1F) -
+// ZXSpectrum::z80_in читает его напрямую (Kempston / Sinclair / Cursor / QAOP)
+// ═══════════════════════════════════════════════════════════
+
+#define JOYSTICK2_ADDR  0x63
+#define JOYSTICK2_SDA   2
+#define JOYSTICK2_SCL   1
+
+// Регистры Joystick2Unit (из официальной документации)
+#define REG_ADC_X_8   0x10  // X ADC 8-bit (0-255), следом Y (0x11)
+#define REG_ADC_Y_8   0x11  // Y ADC 8-bit (0-255)
+#define REG_BUTTON    0x20  // Button (1=no press, 0=press)
+
+// V3.154: Биты байта направлений (раскладка порта Kempston, 1 = нажато)
+#define KEMPSTON_RIGHT  0x01
+#define KEMPSTON_LEFT   0x02
+#define KEMPSTON_DOWN   0x04
+#define KEMPSTON_UP     0x08
+#define KEMPSTON_FIRE   0x10
+
+struct Joystick2Data {
+  uint8_t x;       // 0-255 (центр: ~127)
+  uint8_t y;       // 0-255 (центр: ~127)
+  uint8_t button;  // 0 = отпущена, 1 = нажата
+};
+
+class JoystickPoller {
+public:
+  static const uint32_t PERIOD_MS = 10;      // 100 Гц = 2 выборки на кадр
+  static const uint32_t I2C_FAST = 400000;
+  static const uint32_t I2C_SLOW = 100000;
+  static const uint8_t DEAD_LOW = 100;       // Мёртвая зона стика (как в updateJoystickKeys)
+  static const uint8_t DEAD_HIGH = 155;
+
+  JoystickPoller();
+
+  // Инициализация шины, поиск устройства, запуск задачи.
+  // false - джойстика нет (задача не запускается)
+  bool begin(int sda, int scl, uint8_t addr);
+
+  inline bool available() const { return present; }
+
+  // Последнее состояние (центр, если джойстика нет)
+  inline Joystick2Data state() const {
+    return unpack(packed.load(std::memory_order_acquire));
+  }
+
+  // Событие: состояние изменилось с lastSeq → true, out + lastSeq обновлены
+  inline bool changed(uint8_t& lastSeq, Joystick2Data& out) const {
+    uint32_t p = packed.load(std::memory_order_acquire);
+    uint8_t seq = p >> 24;
+    if (seq == lastSeq) return false;
+    lastSeq = seq;
+    out = unpack(p);
+    return true;
+  }
+
+  // V3.154: Байт направлений (KEMPSTON_*), обновляется задачей вместе с packed
+  inline const std::atomic<uint8_t>* directionByte() const { return &directions; }
+
+  // Оси/кнопка → KEMPSTON_* (мёртвая зона, ориентация модуля на Cardputer)
+  static uint8_t toDirections(const Joystick2Data& d);
+
+  uint32_t busHz() const { return busClock; }
+  uint32_t errorCount() const { return errors.load(std::memory_order_relaxed); }
+
+private:
+  static void taskEntry(void* pv);
+  bool sample(Joystick2Data& out);
+  bool readRegs(uint8_t reg, uint8_t* buf, int len);
+
+  static inline Joystick2Data unpack(uint32_t p) {
+    Joystick2Data d;
+    d.x = p & 0xFF;
+    d.y = (p >> 8) & 0xFF;
+    d.button = (p >> 16) & 0x01;
+    return d;
+  }
+
+  uint8_t addr;
+  bool present;
+  uint32_t busClock;
+  std::atomic<uint32_t> packed;    // seq<<24 | button<<16 | y<<8 | x
+  std::atomic<uint32_t> errors;    // Неудачные выборки
+  std::atomic<uint8_t> directions; // V3.154: KEMPSTON_* (0 = центр)
+};
+
+// Глобальный опросчик (как busScheduler)
+extern JoystickPoller joystickPoller;
+
+#endif // JOYSTICK_POLLER_H
@@ -0,0 +1,96 @@
+#include "keymap.h"
+
+// Global keymap
+KeyMap keymap;
+
+static const char* const PROFILE_NAMES[KEYMAP_PROFILE_COUNT] = {
+  "QAOP", "CURSOR", "TYPING"
+};
+
+KeyMap::KeyMap() : scans(0), matrixScan(0) {
+  setProfile(KEYMAP_QAOP);
+}
+
+KeyMap::Chord KeyMap::chord(SpecKeys a, SpecKeys b) {
+  Chord c = {0, 0xFF, 0, 0xFF};
+  if (a > SPECKEY_NONE && a < SPECKEY_MAX_NORMAL) {
+    c.row0 = key2specy[0][a];
+    c.mask0 = key2specy[1][a];
+  }
+  if (b > SPECKEY_NONE && b < SPECKEY_MAX_NORMAL) {
+    c.row1 = key2specy[0][b];
+    c.mask1 = key2specy[1][b];
+  }
+  return c;
+}
+
+void KeyMap::setProfile(KeymapProfile profile) {
+  if (profile < 0 || profile >= KEYMAP_PROFILE_COUNT) profile = KEYMAP_QAOP;
+  current = profile;
+
+  const Chord none = {0, 0xFF, 0, 0xFF};
+  for (int i = 0; i < 128; i++) chars[i] = none;
+
+  // Буквы, цифры, символы - из общей таблицы (keyboard_defs.h)
+  for (const auto& entry : letterToSpecKeys) {
+    uint8_t c = (uint8_t)entry.first;
+    if (c >= 128) continue;
+    const std::vector<SpecKeys>& keys = entry.second;
+    chars[c] = chord(keys.size() > 0 ? keys[0] : SPECKEY_NONE,
+                     keys.size() > 1 ? keys[1] : SPECKEY_NONE);
+  }
+
+  // Стрелки Cardputer (; . , /) - по профилю
+  switch (current) {
+    case KEYMAP_QAOP:
+      chars[(uint8_t)';'] = chord(SPECKEY_Q);
+      chars[(uint8_t)'.'] = chord(SPECKEY_A);
+      chars[(uint8_t)','] = chord(SPECKEY_O);
+      chars[(uint8_t)'/'] = chord(SPECKEY_P);
+      break;
+    case KEYMAP_CURSOR:
+      chars[(uint8_t)';'] = chord(SPECKEY_SHIFT, SPECKEY_7);
+      chars[(uint8_t)'.'] = chord(SPECKEY_SHIFT, SPECKEY_6);
+      chars[(uint8_t)','] = chord(SPECKEY_SHIFT, SPECKEY_5);
+      chars[(uint8_t)'/'] = chord(SPECKEY_SHIFT, SPECKEY_8);
+      break;
+    default:
+      break;  // TYPING: символы как в letterToSpecKeys
+  }
+
+  // Модификаторы и служебные клавиши - одинаковы во всех профилях
+  enterChord = chord(SPECKEY_ENTER);
+  spaceChord = chord(SPECKEY_SPACE);
+  shiftChord = chord(SPECKEY_SHIFT);              // SHIFT → CAPS SHIFT
+  fnChord = chord(SPECKEY_SYMB);                  // Fn → SYMBOL SHIFT
+  delChord = chord(SPECKEY_SHIFT, SPECKEY_0);     // BACKSPACE → DELETE
+}
+
+void KeyMap::nextProfile() {
+  setProfile((KeymapProfile)((current + 1) % KEYMAP_PROFILE_COUNT));
+}
+
+const char* KeyMap::profileName() const {
+  return PROFILE_NAMES[current];
+}
+
+bool KeyMap::rebuildDue(bool changed) {
+  bool due = changed || matrixScan != scans - 1;
+  matrixScan = scans;
+  return due;
+}
+
+void KeyMap::build(const Keyboard_Class::KeysState& status, uint8_t rows[8]) const {
+  memset(rows, 0xFF, 8);
+
+  if (status.enter) press(enterChord, rows);
+  if (status.space) press(spaceChord, rows);
+  if (status.shift) press(shiftChord, rows);
+  if (status.fn) press(fnChord, rows);
+  if (status.del) press(delChord, rows);
+
+  for (char c : status.word) {
+    uint8_t u = (uint8_t)c;
+    if (u < 128) press(chars[u], rows);
+  }
+}
@@ -0,0 +1,75 @@
+#ifndef KEYMAP_H
+#define KEYMAP_H
+
+#include <M5Cardputer.h>
+#include "../spectrum/spectrum_mini.h"
+
+// ═══════════════════════════════════════════════════════════
+// ⌨️ KEYMAP (V3.153): скомпилированная раскладка Cardputer → ZX
+// ═══════════════════════════════════════════════════════════
+//
+// Раньше handleKeyboard() каждый кадр: сброс 8 строк speckey, цепочки
+// if (status.xxx), поиск в unordered_map на каждый символ и updateKey()
+// по одной клавише прямо в живую матрицу.
+//
+// Теперь:
+// - setProfile() один раз компилирует плоскую таблицу
+//   символ (0..127) → до двух пар {строка, AND-маска}
+// - build() строит СЛЕДУЮЩЕЕ состояние rows[8] за один проход
+//   (вызывать только когда клавиатура изменилась - см. rebuildDue())
+// - матрицу эмулятора публикует вызывающий: speckey = клавиатура & джойстик
+//
+// Профили отличаются клавишами ; . , / (стрелки на клавиатуре Cardputer).
+// ═══════════════════════════════════════════════════════════
+
+enum KeymapProfile {
+  KEYMAP_QAOP = 0,     // ; . , / → Q A O P (по умолчанию, как раньше)
+  KEYMAP_CURSOR,       // ; . , / → CAPS+7 6 5 8 (курсорные клавиши Spectrum)
+  KEYMAP_TYPING,       // ; . , / → свои символы через SYMBOL SHIFT (набор BASIC)
+  KEYMAP_PROFILE_COUNT
+};
+
+class KeyMap {
+public:
+  KeyMap();
+
+  // Переключить профиль (перекомпиляция таблицы, вне горячего пути)
+  void setProfile(KeymapProfile profile);
+  void nextProfile();
+  inline KeymapProfile profile() const { return current; }
+  const char* profileName() const;
+
+  // Состояние клавиатуры → rows[8] (1 = отпущена). Без аллокаций.
+  void build(const Keyboard_Class::KeysState& status, uint8_t rows[8]) const;
+
+  // Перестройка только по изменению: beginScan() - в начале каждого опроса
+  // клавиатуры, rebuildDue() - когда опрос дошёл до матрицы ZX. true, если
+  // клавиатура изменилась или прошлый опрос до матрицы не дошёл (меню, Opt,
+  // хоткей - строки тогда сброшены)
+  inline void beginScan() { scans++; }
+  bool rebuildDue(bool changed);
+
+private:
+  // Аккорд: до двух клавиш ZX; mask = AND-маска строки (0xFF = ничего)
+  struct Chord {
+    uint8_t row0, mask0;
+    uint8_t row1, mask1;
+  };
+
+  static Chord chord(SpecKeys a, SpecKeys b = SPECKEY_NONE);
+  static inline void press(const Chord& c, uint8_t rows[8]) {
+    rows[c.row0] &= c.mask0;
+    rows[c.row1] &= c.mask1;
+  }
+
+  KeymapProfile current;
+  uint32_t scans;          // Опросов клавиатуры
+  uint32_t matrixScan;     // Последний опрос, дошедший до матрицы
+  Chord chars[128];
+  Chord enterChord, spaceChord, shiftChord, fnChord, delChord;
+};
+
+// Глобальная раскладка
+extern KeyMap keymap;
+
+#endif // KEYMAP_H
@@ -9,6 +9,24 @@
 #include "spectrum/tap_loader.h"  // ✅ TAP Loader!
 #include "spectrum/z80_loader.h"  // ✅ Z80 Loader! (V3.134)
 #include "external_display/LGFX_ILI9488.h"  // ✅ External display support
+#include "external_display/overlay_compositor.h"  // ✅ V3.138: Overlay compositor
+#include "spectrum/zx_screen.h"  // ✅ V3.139: Attribute LUT + FLASH + dirty cells
+#include "spectrum/zx_pixel_kernel.h"  // ✅ V3.141: 8 pixels per store expansion
+#include "external_display/spi_bus_scheduler.h"  // ✅ V3.140: SD/display bus scheduler
+#include "telemetry/frame_telemetry.h"  // ✅ V3.142: Frame-time breakdown
+#include "audio/beeper_synth.h"  // ✅ V3.144: Edge-timestamped band-limited beeper
+#include "audio/audio_ring.h"  // ✅ V3.145: Lock-free SPSC audio frame ring
+#include "audio/beeper.h"  // ✅ V3.147: I2S DMA streaming backend (-DI2S_SPEAKER_ENABLED)
+#include "audio/ay_chip.h"  // ✅ V3.148: AY-3-8912 PSG (fixed-point synthesis)
+#include "audio/audio_stats.h"  // ✅ V3.149: Audio latency / underrun counters
+#include "audio/wav_recorder.h"  // ✅ V3.151: WAV capture to /ZXrecordings/
+#include "input/joystick_poller.h"  // ✅ V3.152: Background I2C joystick sampling
+#include "input/keymap.h"  // ✅ V3.153: Compiled keymap with runtime profiles
+#include "telemetry/input_latency.h"  // ✅ V3.155: Keypress → pixel latency probe
+#include "spectrum/machine_snapshot.h"  // ✅ V3.157: Fast boot from ready-ROM snapshot
+#include "spectrum/input_replay.h"  // ✅ V3.159: Deterministic input recording/replay
+#include "spectrum/save_states.h"  // ✅ V3.160: Save-state slots with background SD writes
+#include "spectrum/rewind_buffer.h"  // ✅ V3.161: Rewind (last seconds of play in PSRAM)
 
 // ============================================
 // ШАГ 3: Эмулятор С ДИСПЛЕЕМ + ЦВЕТА!
@@ -18,9 +36,13 @@
 // FORWARD DECLARATIONS (V3.134)
 // ═══════════════════════════════════════════
 void Task_Audio(void* pv);
-void ZX_BeeperSubmitFrame(const uint16_t* accum312);
+void ZX_SubmitAudioFrame(ZXSpectrum* spec, uint32_t frameLen);
+void ZX_BeeperSubmitEdges(const uint32_t* edges, int count, uint8_t startLevel, uint32_t frameLen,
+                          const AYWrite* ayWrites = nullptr, int ayCount = 0,
+                          const uint8_t* ayResyncRegs = nullptr);
 void showNotification(const char* text, uint16_t color, unsigned long duration);
-void drawNotificationOverlay();
+void updateOverlays();
+void setupOverlays();
 
 // ═══════════════════════════════════════════
 // SD CARD CONFIGURATION
@@ -36,20 +58,7 @@ SPIClass sdSPI(HSPI);
 // ═══════════════════════════════════════════
 // JOYSTICK2 CONFIGURATION
 // ═══════════════════════════════════════════
-#define JOYSTICK2_ADDR  0x63
-#define JOYSTICK2_SDA   2
-#define JOYSTICK2_SCL   1
-
-// Регистры Joystick2Unit (из официальной документации)
-#define REG_ADC_X_8   0x10  // X ADC 8-bit (0-255)
-#define REG_ADC_Y_8   0x11  // Y ADC 8-bit (0-255)
-#define REG_BUTTON    0x20  // Button (1=no press, 0=press)
-
-struct Joystick2Data {
-  uint8_t x;       // 0-255 (центр: ~127)
-  uint8_t y;       // 0-255 (центр: ~127)
-  uint8_t button;  // 0 = отпущена, 1 = нажата
-};
+// V3.152: адрес/пины/регистры и опрос - input/joystick_poller.h
 
 bool joystick2Available = false;
 
@@ -67,6 +76,78 @@ const unsigned long ENTER_BUTTON_DEBOUNCE = 500; // Строгий debounce 500m
 // JOYSTICK-TO-KEYS STATE
 // ═══════════════════════════════════════════
 bool joystickEnabled = true;  // Включен ли джойстик для игр (toggle Opt+J)
+
+// ═══ V3.153: МАТРИЦА ZX ═══
+// Клавиатура строит свои 8 строк, в speckey они попадают одной
+// публикацией (publishKeyMatrix) перед кадром эмуляции.
+// V3.154: джойстик в матрицу больше не пишет (порты, см. updateJoystickRouting)
+static uint8_t keyboardRows[8] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+// ═══ V3.155: ЗАХВАТ ВВОДА ПОСРЕДИ КАДРА + ПРОБА ЗАДЕРЖКИ ═══
+// Строка эмулируемого кадра (0-311), на которой клавиатура и джойстик
+// читаются заново (INT - после строки 311). -1 = только перед кадром.
+#ifndef INPUT_LATCH_LINE
+#define INPUT_LATCH_LINE 296
+#endif
+static InputLatencyProbe inputLatency;
+static InputLatencyWindow inputLatencyWindow;
+static uint32_t emuFrameNo = 0;          // Эмулированные кадры с запуска
+static bool inputLatchArmed = false;     // Только кадры loop() (TAP loader нажимает клавиши сам)
+static bool screenPixelsChanged = false; // VRAM изменилась в последнем renderScreen
+static uint8_t lastJoystickBits = 0;
+static void latchInputMidFrame(void* ctx);
+
+// ═══ V3.159: ЗАПИСЬ/ПОВТОР ВВОДА (Opt+E / Opt+Y) ═══
+// Файлы: /ZXreplays/inp_NNN.zxr (снимок + ввод по кадрам)
+static InputReplay inputReplay;
+static char replayPath[40] = "";          // Последняя записанная/проигранная
+static bool replayWriteBusy = false;      // Запись файла ещё в очереди шины
+static uint32_t replayStartUs = 0;        // Повтор как бенчмарк: время прогона
+
+// ═══ V3.160: СЛОТЫ СОХРАНЕНИЯ (Opt+S / Opt+L, слот Opt+1..4) ═══
+static SaveStates saveStates;
+static int saveSlot = 0;
+
+// ═══ V3.161: ПЕРЕМОТКА (Opt+B) ═══
+// Точка каждые 5 кадров в кольце PSRAM; одно нажатие - секунда назад
+static RewindBuffer rewindBuffer;
+static const int REWIND_STEP_POINTS = RewindBuffer::FRAMES_PER_SECOND / RewindBuffer::CAPTURE_EVERY;
+
+// ═══ V3.157: БЫСТРЫЙ СТАРТ ═══
+// ROM загружается без экрана, пока висит splash; состояние в точке
+// готовности - в PSRAM. Сброс и TAP загрузка восстанавливают его.
+static MachineSnapshot bootSnapshot;
+static const int BOOT_MAX_FRAMES = 300;   // 6 с эмуляции - ROM готова за ~80
+static int bootFrames = 0;
+
+// ═══ V3.158: TURBO (FAST-FORWARD, Opt+F) ═══
+// Кадры подряд без темпа звука; экран - по настенным часам (10 Гц),
+// звук выключен (кадры фронтов не отправляются). Бейдж: "FF x3.4".
+static const uint32_t TURBO_RENDER_MS = 100;
+static bool turboMode = false;
+static uint32_t turboLastRenderMs = 0;
+static uint32_t turboSpeedX10 = 0;        // Эмулированных кадров/с ÷ 5 (0 = ещё не замерено)
+
+// Пора рисовать кадр в turbo (не чаще TURBO_RENDER_MS)
+static bool turboRenderDue() {
+  uint32_t now = millis();
+  if (now - turboLastRenderMs < TURBO_RENDER_MS) return false;
+  turboLastRenderMs = now;
+  return true;
+}
+
+// Клавиатура → keyboardRows; новое нажатие запускает пробу задержки
+static void buildKeyboardRows(const Keyboard_Class::KeysState& status) {
+  uint8_t next[8];
+  keymap.build(status, next);
+  for (int i = 0; i < 8; i++) {
+    if (keyboardRows[i] & ~next[i]) {  // Бит 1 → 0 = клавиша нажата
+      inputLatency.noteInput(micros(), emuFrameNo);
+      break;
+    }
+  }
+  memcpy(keyboardRows, next, sizeof(keyboardRows));
+}
 // Джойстик мапится на клавиши QAOP + Space (ИНВЕРТИРОВАНО):
 // Физический UP → A, DOWN → Q, LEFT → P, RIGHT → O, FIRE → Space
 
@@ -78,20 +159,39 @@ int soundVolume = 5;         // Громкость 0-10 (было 3, верну
 
 // ═══ АУДИО ПАРАМЕТРЫ (от ChatGPT) ═══
 static constexpr int SAMPLE_RATE   = 16000;   // 16 kHz I2S
-static constexpr int SPPF          = 320;     // samples per frame @50fps = 20ms
-static constexpr int TSTATES_LINE_CONST = 224; // тактов/строку
-static constexpr int AMP           = 9000;    // амплитуда (без клиппинга)
-static constexpr int ENV_NS        = 48;      // ~3ms огибающая
+static constexpr int SPPF          = BeeperSynth::SPPF; // samples per frame @50fps = 20ms
+static constexpr int TAPE_GAIN_Q8  = 160;     // V3.150: лента тише beeper (~0.6, как было "-2 уровня")
 
 // ═══ ДВОЙНОЙ БУФЕР (моно 16-бит) ═══
-static int16_t bufA[SPPF];
-static int16_t bufB[SPPF];
+static int16_t bufA[BeeperSynth::MAX_OUT];   // V3.146: SPPF ± DRC поправка
+static int16_t bufB[BeeperSynth::MAX_OUT];
 static volatile bool useA = true;
 
 // ═══ ВХОДНЫЕ ДАННЫЕ от эмулятора ═══
-static uint16_t accumBuffer[312];             // RAW accumulator от эмулятора
-static volatile uint16_t accumFrame[312];     // Копия для Audio Task
-static volatile bool frameReady = false;
+// V3.144: t-states фронтов beeper → BLEP синтез
+// V3.150: + фронты EAR при загрузке с ленты (тот же лог, тот же синтез)
+// V3.145: lock-free кольцо на 4 кадра (80 мс) вместо одного слота
+static_assert(AUDIO_MAX_EDGES == ZXSpectrum::MAX_BEEPER_EDGES, "edge buffer size mismatch");
+static SPSCRing<AudioFrame, 4> audioRing;
+static BeeperSynth beeperSynth;               // Только Audio Task
+static AYChip ayChip;                         // V3.148: AY-3-8912, только Audio Task
+static AudioStats audioStats;                 // V3.149: счётчики потока (пишет Audio Task)
+static AudioStatsWindow audioWindow = {};     // V3.149: последнее окно (1 с) для HUD/Serial
+
+// ═══ V3.146: ТЕМП ЭМУЛЯЦИИ = ЧАСЫ ЗВУКА ═══
+// loop() не спит по micros(), а ждёт уведомления от Audio Task
+// "слот освободился", пока в кольце AUDIO_TARGET_FILL кадров.
+// Audio Task держит заполнение у цели DRC-поправкой длины кадра
+// (±1-2 сэмпла из 320 = ±0.6% высоты тона - на слух незаметно).
+static constexpr int AUDIO_TARGET_FILL = 2;   // Кадров в кольце (~40 мс)
+static constexpr int AUDIO_DRC_MAX = 2;       // Макс. поправка, сэмплов/кадр
+static TaskHandle_t emuTaskHandle = nullptr;  // loop() task - ждёт уведомлений
+
+// ═══ V3.147: BACKEND ВЫВОДА ═══
+// -DI2S_SPEAKER_ENABLED → собственный I2S DMA поток (beeper.h)
+// иначе (или если I2S не поднялся) → M5Cardputer.Speaker.playRaw
+static Beeper i2sBeeper;
+static bool audioUseI2S = false;
 
 // ═══════════════════════════════════════════
 // NOTIFICATION SYSTEM (async overlay)
@@ -326,46 +426,9 @@ void initSDCard() {
 // JOYSTICK2 FUNCTIONS
 // ═══════════════════════════════════════════
 
+// V3.152: I2C читает фоновая задача (core 0) - здесь только кэш
 Joystick2Data readJoystick2() {
-  Joystick2Data data = {127, 127, 0};  // Центр по умолчанию
-  
-  if (!joystick2Available) {
-    return data;
-  }
-  
-  // Читаем X (регистр 0x10)
-  Wire.beginTransmission(JOYSTICK2_ADDR);
-  Wire.write(REG_ADC_X_8);
-  if (Wire.endTransmission(false) == 0) {
-    Wire.requestFrom(JOYSTICK2_ADDR, 1);
-    if (Wire.available() >= 1) {
-      data.x = Wire.read();
-    }
-  }
-  
-  // Читаем Y (регистр 0x11)
-  Wire.beginTransmission(JOYSTICK2_ADDR);
-  Wire.write(REG_ADC_Y_8);
-  if (Wire.endTransmission(false) == 0) {
-    Wire.requestFrom(JOYSTICK2_ADDR, 1);
-    if (Wire.available() >= 1) {
-      data.y = Wire.read();
-    }
-  }
-  
-  // Читаем кнопку (регистр 0x20)
-  // ВНИМАНИЕ: 0 = нажата, 1 = не нажата (инвертировано!)
-  Wire.beginTransmission(JOYSTICK2_ADDR);
-  Wire.write(REG_BUTTON);
-  if (Wire.endTransmission(false) == 0) {
-    Wire.requestFrom(JOYSTICK2_ADDR, 1);
-    if (Wire.available() >= 1) {
-      uint8_t rawButton = Wire.read();
-      data.button = (rawButton == 0) ? 1 : 0;  // Инвертируем
-    }
-  }
-  
-  return data;
+  return joystickPoller.state();  // Центр, если джойстика нет
 }
 
 void initJoystick2() {
@@ -375,14 +438,11 @@ void initJoystick2() {
   Serial.printf("  I2C: SDA=G%d, SCL=G%d\n", JOYSTICK2_SDA, JOYSTICK2_SCL);
   Serial.printf("  Address: 0x%02X\n", JOYSTICK2_ADDR);
   
-  // Инициализация I2C
-  Wire.begin(JOYSTICK2_SDA, JOYSTICK2_SCL, 100000);  // 100 kHz
-  delay(100);
-  
-  // Проверяем наличие Joystick2
-  Wire.beginTransmission(JOYSTICK2_ADDR);
-  if (Wire.endTransmission() == 0) {
-    Serial.printf("✅ Joystick2 detected at 0x%02X!\n", JOYSTICK2_ADDR);
+  // V3.152: I2C (400 kHz, откат на 100 kHz) + фоновая задача опроса на core 0
+  if (joystickPoller.begin(JOYSTICK2_SDA, JOYSTICK2_SCL, JOYSTICK2_ADDR)) {
+    Serial.printf("✅ Joystick2 detected at 0x%02X! (I2C %u kHz, polling %u Hz on core 0)\n",
+                  JOYSTICK2_ADDR, joystickPoller.busHz() / 1000,
+                  1000 / JoystickPoller::PERIOD_MS);
     joystick2Available = true;
     
     // Тестовое чтение
@@ -565,7 +625,12 @@ bool loadTAPFile(String filename) {
   TAPLoader tapLoader;
   // Передаём renderScreen для построчного loading screen! 🎨
   // V3.137: Загружаем из /ZXgames/
-  bool success = tapLoader.loadTAP(("/ZXgames/" + filename).c_str(), spectrum, renderScreen);
+  // V3.158: в turbo загрузка упирается не в рендер каждые 32 байта, а в эмуляцию
+  RenderCallback render = renderScreen;
+  if (turboMode) {
+    render = []() { if (turboRenderDue()) renderScreen(); };
+  }
+  bool success = tapLoader.loadTAP(("/ZXgames/" + filename).c_str(), spectrum, render);
   
   if (success) {
     Serial.println("\n═══════════════════════════════════════════");
@@ -1191,6 +1256,27 @@ void drawFileBrowser() {
   }
 }
 
+// V3.157: Прогнать до maxFrames кадров загрузки ROM. true - снимок готов (или загрузка закончена без него)
+static bool advanceHeadlessBoot(int maxFrames) {
+  if (bootSnapshot.valid() || bootFrames >= BOOT_MAX_FRAMES) return true;
+  for (int i = 0; i < maxFrames && bootFrames < BOOT_MAX_FRAMES; i++) {
+    spectrum->runForFrame();
+    bootFrames++;
+    if (spectrum->romReady()) {
+      if (bootSnapshot.capture(spectrum)) {
+        spectrum->readySnapshot = &bootSnapshot;
+        Serial.printf("📸 Boot snapshot captured at frame %d (PC=0x%04X)\n", bootFrames, spectrum->z80Regs->PC.W);
+      }
+      return true;
+    }
+  }
+  if (bootFrames >= BOOT_MAX_FRAMES) {
+    Serial.println("⚠️  Boot snapshot: ROM ready not seen, using cold reset");
+    return true;
+  }
+  return false;
+}
+
 void setup() {
   Serial.begin(115200);
   delay(500);
@@ -1216,8 +1302,14 @@ void setup() {
   M5Cardputer.Mic.end();
   
   // ✅ ИНИЦИАЛИЗАЦИЯ SPEAKER (ChatGPT beeper!)
-  M5Cardputer.Speaker.begin();
-  M5Cardputer.Speaker.setVolume(192);  // 0-255
+  // V3.147: с -DI2S_SPEAKER_ENABLED - свой I2S DMA поток вместо M5 Speaker
+#ifdef I2S_SPEAKER_ENABLED
+  audioUseI2S = i2sBeeper.init(SAMPLE_RATE);
+#endif
+  if (!audioUseI2S) {
+    M5Cardputer.Speaker.begin();
+    M5Cardputer.Speaker.setVolume(192);  // 0-255
+  }
   
   // ✅ Disable built-in display backlight (we use external display)
   externalDisplay.setBrightness(0);
@@ -1246,6 +1338,9 @@ void setup() {
   externalDisplay.fillScreen(TFT_BLACK);
   Serial.printf("  ✓ External display ready: %dx%d\n", externalDisplay.width(), externalDisplay.height());
   
+  // ✅ V3.138: Геометрия overlay-слоёв (бейдж, уведомления, PAUSE)
+  setupOverlays();
+  
   // Очистка экрана (черный фон) - теперь на внешнем дисплее
   externalDisplay.setTextColor(WHITE);
   externalDisplay.setTextSize(1);
@@ -1285,6 +1380,7 @@ void setup() {
 
   // Сбрасываем Z80
   spectrum->reset_spectrum();
+  spectrum->setInputLatch(INPUT_LATCH_LINE, latchInputMidFrame, nullptr);  // V3.155
 
   Serial.printf("✅ Z80: PC=0x%04X SP=0x%04X IM=%d\n", 
                 spectrum->z80Regs->PC.W, spectrum->z80Regs->SP.W, spectrum->z80Regs->IM);
@@ -1292,6 +1388,7 @@ void setup() {
   
   // ═══ 🎵 ЗАПУСКАЕМ AUDIO TASK НА CORE 1 (ChatGPT!) ═══
   Serial.println("🔊 Starting Audio Task on Core 1...");
+  emuTaskHandle = xTaskGetCurrentTaskHandle();  // V3.146: Audio Task будит loop()
   xTaskCreatePinnedToCore(Task_Audio, "Task_Audio", 8192, nullptr, 3, nullptr, 1);
   Serial.println("✅ Audio Task started!");
   
@@ -1326,9 +1423,16 @@ void setup() {
       }
     }
     
+    // V3.157: пока ждём - грузим ROM без экрана (по 5 кадров за итерацию)
+    if (!advanceHeadlessBoot(5)) continue;
+    
     delay(50);  // Экономим CPU
   }
   
+  // V3.157: Нажали раньше, чем ROM готова - догружаем
+  advanceHeadlessBoot(BOOT_MAX_FRAMES);
+  rewindBuffer.begin();  // V3.161: кольцо в PSRAM (нет памяти → перемотка выключена)
+  
   // ═══ ОТКРЫВАЕМ МЕНЮ ПОСЛЕ SPLASH ═══
   showMenu = true;
   emulatorPaused = true;
@@ -1338,6 +1442,8 @@ void setup() {
 
 // Буфер для рендеринга (RGB565, 16-bit color)
 uint16_t* frameBuffer = nullptr;
+const int FB_WIDTH = 240;   // Размер frameBuffer (см. renderScreen)
+const int FB_HEIGHT = 192;
 
 // ===== ZOOM/PAN VARIABLES =====
 enum RenderMode {
@@ -1360,18 +1466,64 @@ int pixelPerfectPanY = 0;  // No vertical pan needed (192 fits in 320)
 const int PP_MAX_PAN_X = 8; // No pan needed (native resolution fits) //Verificare se crasha - era 0
 const int PP_MAX_PAN_Y = 0; // No pan needed (native resolution fits)
 
+// ═══ V3.139: DIRTY-СТРОКИ frameBuffer ═══
+// 1 = строка перерисована в этом кадре и должна уйти на дисплей
+static uint8_t fbLineDirty[FB_HEIGHT];
+
+// Смена режима/зума/пана → все строки frameBuffer сдвигаются → полная перерисовка
+static void checkViewChanged() {
+  static RenderMode lastMode = MODE_ZOOM;
+  static float lastZoom = -1.0;
+  static int lastPanX = 0, lastPanY = 0;
+  static int lastPPPanX = -1, lastPPPanY = -1;
+  
+  if (renderMode != lastMode || zoomLevel != lastZoom ||
+      panX != lastPanX || panY != lastPanY ||
+      pixelPerfectPanX != lastPPPanX || pixelPerfectPanY != lastPPPanY) {
+    lastMode = renderMode;
+    lastZoom = zoomLevel;
+    lastPanX = panX;
+    lastPanY = panY;
+    lastPPPanX = pixelPerfectPanX;
+    lastPPPanY = pixelPerfectPanY;
+    zxScreen.invalidate();
+  }
+}
+
+// Отправляем на дисплей только непрерывные полосы изменившихся строк
+static void pushDirtyBands(int x, int y, int w, int h) {
+  frameTelemetry.mark(STAGE_COMPOSE);  // V3.142: всё до этого = сборка кадра
+  busScheduler.beginDisplay();  // V3.140: учёт занятости шины
+  int dy = 0;
+  while (dy < h) {
+    if (!fbLineDirty[dy]) {
+      dy++;
+      continue;
+    }
+    int start = dy;
+    while (dy < h && fbLineDirty[dy]) dy++;
+    externalDisplay.pushImage(x, y + start, w, dy - start, frameBuffer + start * w);
+  }
+  busScheduler.endDisplay();
+  frameTelemetry.mark(STAGE_PUSH);
+  inputLatency.notePush(micros(), emuFrameNo, screenPixelsChanged);  // V3.155
+}
+
 // Функция рендеринга ZX Spectrum экрана (С ЦВЕТАМИ + ZOOM/PAN + PIXEL-PERFECT!)
 // ✅ NATIVE RESOLUTION: 256×192 (ZX Spectrum native, centered on 480×320 display)
+// ✅ V3.139: FLASH + перерисовка только изменившихся строк знакомест
 void renderScreen() {
   const int ZX_WIDTH = 256; // era 256
   const int ZX_HEIGHT = 192;
-  const int DISPLAY_WIDTH = 240;   // ✅ Native ZX Spectrum width  //era 256
-  const int DISPLAY_HEIGHT = 192;  // ✅ Native ZX Spectrum height
+  const int DISPLAY_WIDTH = FB_WIDTH;   // ✅ Native ZX Spectrum width  //era 256
+  const int DISPLAY_HEIGHT = FB_HEIGHT; // ✅ Native ZX Spectrum height
   
   // ✅ Centering offsets for 480×320 external display
   const int OFFSET_X = (240 - DISPLAY_WIDTH) / 2;   // 112 pixels (centered)
   const int OFFSET_Y = (320 - DISPLAY_HEIGHT) / 2;  // 64 pixels (centered)
   
+  checkViewChanged();
+  
   // ═══════════════════════════════════════════════════════════
   // ═══ РЕЖИМ PIXEL-PERFECT (1:1 без масштабирования) ═══
   // ═══════════════════════════════════════════════════════════
@@ -1403,6 +1555,7 @@ void renderScreen() {
           Serial.printf("[VIDEO] ✅ Framebuffer allocated in heap: %p\n", frameBuffer);
         }
       }
+      zxScreen.invalidate();  // Новый буфер - перерисовываем всё
       
       if (!frameBuffer) {
         Serial.printf("🔴 FATAL: Failed to allocate framebuffer! Need: %u bytes (%.1f KB)\n", 
@@ -1416,17 +1569,50 @@ void renderScreen() {
     // Прямой доступ к VRAM
     uint8_t* vram = spectrum->mem.getScreenData();
     
+    // V3.139: Какие знакоместа изменились (+ фаза FLASH) и какие строки под overlay
+    zxScreen.scan(vram, spectrum->flashPhase);
+    screenPixelsChanged = zxScreen.anyRowDirty();  // V3.155: для пробы задержки
+    memset(fbLineDirty, zxScreen.isFullRedraw() ? 1 : 0, sizeof(fbLineDirty));
+    updateOverlays();
+    overlayCompositor.markDirtyRows(fbLineDirty, DISPLAY_HEIGHT);
+    
     // PIXEL-PERFECT: 1:1 рендеринг БЕЗ масштабирования
     // V3.134: добавлен horizontal PAN!
     // x_offset = pixelPerfectPanX (0..16, горизонтальная прокрутка)
     // y_offset = pixelPerfectPanY (0..57, вертикальная прокрутка)
     
-    int bufferIdx = 0;
     for (int dy = 0; dy < DISPLAY_HEIGHT; dy++) {
+      int zy = dy + pixelPerfectPanY;  // dy + (0..57)
+      
+      // V3.139: строка не менялась и не под overlay → пропускаем
+      if (!fbLineDirty[dy] && (zy >= ZX_HEIGHT || !zxScreen.isRowDirty(zy >> 3))) {
+        continue;
+      }
+      fbLineDirty[dy] = 1;
+      
+      int bufferIdx = dy * DISPLAY_WIDTH;
+      
+      // ═══ V3.141: БЫСТРЫЙ ПУТЬ - pan кратен 8 → целые знакоместа ═══
+      // (pan шаг = 8, так что это обычный случай)
+      if ((pixelPerfectPanX & 7) == 0 && zy < ZX_HEIGHT) {
+        int firstCol = pixelPerfectPanX >> 3;
+        int cells = DISPLAY_WIDTH / 8;
+        if (firstCol + cells > 32) cells = 32 - firstCol;
+        
+        int bitmapOffset = ((zy & 0xC0) << 5) + ((zy & 0x07) << 8) + ((zy & 0x38) << 2);
+        zxExpandCells(&frameBuffer[bufferIdx], vram + bitmapOffset + firstCol,
+                      vram + 0x1800 + (zy >> 3) * 32 + firstCol, cells, zxScreen.attrTable());
+        
+        // Справа от ZX экрана - чёрный
+        for (int dx = cells * 8; dx < DISPLAY_WIDTH; dx++) {
+          frameBuffer[bufferIdx + dx] = 0x0000;
+        }
+        continue;
+      }
+      
       for (int dx = 0; dx < DISPLAY_WIDTH; dx++) {
         // Координаты в ZX Spectrum (1:1!)
         int zx = dx + pixelPerfectPanX;  // dx + (0..16)
-        int zy = dy + pixelPerfectPanY;  // dy + (0..57)
         
         // Проверка границ ZX экрана
         if (zx >= ZX_WIDTH || zy >= ZX_HEIGHT) {
@@ -1453,19 +1639,8 @@ void renderScreen() {
         int attrOffset = 0x1800 + (attrRow * 32) + attrCol;
         uint8_t attr = vram[attrOffset];
         
-        // Распаковываем атрибут
-        int ink = attr & 0x07;
-        int paper = (attr >> 3) & 0x07;
-        bool bright = (attr & 0x40) != 0;
-        
-        if (bright) {
-          ink += 8;
-          paper += 8;
-        }
-        
-        // Выбираем цвет
-        uint16_t color = pixel ? specpal565[ink] : specpal565[paper];
-        frameBuffer[bufferIdx++] = color;
+        // V3.139: BRIGHT и FLASH уже учтены в LUT → {paper, ink}[pixel]
+        frameBuffer[bufferIdx++] = zxScreen.colors(attr)[pixel];
       }
     }
     
@@ -1502,35 +1677,12 @@ void renderScreen() {
       }
     }
     
-    // Отрисовываем буфер на внешнем дисплее (centered)
-    externalDisplay.pushImage(OFFSET_X, OFFSET_Y, DISPLAY_WIDTH, DISPLAY_HEIGHT, frameBuffer);
+    // ═══ V3.138: БЕЙДЖ "PP", УВЕДОМЛЕНИЯ И PAUSE → В frameBuffer! ═══
+    overlayCompositor.compose(frameBuffer, DISPLAY_WIDTH, DISPLAY_HEIGHT);
     
-    // ═══ БЕЙДЖ "PP" (жёлтый, правый верхний угол ZX экрана) ═══
-    // ✅ Adjusted for native 256×192 with offset
-    int ppBadgeX = OFFSET_X + DISPLAY_WIDTH - 55;  // Right edge of ZX screen
-    int ppBadgeY = OFFSET_Y + 2;  // Top of ZX screen
-    externalDisplay.fillRect(ppBadgeX, ppBadgeY, 53, 14, BLACK);
-    externalDisplay.drawRect(ppBadgeX, ppBadgeY, 53, 14, WHITE);
-    externalDisplay.setTextSize(1);
-    externalDisplay.setTextColor(TFT_YELLOW);
-    externalDisplay.setCursor(ppBadgeX + 15, ppBadgeY + 3);
-    externalDisplay.print("PP");
-    
-    // ═══ V3.135: УВЕДОМЛЕНИЯ И ПЛАШКИ В PP РЕЖИМЕ! ═══
-    drawNotificationOverlay();
-    
-    if (gamePaused && !notificationActive) {
-      // ✅ Centered pause overlay on ZX screen
-      int pauseX = OFFSET_X + (DISPLAY_WIDTH - 120) / 2;  // Centered horizontally
-      int pauseY = OFFSET_Y + (DISPLAY_HEIGHT - 30) / 2;   // Centered vertically
-      externalDisplay.fillRect(pauseX, pauseY, 120, 30, BLACK);
-      externalDisplay.drawRect(pauseX, pauseY, 120, 30, TFT_YELLOW);
-      externalDisplay.drawRect(pauseX + 1, pauseY + 1, 118, 28, TFT_YELLOW);
-      externalDisplay.setTextSize(2);
-      externalDisplay.setTextColor(TFT_YELLOW);
-      externalDisplay.setCursor(pauseX + 40, pauseY + 7);
-      externalDisplay.print("PAUSE");
-    }
+    // V3.139: На дисплей - только изменившиеся полосы строк
+    pushDirtyBands(OFFSET_X, OFFSET_Y, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+    zxScreen.clearDirty();
     
     return;  // Выходим из функции (не используем ZOOM логику!)
   }
@@ -1570,6 +1722,7 @@ void renderScreen() {
         Serial.printf("[VIDEO] ✅ Framebuffer allocated in heap: %p\n", frameBuffer);
       }
     }
+    zxScreen.invalidate();  // Новый буфер - перерисовываем всё
     
     if (!frameBuffer) {
       Serial.printf("🔴 FATAL: Failed to allocate framebuffer! Need: %u bytes (%.1f KB)\n", 
@@ -1583,6 +1736,13 @@ void renderScreen() {
   // Прямой доступ к VRAM (быстрее чем peek()!)
   uint8_t* vram = spectrum->mem.getScreenData();
   
+  // V3.139: Какие знакоместа изменились (+ фаза FLASH) и какие строки под overlay
+  zxScreen.scan(vram, spectrum->flashPhase);
+  screenPixelsChanged = zxScreen.anyRowDirty();  // V3.155: для пробы задержки
+  memset(fbLineDirty, zxScreen.isFullRedraw() ? 1 : 0, sizeof(fbLineDirty));
+  updateOverlays();
+  overlayCompositor.markDirtyRows(fbLineDirty, DISPLAY_HEIGHT);
+  
   // ═══ ZOOM/PAN РЕНДЕРИНГ (с сохранением 4:3!) ═══
   
   int ZX_OFFSET_X, ZX_OFFSET_Y;
@@ -1614,10 +1774,17 @@ void renderScreen() {
   
   // ═══ РЕНДЕРИНГ SCALED RESOLUTION (320×240) ═══
   // ✅ Оптимизация: предвычисляем базовую координату Y вне внутреннего цикла
-  int bufferIdx = 0;
   for (int dy = 0; dy < DISPLAY_HEIGHT; dy++) {
     // Предвычисляем базовую координату Y один раз для всей строки
     int zyBase = ZX_OFFSET_Y + (dy * ZX_VIEW_H) / RENDER_HEIGHT;
+    
+    // V3.139: строка не менялась и не под overlay → пропускаем
+    if (!fbLineDirty[dy] && (zyBase >= ZX_HEIGHT || !zxScreen.isRowDirty(zyBase >> 3))) {
+      continue;
+    }
+    fbLineDirty[dy] = 1;
+    
+    int bufferIdx = dy * DISPLAY_WIDTH;
     for (int dx = 0; dx < DISPLAY_WIDTH; dx++) {
       // ✅ Scaled resolution - full screen with 1.25x scale
       // Масштабируем в координаты ZX с учетом ZOOM
@@ -1650,24 +1817,10 @@ void renderScreen() {
       int attrOffset = 0x1800 + (attrRow * 32) + attrCol;
       uint8_t attr = vram[attrOffset];
       
-      // Распаковываем атрибут:
-      // Биты 0-2: INK (цвет символа)
-      // Биты 3-5: PAPER (цвет фона)
-      // Бит 6: BRIGHT
-      int ink = attr & 0x07;
-      int paper = (attr >> 3) & 0x07;
-      bool bright = (attr & 0x40) != 0;
-      
-      // Если BRIGHT - добавляем 8 к цвету
-      if (bright) {
-        ink += 8;
-        paper += 8;
-      }
-      
-      // Выбираем цвет: INK если пиксель=1, PAPER если пиксель=0
-      uint16_t color = pixel ? specpal565[ink] : specpal565[paper];
-      
-      frameBuffer[bufferIdx++] = color;
+      // V3.139: Атрибут → цвет через LUT:
+      // Биты 0-2 INK, 3-5 PAPER, 6 BRIGHT, 7 FLASH - всё уже в таблице
+      // (FLASH = ink/paper переставлены в текущей фазе)
+      frameBuffer[bufferIdx++] = zxScreen.colors(attr)[pixel];
     }
   }
   
@@ -1733,117 +1886,322 @@ void renderScreen() {
     }
   }
   
-  // Отрисовываем буфер ОДНИМ вызовом (с красными линиями внутри!) на внешнем дисплее (centered)
-  externalDisplay.pushImage(OFFSET_X, OFFSET_Y, DISPLAY_WIDTH, DISPLAY_HEIGHT, frameBuffer);
-  
-  // ═══ ВИЗУАЛЬНЫЕ ИНДИКАТОРЫ ═══
-  
-  // ZOOM ИНДИКАТОР (желтый, правый верхний угол ZX экрана) - рисуем ПОВЕРХ!
-  // ✅ Adjusted for native 256×192 with offset
-  if (zoomLevel > 1.05) {
-    int zoomBadgeX = OFFSET_X + DISPLAY_WIDTH - 55;  // Right edge of ZX screen
-    int zoomBadgeY = OFFSET_Y + 2;  // Top of ZX screen
-    // Чёрный фон с белой рамкой
-    externalDisplay.fillRect(zoomBadgeX, zoomBadgeY, 53, 14, BLACK);
-    externalDisplay.drawRect(zoomBadgeX, zoomBadgeY, 53, 14, WHITE);
-    
-    // Жёлтый текст
-    externalDisplay.setTextSize(1);
-    externalDisplay.setTextColor(TFT_YELLOW);
-    externalDisplay.setCursor(zoomBadgeX + 4, zoomBadgeY + 3);
-    
-    // Выводим текст зума
-    if (zoomLevel < 1.6) {
-      externalDisplay.print("x1.5");
-    } else if (zoomLevel < 2.3) {
-      externalDisplay.print("x2.0");
-    } else {
-      externalDisplay.print("x2.5");
-    }
-  }
-  
-  // ═══ АСИНХРОННЫЕ УВЕДОМЛЕНИЯ (V3.134) ═══
-  drawNotificationOverlay();
+  // ═══ V3.138: ZOOM-БЕЙДЖ, УВЕДОМЛЕНИЯ И PAUSE → В frameBuffer! ═══
+  // (раньше рисовались ПОВЕРХ отдельными SPI транзакциями → мерцание)
+  overlayCompositor.compose(frameBuffer, DISPLAY_WIDTH, DISPLAY_HEIGHT);
   
-  // ═══ V3.134: ПЛАШКА "PAUSE" (не рисуем если есть активное уведомление!) ═══
-  // ✅ Centered pause overlay on ZX screen
-  if (gamePaused && !notificationActive) {
-    int pauseX = OFFSET_X + (DISPLAY_WIDTH - 120) / 2;  // Centered horizontally
-    int pauseY = OFFSET_Y + (DISPLAY_HEIGHT - 30) / 2;   // Centered vertically
-    // Непрозрачная чёрная плашка с жёлтой рамкой
-    externalDisplay.fillRect(pauseX, pauseY, 120, 30, BLACK);
-    externalDisplay.drawRect(pauseX, pauseY, 120, 30, TFT_YELLOW);
-    externalDisplay.drawRect(pauseX + 1, pauseY + 1, 118, 28, TFT_YELLOW);
-    
-    // Текст "PAUSE" по центру
-    externalDisplay.setTextSize(2);
-    externalDisplay.setTextColor(TFT_YELLOW);
-    externalDisplay.setCursor(pauseX + 40, pauseY + 7);
-    externalDisplay.print("PAUSE");
-  }
+  // V3.139: На дисплей - только изменившиеся полосы строк (с красными линиями и overlay внутри!)
+  pushDirtyBands(OFFSET_X, OFFSET_Y, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+  zxScreen.clearDirty();
 }
 
 // ═══════════════════════════════════════════════════════════
-// Обновление ZX Spectrum клавиш из Joystick2 (QAOP + Space)
+// Joystick2 → порты ZX Spectrum (V3.154)
 // ═══════════════════════════════════════════════════════════
-void updateJoystickKeys() {
-  // Не обрабатываем джойстик если:
-  // 1. Джойстик выключен (joystickEnabled = false)
+// Раньше: каждый кадр QAOP+Space записывались в матрицу клавиатуры.
+// Теперь эмулятор сам читает байт направлений задачи опроса на каждом IN
+// (Kempston 0x1F / Sinclair / Cursor / QAOP - см. ZXSpectrum::setJoystickMode).
+// Здесь только решаем, подключён ли источник.
+void updateJoystickRouting() {
+  // Не подключаем джойстик если:
+  // 1. Джойстик выключен (joystickEnabled = false) или не найден
   // 2. Открыто меню, браузер или Information (джойстик используется для навигации)
-  if (!joystickEnabled || showMenu || showLoadGameMenu || showBrowser || showInformation) {
-    return;  // Ничего не делаем
+  bool active = joystickEnabled && joystick2Available &&
+                !(showMenu || showLoadGameMenu || showBrowser || showInformation);
+  spectrum->joystickSource = active ? joystickPoller.directionByte() : nullptr;
+}
+
+// ═══ V3.154: РЕЖИМ ДЖОЙСТИКА ДЛЯ КАЖДОЙ ИГРЫ ═══
+// Хранится рядом с игрой: /ZXgames/<файл>.joy (одно слово - имя режима)
+static String currentGameFile;   // Последняя загруженная игра ("" = нет)
+
+static String joystickConfigPath(const String& fileName) {
+  return "/ZXgames/" + fileName + ".joy";
+}
+
+static void loadGameJoystickMode(const String& fileName) {
+  currentGameFile = fileName;
+  saveStates.setGame(fileName.c_str());  // V3.160: слоты этой игры
+  JoystickMode mode = JOY_QAOP;  // Нет файла → как раньше
+
+  File f = SD.open(joystickConfigPath(fileName));
+  if (f) {
+    char name[16] = {0};
+    int n = f.read((uint8_t*)name, sizeof(name) - 1);
+    f.close();
+    name[n > 0 ? n : 0] = '\0';
+    name[strcspn(name, " \r\n")] = '\0';  // Первое слово
+    for (int m = 0; m < JOY_MODE_COUNT; m++) {
+      if (strcasecmp(name, ZXSpectrum::joystickModeName((JoystickMode)m)) == 0) {
+        mode = (JoystickMode)m;
+        break;
+      }
+    }
   }
-  
-  // Читаем состояние Joystick2
-  if (!joystick2Available) {
+  spectrum->setJoystickMode(mode);
+  Serial.printf("🕹️  Joystick mode for %s: %s\n", fileName.c_str(), ZXSpectrum::joystickModeName(mode));
+}
+
+// V3.158: Opt+F - turbo вкл/выкл
+static void toggleTurbo() {
+  turboMode = !turboMode;
+  turboSpeedX10 = 0;
+  turboLastRenderMs = millis();
+  if (!turboMode) {
+    // Записи AY в turbo не дошли до Audio Task → следующий кадр отдаст регистры целиком
+    spectrum->ayResyncPending = true;
+  }
+  Serial.printf("⏩ Turbo: %s\n", turboMode ? "ON" : "OFF");
+  if (!showMenu && !showBrowser) {
+    showNotification(turboMode ? "Turbo: ON (sound off)" : "Turbo: OFF",
+                     turboMode ? TFT_ORANGE : TFT_GREEN, 1000);
+  }
+}
+
+// ═══ V3.159: ЗАПИСЬ/ПОВТОР ВВОДА ═══
+static const char* const REPLAY_DIR = "/ZXreplays";
+
+// Наибольший номер inp_NNN.zxr (0 = файлов нет)
+static int latestReplayNumber() {
+  int maxNum = 0;
+  File dir = SD.open(REPLAY_DIR);
+  if (!dir) return 0;
+  File f = dir.openNextFile();
+  while (f) {
+    String name = f.name();
+    if (name.startsWith("inp_") && name.endsWith(".zxr")) {
+      int num = name.substring(4, name.indexOf(".zxr")).toInt();
+      if (num > maxNum) maxNum = num;
+    }
+    f.close();
+    f = dir.openNextFile();
+  }
+  dir.close();
+  return maxNum;
+}
+
+static void onReplayWritten(void* ctx, bool ok) {
+  replayWriteBusy = false;
+  const char* name = strrchr(replayPath, '/');
+  char msg[40];
+  snprintf(msg, sizeof(msg), ok ? "INPUT saved %s" : "INPUT save FAILED %s", name ? name + 1 : replayPath);
+  showNotification(msg, ok ? TFT_GREEN : TFT_RED, 2000);
+}
+
+// Запись закончена → файл через планировщик шины (буфер освободит он)
+static void saveInputRecording() {
+  size_t len = 0;
+  uint8_t* data = inputReplay.finishRecording(&len);
+  if (!data) return;
+  if (!SD.exists(REPLAY_DIR) && !SD.mkdir(REPLAY_DIR)) {
+    Serial.println("❌ Replay: failed to create /ZXreplays");
+    free(data);
+    showNotification("INPUT: SD error", TFT_RED, 2000);
     return;
   }
-  
-  Joystick2Data joyData = readJoystick2();
-  
-  // Мапим джойстик на ZX Spectrum клавиши (ИНВЕРТИРОВАНО):
-  // Физический UP → A (SPECKEY_A - вниз в игре)
-  // Физический DOWN → Q (SPECKEY_Q - вверх в игре)
-  // Физический LEFT → P (SPECKEY_P - вправо в игре)
-  // Физический RIGHT → O (SPECKEY_O - влево в игре)
-  // FIRE → Space (SPECKEY_SPACE)
-  
-  // Y-ось: UP/DOWN (ИНВЕРТИРОВАНО!)
-  if (joyData.y < 100) {
-    // Физический UP → A (вниз в игре)
-    spectrum->updateKey(SPECKEY_A, 1);
+  snprintf(replayPath, sizeof(replayPath), "%s/inp_%03d.zxr", REPLAY_DIR, latestReplayNumber() + 1);
+  if (!busScheduler.submitFileWrite(replayPath, data, len, true, onReplayWritten, nullptr)) {
+    Serial.println("⚠️  Replay: bus queue full, recording dropped");  // Буфер освобождён планировщиком
+    showNotification("INPUT: queue full", TFT_RED, 2000);
+    return;
+  }
+  replayWriteBusy = true;
+  Serial.printf("🎬 Replay: saving %s (%u bytes)\n", replayPath, (unsigned)len);
+}
+
+// Машина меняется не через кадры (загрузка, сброс) → запись сохраняем, повтор прерываем
+static void endInputReplaySession() {
+  if (inputReplay.mode() == InputReplay::RECORDING) {
+    saveInputRecording();
+  } else {
+    inputReplay.abort(spectrum);
   }
-  if (joyData.y > 155) {
-    // Физический DOWN → Q (вверх в игре)
-    spectrum->updateKey(SPECKEY_Q, 1);
+}
+
+// Opt+E: начать/закончить запись с текущего кадра
+static void toggleInputRecording() {
+  if (inputReplay.mode() == InputReplay::RECORDING) {
+    saveInputRecording();
+    return;
   }
-  
-  // X-ось: LEFT/RIGHT (ИНВЕРТИРОВАНО!)
-  if (joyData.x < 100) {
-    // Физический LEFT → P (вправо в игре)
-    spectrum->updateKey(SPECKEY_P, 1);
+  if (inputReplay.mode() == InputReplay::PLAYING) {
+    showNotification("INPUT: replay running", TFT_YELLOW, 1000);
+    return;
   }
-  if (joyData.x > 155) {
-    // Физический RIGHT → O (влево в игре)
-    spectrum->updateKey(SPECKEY_O, 1);
+  if (inputReplay.startRecording(spectrum)) {
+    showNotification("INPUT REC: ON", TFT_RED, 1000);
+  } else {
+    showNotification("INPUT REC: FAILED", TFT_RED, 2000);
   }
-  
-  // Кнопка: FIRE → Space
-  if (joyData.button == 1) {
-    spectrum->updateKey(SPECKEY_SPACE, 1);
+}
+
+// Opt+Y: проиграть последнюю запись (повторно - остановить)
+static void toggleInputReplay() {
+  if (inputReplay.mode() == InputReplay::PLAYING) {
+    inputReplay.abort(spectrum);
+    showNotification("REPLAY: stopped", TFT_YELLOW, 1000);
+    return;
   }
-  
-  // Диагностика (раз в 50 кадров, только если есть движение)
-  static int debugCounter = 0;
-  bool hasMovement = (joyData.x < 100 || joyData.x > 155 || joyData.y < 100 || joyData.y > 155 || joyData.button == 1);
-  if (hasMovement && debugCounter++ % 50 == 0) {
-    Serial.printf("🕹️  Joystick→Keys: x=%d y=%d btn=%d ", joyData.x, joyData.y, joyData.button);
-    if (joyData.y < 100) Serial.print("A ");      // Физический UP → A (вниз)
-    if (joyData.y > 155) Serial.print("Q ");      // Физический DOWN → Q (вверх)
-    if (joyData.x < 100) Serial.print("P ");      // Физический LEFT → P (вправо)
-    if (joyData.x > 155) Serial.print("O ");      // Физический RIGHT → O (влево)
-    if (joyData.button == 1) Serial.print("SPACE");
-    Serial.println();
+  if (inputReplay.mode() == InputReplay::RECORDING || replayWriteBusy) {
+    showNotification("REPLAY: recording not saved yet", TFT_YELLOW, 1500);
+    return;
+  }
+  int num = latestReplayNumber();
+  if (num == 0) {
+    showNotification("REPLAY: no recordings", TFT_YELLOW, 1500);
+    return;
+  }
+  snprintf(replayPath, sizeof(replayPath), "%s/inp_%03d.zxr", REPLAY_DIR, num);
+
+  File f = SD.open(replayPath);
+  size_t len = f ? f.size() : 0;
+  uint8_t* data = len ? (uint8_t*)heap_caps_malloc(len, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT) : nullptr;
+  bool ok = data && f.read(data, len) == (int)len;
+  if (f) f.close();
+  if (!ok) {
+    if (data) free(data);
+    Serial.printf("❌ Replay: failed to read %s\n", replayPath);
+    showNotification("REPLAY: read error", TFT_RED, 2000);
+    return;
+  }
+  if (!inputReplay.startPlayback(data, len, spectrum)) {
+    showNotification("REPLAY: bad file", TFT_RED, 2000);
+    return;
+  }
+  zxScreen.invalidate();  // Экран из снимка - перерисовать целиком
+  replayStartUs = micros();
+  const char* name = strrchr(replayPath, '/');
+  char msg[40];
+  snprintf(msg, sizeof(msg), "REPLAY %s", name ? name + 1 : replayPath);
+  showNotification(msg, TFT_CYAN, 1000);
+}
+
+// frameEnd() == true: повтор доигран или буфер записи полон
+static void onInputReplayEnd() {
+  if (inputReplay.mode() == InputReplay::RECORDING) {
+    Serial.println("⚠️  Replay: recording buffer full");
+    saveInputRecording();
+    return;
+  }
+  const ReplayResult& r = inputReplay.result();
+  uint32_t us = micros() - replayStartUs;
+  // Повтор = воспроизводимая нагрузка: время прогона (в turbo - скорость ядра)
+  Serial.printf("🎬 REPLAY: %u frames in %u ms (%.1f fps) | mismatched %u | first %d\n",
+                (unsigned)r.frames, (unsigned)(us / 1000),
+                us ? r.frames * 1000000.0f / us : 0.0f,
+                (unsigned)r.mismatches, (int)r.firstMismatch);
+  char msg[40];
+  if (r.mismatches == 0) {
+    snprintf(msg, sizeof(msg), "REPLAY OK %u frames", (unsigned)r.frames);
+  } else {
+    snprintf(msg, sizeof(msg), "REPLAY DIVERGED @%d", (int)r.firstMismatch);
+  }
+  showNotification(msg, r.mismatches ? TFT_RED : TFT_GREEN, 2000);
+}
+
+// ═══ V3.160: СЛОТЫ СОХРАНЕНИЯ ═══
+// Фоновая запись/чтение закончены (loop, окно простоя шины)
+static void onSaveStateDone(void* ctx, int slot, bool saved, SaveLoadResult result) {
+  char msg[32];
+  if (saved) {
+    if (result == SLOT_OK) return;  // Успех уже показан при сохранении
+    snprintf(msg, sizeof(msg), "SLOT %d: SD %s", slot + 1, SaveStates::resultText(result));
+  } else if (result == SLOT_OK) {
+    snprintf(msg, sizeof(msg), "LOADED slot %d", slot + 1);
+    zxScreen.invalidate();
+  } else {
+    snprintf(msg, sizeof(msg), "SLOT %d: %s", slot + 1, SaveStates::resultText(result));
+  }
+  showNotification(msg, result == SLOT_OK ? TFT_GREEN : TFT_RED, 1500);
+}
+
+// Opt+S: снимок в PSRAM сейчас, файл - в фоне
+static void quickSave() {
+  char msg[32];
+  saveStates.setDoneCallback(onSaveStateDone, nullptr);
+  SaveLoadResult result = saveStates.save(saveSlot, spectrum);
+  if (result == SLOT_OK) {
+    snprintf(msg, sizeof(msg), "SAVED slot %d", saveSlot + 1);
+    showNotification(msg, TFT_GREEN, 1000);
+  } else {
+    snprintf(msg, sizeof(msg), "SAVE slot %d: %s", saveSlot + 1, SaveStates::resultText(result));
+    showNotification(msg, result == SLOT_BUSY ? TFT_YELLOW : TFT_RED, 1500);
+  }
+}
+
+// Opt+L: из PSRAM сразу, иначе с SD в фоне (эмуляция идёт дальше)
+static void quickLoad() {
+  endInputReplaySession();  // V3.159: машина меняется не через кадры
+  char msg[32];
+  saveStates.setDoneCallback(onSaveStateDone, nullptr);
+  SaveLoadResult result = saveStates.load(saveSlot, spectrum);
+  switch (result) {
+    case SLOT_OK:
+      zxScreen.invalidate();
+      snprintf(msg, sizeof(msg), "LOADED slot %d", saveSlot + 1);
+      showNotification(msg, TFT_GREEN, 1000);
+      break;
+    case SLOT_PENDING:
+      snprintf(msg, sizeof(msg), "LOADING slot %d...", saveSlot + 1);
+      showNotification(msg, TFT_CYAN, 1000);
+      break;
+    case SLOT_BUSY:
+      snprintf(msg, sizeof(msg), "SLOT %d: busy", saveSlot + 1);
+      showNotification(msg, TFT_YELLOW, 1000);
+      break;
+    default:
+      snprintf(msg, sizeof(msg), "LOAD slot %d: %s", saveSlot + 1, SaveStates::resultText(result));
+      showNotification(msg, TFT_RED, 1500);
+      break;
+  }
+}
+
+// Opt+B: секунда назад (повтор нажатия - ещё секунда)
+static void rewindStep() {
+  if (!rewindBuffer.ready()) {
+    showNotification("REWIND: no PSRAM", TFT_RED, 1000);
+    return;
+  }
+  endInputReplaySession();  // V3.159: машина меняется не через кадры
+  uint32_t t0 = micros();
+  int stepped = rewindBuffer.stepBack(spectrum, REWIND_STEP_POINTS);
+  if (stepped == 0) {
+    showNotification("REWIND: nothing buffered", TFT_YELLOW, 1000);
+    return;
+  }
+  zxScreen.invalidate();
+  Serial.printf("⏪ Rewind: %d points back in %u us, %.1f s left\n",
+                stepped, (unsigned)(micros() - t0), rewindBuffer.seconds());
+  char msg[32];
+  snprintf(msg, sizeof(msg), "REWIND -%.1fs (%.0fs left)",
+           (float)stepped * RewindBuffer::CAPTURE_EVERY / RewindBuffer::FRAMES_PER_SECOND,
+           rewindBuffer.seconds());
+  showNotification(msg, TFT_CYAN, 800);
+}
+
+// Opt+K: следующий режим; для загруженной игры - запомнить (запись через планировщик шины)
+static void cycleJoystickMode() {
+  JoystickMode mode = (JoystickMode)((spectrum->joystickMode + 1) % JOY_MODE_COUNT);
+  spectrum->setJoystickMode(mode);
+  const char* name = ZXSpectrum::joystickModeName(mode);
+  Serial.printf("🕹️  Joystick mode: %s\n", name);
+
+  if (currentGameFile.length() > 0) {
+    size_t len = strlen(name);
+    uint8_t* buf = (uint8_t*)malloc(len + 1);
+    if (buf) {
+      memcpy(buf, name, len);
+      buf[len] = '\n';
+      if (!busScheduler.submitFileWrite(joystickConfigPath(currentGameFile).c_str(), buf, len + 1, true)) {
+        Serial.println("⚠️  Joystick config: bus queue full, not saved");
+      }
+    }
+  }
+
+  if (!showMenu && !showBrowser) {
+    char msg[32];
+    snprintf(msg, sizeof(msg), "Joy: %s", name);
+    showNotification(msg, TFT_CYAN, 1000);
   }
 }
 
@@ -1859,22 +2217,77 @@ void showNotification(const char* text, uint16_t color = TFT_YELLOW, unsigned lo
   notificationActive = true;
 }
 
-void drawNotificationOverlay() {
-  if (!notificationActive) return;
+// ═══ V3.138: ГЕОМЕТРИЯ OVERLAY-СЛОЁВ (координаты frameBuffer!) ═══
+void setupOverlays() {
+  // Бейдж: правый верхний угол ZX экрана
+  overlayCompositor.configure(OVERLAY_BADGE,        {FB_WIDTH - 55, 2, 53, 14, WHITE, false, 1, 4, 3});
+  // Уведомление: под бейджем, чтобы не перекрывались. Раньше рисовалось
+  // прямо на дисплее в (40, 60) - это 4 px выше кадра (OFFSET_Y = 64), в
+  // frameBuffer такого места нет, а y = 0 наезжает на бейдж (x 185-238)
+  overlayCompositor.configure(OVERLAY_NOTIFICATION, {40, 20, 160, 20, WHITE, false, 1, 10, 5});
+  // PAUSE: по центру ZX экрана, двойная жёлтая рамка
+  overlayCompositor.configure(OVERLAY_PAUSE,        {(FB_WIDTH - 120) / 2, (FB_HEIGHT - 30) / 2, 120, 30,
+                                                     TFT_YELLOW, true, 2, 40, 7});
+  // HUD телеметрии: нижняя строка ZX экрана, без видимой рамки
+  overlayCompositor.configure(OVERLAY_HUD,          {0, FB_HEIGHT - 22, FB_WIDTH, 22, BLACK, false, 1, 2, 2});
+}
+
+// Синхронизирует состояние UI (режим, уведомление, пауза) со слоями композитора.
+// Тайлы перерисовываются только если текст/цвет реально изменились.
+void updateOverlays() {
+  // ═══ БЕЙДЖ: turbo (V3.158), "PP" или уровень зума ═══
+  if (turboMode) {
+    char badge[12];
+    if (turboSpeedX10 > 0) {
+      snprintf(badge, sizeof(badge), "FF x%u.%u", (unsigned)(turboSpeedX10 / 10), (unsigned)(turboSpeedX10 % 10));
+    } else {
+      snprintf(badge, sizeof(badge), "FF");
+    }
+    overlayCompositor.configure(OVERLAY_BADGE, {FB_WIDTH - 55, 2, 53, 14, WHITE, false, 1, 4, 3});
+    overlayCompositor.show(OVERLAY_BADGE, badge, TFT_ORANGE);
+  } else if (renderMode == MODE_PIXEL_PERFECT) {
+    overlayCompositor.configure(OVERLAY_BADGE, {FB_WIDTH - 55, 2, 53, 14, WHITE, false, 1, 15, 3});
+    overlayCompositor.show(OVERLAY_BADGE, "PP", TFT_YELLOW);
+  } else if (zoomLevel > 1.05) {
+    overlayCompositor.configure(OVERLAY_BADGE, {FB_WIDTH - 55, 2, 53, 14, WHITE, false, 1, 4, 3});
+    overlayCompositor.show(OVERLAY_BADGE, zoomLevel < 1.6 ? "x1.5" : (zoomLevel < 2.3 ? "x2.0" : "x2.5"), TFT_YELLOW);
+  } else {
+    overlayCompositor.hide(OVERLAY_BADGE);
+  }
   
-  // Проверяем таймаут
-  if (millis() - notificationStartTime > notificationDuration) {
+  // ═══ УВЕДОМЛЕНИЕ (с таймаутом) ═══
+  if (notificationActive && millis() - notificationStartTime > notificationDuration) {
     notificationActive = false;
-    return;
+  }
+  if (notificationActive) {
+    overlayCompositor.show(OVERLAY_NOTIFICATION, notificationText.c_str(), notificationColor);
+  } else {
+    overlayCompositor.hide(OVERLAY_NOTIFICATION);
   }
   
-  // Рисуем overlay (поверх экрана эмулятора)
-  externalDisplay.fillRect(40, 60, 160, 20, BLACK);
-  externalDisplay.drawRect(40, 60, 160, 20, WHITE);
-  externalDisplay.setTextSize(1);
-  externalDisplay.setTextColor(notificationColor);
-  externalDisplay.setCursor(50, 65);
-  externalDisplay.print(notificationText);
+  // ═══ PAUSE (не показываем если есть активное уведомление!) ═══
+  if (gamePaused && !notificationActive) {
+    overlayCompositor.show(OVERLAY_PAUSE, "PAUSE", TFT_YELLOW);
+  } else {
+    overlayCompositor.hide(OVERLAY_PAUSE);
+  }
+  
+  // ═══ V3.142: HUD ТЕЛЕМЕТРИИ (обновляем 4 раза в секунду) ═══
+  static unsigned long lastHudTime = 0;
+  if (frameTelemetry.hudEnabled) {
+    if (millis() - lastHudTime > 250 || !overlayCompositor.isVisible(OVERLAY_HUD)) {
+      char hud[96];
+      frameTelemetry.formatHud(hud, sizeof(hud));
+      // V3.149: вторая строка - звук (возраст кадра, заполнение, underrun/overwrite)
+      size_t len = strlen(hud);
+      hud[len++] = '\n';
+      AudioStats::formatHud(audioWindow, hud + len, sizeof(hud) - len);
+      overlayCompositor.show(OVERLAY_HUD, hud, TFT_GREEN);
+      lastHudTime = millis();
+    }
+  } else {
+    overlayCompositor.hide(OVERLAY_HUD);
+  }
 }
 
 // ═══════════════════════════════════════════════════════════
@@ -1902,11 +2315,18 @@ const uint8_t zxPalette[16][3] = {
 };
 
 // Находит следующий доступный номер для скриншота
+// V3.140: сканируем папку ОДИН раз, дальше просто считаем
 int getNextScreenshotNumber() {
+  static int nextNum = 0;
+  if (nextNum > 0) {
+    return nextNum++;
+  }
+  
   int maxNum = 0;
   
   File dir = SD.open("/ZXscreenshots");
   if (!dir) {
+    nextNum = 2;
     return 1;  // Папка не существует, начинаем с 1
   }
   
@@ -1926,22 +2346,79 @@ int getNextScreenshotNumber() {
   }
   dir.close();
   
+  nextNum = maxNum + 2;
   return maxNum + 1;
 }
 
+// V3.140: Вызывается планировщиком шины когда файл записан
+static void onScreenshotWritten(void* ctx, bool ok) {
+  int num = (int)(intptr_t)ctx;
+  if (!ok) {
+    showNotification("SCREENSHOT FAILED!", TFT_RED, 2000);
+    return;
+  }
+  Serial.printf("✅ Screenshot saved: screenshot_%03d.bmp\n", num);
+  
+  // Уведомление
+  char notifText[64];
+  snprintf(notifText, sizeof(notifText), "SCREENSHOT %03d.bmp", num);
+  showNotification(notifText, TFT_GREEN, 2000);
+}
+
+// ═══════════════════════════════════════════════════════════
+// 🎙️ WAV RECORDING (V3.151) - Opt+R
+// ═══════════════════════════════════════════════════════════
+
+// Вызывается планировщиком шины когда файл дописан и закрыт
+static void onRecordingFinished(void* ctx, bool ok) {
+  if (!ok) {
+    showNotification("RECORDING FAILED!", TFT_RED, 2000);
+    return;
+  }
+  const char* name = strrchr(wavRecorder.path(), '/');
+  char notifText[64];
+  snprintf(notifText, sizeof(notifText), "REC %s %us", name ? name + 1 : wavRecorder.path(),
+           (unsigned)(wavRecorder.samplesWritten() / SAMPLE_RATE));
+  showNotification(notifText, wavRecorder.droppedBlocks() ? TFT_YELLOW : TFT_GREEN, 2000);
+}
+
+static void toggleRecording() {
+  if (wavRecorder.isRecording()) {
+    wavRecorder.stop();
+    showNotification("REC: saving...", TFT_YELLOW, 1000);
+    return;
+  }
+  if (wavRecorder.isBusy()) {
+    showNotification("REC: still saving", TFT_YELLOW, 1000);
+    return;
+  }
+  wavRecorder.setDoneCallback(onRecordingFinished, nullptr);
+  if (wavRecorder.start(SAMPLE_RATE)) {
+    showNotification("REC: ON", TFT_RED, 1000);
+  } else {
+    showNotification("REC: FAILED", TFT_RED, 2000);
+  }
+}
+
 // Сохраняет скриншот ZX Spectrum экрана (256×192) в BMP формат
+// V3.140: BMP собирается в PSRAM, запись на SD - через busScheduler
+// кусками в паузах между кадрами (эмуляция и звук не останавливаются)
 bool saveScreenshotBMP() {
   Serial.println("\n📸 === SCREENSHOT START ===");
   
   // 1) Создаём папку если её нет
-  if (!SD.exists("/ZXscreenshots")) {
-    Serial.println("📁 Creating /ZXscreenshots/ folder...");
-    if (!SD.mkdir("/ZXscreenshots")) {
-      Serial.println("❌ Failed to create folder!");
-      showNotification("SCREENSHOT FAILED!", TFT_RED, 2000);
-      return false;
+  static bool folderChecked = false;
+  if (!folderChecked) {
+    if (!SD.exists("/ZXscreenshots")) {
+      Serial.println("📁 Creating /ZXscreenshots/ folder...");
+      if (!SD.mkdir("/ZXscreenshots")) {
+        Serial.println("❌ Failed to create folder!");
+        showNotification("SCREENSHOT FAILED!", TFT_RED, 2000);
+        return false;
+      }
+      Serial.println("✅ Folder created!");
     }
-    Serial.println("✅ Folder created!");
+    folderChecked = true;
   }
   
   // 2) Находим следующий номер файла
@@ -1949,17 +2426,9 @@ bool saveScreenshotBMP() {
   char filename[64];
   snprintf(filename, sizeof(filename), "/ZXscreenshots/screenshot_%03d.bmp", num);
   
-  Serial.printf("💾 Saving: %s\n", filename);
-  
-  // 3) Создаём файл
-  File file = SD.open(filename, FILE_WRITE);
-  if (!file) {
-    Serial.println("❌ Failed to create file!");
-    showNotification("SCREENSHOT FAILED!", TFT_RED, 2000);
-    return false;
-  }
+  Serial.printf("💾 Queueing: %s\n", filename);
   
-  // 4) BMP Header (54 байта)
+  // 3) BMP параметры
   const int WIDTH = 256;
   const int HEIGHT = 192;
   const int PADDING = (4 - (WIDTH * 3) % 4) % 4;  // BMP требует выравнивание по 4 байта
@@ -1967,6 +2436,15 @@ bool saveScreenshotBMP() {
   const int IMAGE_SIZE = ROW_SIZE * HEIGHT;
   const int FILE_SIZE = 54 + IMAGE_SIZE;
   
+  // Весь файл (~144 KB) собираем в PSRAM
+  uint8_t* bmp = (uint8_t*)heap_caps_malloc(FILE_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  if (!bmp) {
+    Serial.println("❌ Failed to allocate BMP buffer!");
+    showNotification("SCREENSHOT FAILED!", TFT_RED, 2000);
+    return false;
+  }
+  
+  // 4) BMP Header (54 байта)
   // BMP File Header (14 bytes)
   uint8_t bmpHeader[54] = {
     // Signature "BM"
@@ -2001,13 +2479,13 @@ bool saveScreenshotBMP() {
     0, 0, 0, 0
   };
   
-  file.write(bmpHeader, 54);
+  memcpy(bmp, bmpHeader, 54);
   
   // 5) Получаем VRAM
   uint8_t* vram = spectrum->mem.getScreenData();
   
   // 6) Записываем пиксели (BMP хранит снизу вверх!)
-  uint8_t rowBuffer[ROW_SIZE];
+  uint8_t* rowBuffer = bmp + 54;
   
   for (int y = HEIGHT - 1; y >= 0; y--) {  // BMP: снизу вверх
     int bufPos = 0;
@@ -2049,17 +2527,15 @@ bool saveScreenshotBMP() {
       rowBuffer[bufPos++] = 0;
     }
     
-    file.write(rowBuffer, ROW_SIZE);
+    rowBuffer += ROW_SIZE;
   }
   
-  file.close();
-  
-  Serial.printf("✅ Screenshot saved: %s (%d KB)\n", filename, FILE_SIZE / 1024);
-  
-  // Уведомление
-  char notifText[64];
-  snprintf(notifText, sizeof(notifText), "SCREENSHOT %03d.bmp", num);
-  showNotification(notifText, TFT_GREEN, 2000);
+  // 7) В очередь на SD (буфер освободит планировщик)
+  if (!busScheduler.submitFileWrite(filename, bmp, FILE_SIZE, true,
+                                    onScreenshotWritten, (void*)(intptr_t)num)) {
+    showNotification("SCREENSHOT FAILED!", TFT_RED, 2000);
+    return false;
+  }
   
   return true;
 }
@@ -2075,87 +2551,74 @@ bool saveScreenshotBMP() {
 // 🎵 CHATGPT BEEPER SOLUTION - V3.134
 // ═══════════════════════════════════════════════════════════
 
-// Легкая огибающая для устранения кликов на стыках
-static inline void applyEnvelope(int16_t* dst, int n) {
-  for (int i = 0; i < ENV_NS && i < n; ++i) {
-    float a = float(i) / ENV_NS;
-    int j = n - 1 - i;
-    dst[i]  = int16_t(dst[i]  * a);
-    dst[j]  = int16_t(dst[j]  * a);
-  }
-}
-
-// Конвертация: accum[312] → PCM[320] @16kHz
-// Duty-cycle + линейная интерполяция = плавный звук!
-static void accumToPCM(const uint16_t* accum312, int16_t* out320) {
-  // Предрасчёт duty [0..1] для 312 строк
-  static float duty[312];
-  for (int i = 0; i < 312; ++i) {
-    duty[i] = float(accum312[i]) / float(TSTATES_LINE_CONST);  // 0..1
-  }
-  
-  // Ресемплинг 312 → 320 с интерполяцией
-  for (int s = 0; s < SPPF; ++s) {
-    float pos = (float(s) * (312 - 1)) / float(SPPF - 1);  // в строках
-    int i0    = (int)pos;
-    int i1    = (i0 + 1 < 312) ? (i0 + 1) : i0;
-    float frac = pos - i0;
-    float d    = duty[i0] * (1.0f - frac) + duty[i1] * frac;  // интерполяция
-    float v    = (2.0f * d - 1.0f);  // duty → [-1..+1]
-    out320[s]  = int16_t(v * AMP);
-  }
-  
-  applyEnvelope(out320, SPPF);
-}
-
 // ═══ AUDIO TASK: НЕПРЕРЫВНЫЙ ПОТОК! ═══
 void Task_Audio(void* pv) {
+  beeperSynth.init();     // V3.144: таблица BLIT (32 фазы × 16 отсчётов)
+  beeperSynth.setEarGain(TAPE_GAIN_Q8);  // V3.150: звук ленты
+  
+  int32_t fillAvgQ8 = AUDIO_TARGET_FILL << 8;  // V3.146: сглаженное заполнение (Q8)
+  
   while (true) {
     // 1) Текущий буфер
     int16_t* curr = useA ? bufA : bufB;
     
-    // 2) Забираем данные кадра от эмулятора
-    uint16_t localAccum[312];
+    // 2) Забираем кадр от эмулятора (V3.145: из кольца, без копирования)
+    const AudioFrame* frame = audioRing.beginRead();  // nullptr → underrun
+    
+    frameTelemetry.noteAudioPull(frame != nullptr);  // V3.142: опоздание звука
     
-    if (frameReady) {
-      noInterrupts();
-      for (int i = 0; i < 312; ++i) localAccum[i] = accumFrame[i];
-      frameReady = false;
-      interrupts();
+    int samples = SPPF;
+    
+    if (frame) {
+      // ═══ V3.146: DRC - заполнение кольца → длина кадра ═══
+      // Мало кадров (эмулятор отстаёт) → кадр длиннее, играем медленнее
+      // Много кадров → кадр короче, догоняем
+      int fillNow = audioRing.fill();  // Включая текущий кадр
       
-      // Применяем volume (масштабируем AMP)
-      // Генерируем PCM с учетом громкости
-      static float duty[312];
-      for (int i = 0; i < 312; ++i) {
-        duty[i] = float(localAccum[i]) / float(TSTATES_LINE_CONST);
-      }
+      // V3.149: возраст кадра в кольце + заполнение
+      audioStats.notePlayed((uint32_t)esp_timer_get_time() - frame->submitUs, fillNow);
       
-      // Volume: 0-10 → 0.0-1.0
-      float volScale = soundEnabled ? (float(soundVolume) / 10.0f) : 0.0f;
+      fillAvgQ8 += ((fillNow << 8) - fillAvgQ8) >> 3;
+      int drc = ((AUDIO_TARGET_FILL << 8) - fillAvgQ8) >> 7;  // ±1 сэмпл на пол-кадра ошибки
+      if (drc > AUDIO_DRC_MAX) drc = AUDIO_DRC_MAX;
+      if (drc < -AUDIO_DRC_MAX) drc = -AUDIO_DRC_MAX;
       
-      for (int s = 0; s < SPPF; ++s) {
-        float pos = (float(s) * (312 - 1)) / float(SPPF - 1);
-        int i0    = (int)pos;
-        int i1    = (i0 + 1 < 312) ? (i0 + 1) : i0;
-        float frac = pos - i0;
-        float d    = duty[i0] * (1.0f - frac) + duty[i1] * frac;
-        float v    = (2.0f * d - 1.0f);  // duty → [-1..+1]
-        curr[s]  = int16_t(v * AMP * volScale);
-      }
+      // V3.144: band-limited синтез по фронтам (без огибающей - поток непрерывный)
+      // V3.150: beeper и лента (EAR) - один синтез, одна громкость
+      int volume = soundEnabled ? soundVolume : 0;
+      samples = SPPF + drc;
+      beeperSynth.renderFrame(frame->edges, frame->count, frame->startLevel, frame->frameLen,
+                              curr, samples, volume);
       
-      applyEnvelope(curr, SPPF);
+      // V3.148: AY поверх beeper (ничего не стоит, пока в AY не писали)
+      // ayRegs - состояние на начало кадра, записи лога идут после него
+      if (frame->ayResync) ayChip.syncRegs(frame->ayRegs);
+      ayChip.renderFrame(frame->ay, frame->ayCount, frame->frameLen, curr, samples, volume);
+      audioRing.endRead();
+      
+      // V3.146: слот свободен → будим эмулятор
+      if (emuTaskHandle) xTaskNotifyGive(emuTaskHandle);
       
     } else {
       // Тишина (эмулятор не успел)
       memset(curr, 0, sizeof(int16_t) * SPPF);
+      audioStats.noteSilence();  // V3.149
     }
     
-    // 3) Играть (ВАЖНО: количество СЭМПЛОВ, не байтов!)
-    M5Cardputer.Speaker.playRaw(curr, SPPF, SAMPLE_RATE, false);
+    // V3.151: копия финального PCM в рекордер (lock-free, без ожидания)
+    wavRecorder.push(curr, samples);
     
-    // 4) Ждем окончания воспроизведения
-    while (M5Cardputer.Speaker.isPlaying()) {
-      vTaskDelay(1 / portTICK_PERIOD_MS);
+    if (audioUseI2S) {
+      // 3+4) V3.147: I2S DMA - блокируемся пока в DMA нет места (без опроса)
+      i2sBeeper.write(curr, samples);
+    } else {
+      // 3) Играть (ВАЖНО: количество СЭМПЛОВ, не байтов!)
+      M5Cardputer.Speaker.playRaw(curr, samples, SAMPLE_RATE, false);
+      
+      // 4) Ждем окончания воспроизведения
+      while (M5Cardputer.Speaker.isPlaying()) {
+        vTaskDelay(1 / portTICK_PERIOD_MS);
+      }
     }
     
     useA = !useA;
@@ -2163,12 +2626,46 @@ void Task_Audio(void* pv) {
 }
 
 // ═══ API ДЛЯ ЭМУЛЯТОРА ═══
-// Вызывать ОДИН РАЗ на кадр (50 Hz)
-void ZX_BeeperSubmitFrame(const uint16_t* accum312) {
-  noInterrupts();
-  for (int i = 0; i < 312; ++i) accumFrame[i] = accum312[i];
-  frameReady = true;
-  interrupts();
+// V3.150: Закрыть аудио кадр эмулятора: фронты/записи AY с t < frameLen
+// уходят в кольцо, хвост переносится (ZXSpectrum::carryAudioFrame).
+// loop(): frameLen = весь кадр runForFrame; TapeListener: каждые 69888 t-states.
+void ZX_SubmitAudioFrame(ZXSpectrum* spec, uint32_t frameLen) {
+  // V3.158: turbo - звук выключен, кадр просто закрываем (лента тоже сюда)
+  if (turboMode) {
+    spec->carryAudioFrame(frameLen);
+    return;
+  }
+  int edges = spec->audioEdgesBefore(frameLen);
+  int writes = spec->ayWritesBefore(frameLen);
+  ZX_BeeperSubmitEdges(spec->beeperEdges, edges, spec->beeperStartLevel, frameLen,
+                       spec->ayWrites, writes, spec->ayResync ? spec->ayResyncRegs : nullptr);
+  spec->carryAudioFrame(frameLen);
+}
+
+// V3.144: Кадр фронтов: t-states фронтов beeper (V3.150: и EAR) от начала кадра
+// V3.145: кольцо полно → кадр отбрасывается (overrun), прерывания не трогаем
+// V3.148: + записи AY кадра; ayResyncRegs != nullptr → регистры на начало кадра (сброс,
+// переполнение лога в прошлом кадре), лог кадра - поверх них
+void ZX_BeeperSubmitEdges(const uint32_t* edges, int count, uint8_t startLevel, uint32_t frameLen,
+                          const AYWrite* ayWrites, int ayCount, const uint8_t* ayResyncRegs) {
+  if (count > AUDIO_MAX_EDGES) count = AUDIO_MAX_EDGES;
+  if (ayCount > AUDIO_MAX_AY_WRITES) ayCount = AUDIO_MAX_AY_WRITES;
+  AudioFrame* frame = audioRing.beginWrite();
+  if (!frame) {
+    audioStats.noteOverwrite();  // V3.149
+    return;
+  }
+  frame->count = count;
+  frame->startLevel = startLevel;
+  frame->frameLen = frameLen;
+  memcpy(frame->edges, edges, count * sizeof(uint32_t));
+  frame->ayCount = ayCount;
+  if (ayCount) memcpy(frame->ay, ayWrites, ayCount * sizeof(AYWrite));
+  frame->ayResync = (ayResyncRegs != nullptr);
+  if (ayResyncRegs) memcpy(frame->ayRegs, ayResyncRegs, sizeof(frame->ayRegs));
+  frame->submitUs = (uint32_t)esp_timer_get_time();
+  audioRing.commitWrite();
+  frameTelemetry.noteAudioSubmit();
 }
 
 // Обработка клавиатуры M5Cardputer → ZX Spectrum
@@ -2176,7 +2673,10 @@ void handleKeyboard() {
   M5Cardputer.update();
   
   // ВСЕГДА обрабатываем клавиатуру (не только при isChange)
+  // V3.153: хоткеи - каждый вызов; матрица ZX - только при isChange (см. конец)
   Keyboard_Class::KeysState status = M5Cardputer.Keyboard.keysState();
+  bool keyboardChanged = M5Cardputer.Keyboard.isChange();
+  keymap.beginScan();
   
   // ===== ДИАГНОСТИКА: Выводим ВСЁ что видит клавиатура =====
   static bool diagnostic = false;  // Отключена
@@ -2261,8 +2761,10 @@ void handleKeyboard() {
         externalDisplay.print("RESET...");
         delay(500);
         
-        // Перезагружаем эмулятор
-        spectrum->reset();
+        // Перезагружаем эмулятор (V3.157: из снимка готовой ROM)
+        endInputReplaySession();  // V3.159: запись/повтор с этого места бессмысленны
+        rewindBuffer.clear();     // V3.161
+        spectrum->warmReset();
         
         // Закрываем все подменю и открываем главное меню
         showLoadGameMenu = false;
@@ -2428,6 +2930,8 @@ void handleKeyboard() {
         externalDisplay.print("Loading...");
         
         // Загружаем файл
+        endInputReplaySession();  // V3.159: новая машина - запись/повтор закончены
+        rewindBuffer.clear();     // V3.161: история прошлой игры не нужна
         bool success = false;
         if (browserFilter == ".SNA") {
           success = loadSNAFile(fileName);
@@ -2439,6 +2943,7 @@ void handleKeyboard() {
         
         if (success) {
           // Игра загружена - закрываем браузер и запускаем!
+          loadGameJoystickMode(fileName);  // V3.154: режим джойстика этой игры
           showBrowser = false;
           showMenu = false;
           emulatorPaused = false;
@@ -2518,6 +3023,8 @@ void handleKeyboard() {
       externalDisplay.print("Loading...");
       
       // Загружаем файл
+      endInputReplaySession();  // V3.159: новая машина - запись/повтор закончены
+      rewindBuffer.clear();     // V3.161: история прошлой игры не нужна
       bool success = false;
       if (browserFilter == ".SNA") {
         success = loadSNAFile(fileName);
@@ -2529,6 +3036,7 @@ void handleKeyboard() {
       
       if (success) {
         // Игра загружена - закрываем браузер и запускаем!
+        loadGameJoystickMode(fileName);  // V3.154: режим джойстика этой игры
         showBrowser = false;
         showMenu = false;
         emulatorPaused = false;
@@ -2548,9 +3056,7 @@ void handleKeyboard() {
     }
     
     // Если браузер открыт - не обрабатываем ZX клавиши!
-    for (int i = 0; i < 8; i++) {
-      speckey[i] = 0xFF;
-    }
+    memset(keyboardRows, 0xFF, sizeof(keyboardRows));
     return;
   }
   
@@ -2705,9 +3211,7 @@ void handleKeyboard() {
     }
     
     // Если меню открыто, но не выполнили действие - выходим
-    for (int i = 0; i < 8; i++) {
-      speckey[i] = 0xFF;
-    }
+    memset(keyboardRows, 0xFF, sizeof(keyboardRows));
     return;
   }
   
@@ -2742,8 +3246,10 @@ void handleKeyboard() {
       externalDisplay.print("RESET...");
       delay(500);
       
-      // Сброс эмулятора
-      spectrum->reset_spectrum();
+      // Сброс эмулятора (V3.157: из снимка готовой ROM)
+      endInputReplaySession();  // V3.159
+      rewindBuffer.clear();     // V3.161
+      spectrum->warmReset();
       
       // ✅ V3.134: Открываем меню после сброса
       showMenu = true;
@@ -2891,21 +3397,25 @@ void handleKeyboard() {
       // OPT + J → ПЕРЕКЛЮЧЕНИЕ JOYSTICK (вкл/выкл)
       if ((key == 'j' || key == 'J') && (millis() - lastZoomTime > 200)) {
         joystickEnabled = !joystickEnabled;
-        Serial.printf("🕹️  Joystick→Keys: %s\n", joystickEnabled ? "ENABLED" : "DISABLED");
+        Serial.printf("🕹️  Joystick: %s\n", joystickEnabled ? "ENABLED" : "DISABLED");
         
         // Показываем уведомление на экране (если не в меню/браузере)
+        // V3.138: через overlay (без прямого рисования поверх кадра)
         if (!showMenu && !showBrowser) {
-          externalDisplay.fillRect(40, 60, 160, 20, BLACK);
-          externalDisplay.drawRect(40, 60, 160, 20, WHITE);
-          externalDisplay.setTextSize(1);
-          externalDisplay.setTextColor(joystickEnabled ? TFT_GREEN : TFT_RED);
-          externalDisplay.setCursor(50, 65);
-          externalDisplay.print(joystickEnabled ? "Joystick: ON" : "Joystick: OFF");
+          showNotification(joystickEnabled ? "Joystick: ON" : "Joystick: OFF",
+                           joystickEnabled ? TFT_GREEN : TFT_RED, 1000);
         }
         lastZoomTime = millis();
         skipZXKeys = true;
       }
       
+      // OPT + K → РЕЖИМ ДЖОЙСТИКА (V3.154): QAOP → KEMPSTON → SINCLAIR1/2 → CURSOR
+      if ((key == 'k' || key == 'K') && (millis() - lastZoomTime > 200)) {
+        cycleJoystickMode();
+        lastZoomTime = millis();
+        skipZXKeys = true;
+      }
+      
       // OPT + [+] (=) → VOLUME UP
       if ((key == '=' || key == '+') && (millis() - lastZoomTime > 200)) {
         if (soundVolume < 10) soundVolume++;
@@ -2936,6 +3446,95 @@ void handleKeyboard() {
         skipZXKeys = true;
       }
       
+      // OPT + H → HUD ТЕЛЕМЕТРИИ (V3.142)
+      if ((key == 'h' || key == 'H') && (millis() - lastZoomTime > 200)) {
+        frameTelemetry.hudEnabled = !frameTelemetry.hudEnabled;
+        Serial.printf("⏱️  Telemetry HUD: %s\n", frameTelemetry.hudEnabled ? "ON" : "OFF");
+        lastZoomTime = millis();
+        skipZXKeys = true;
+      }
+      
+      // OPT + T → CSV ПОТОК ТЕЛЕМЕТРИИ по USB (V3.142)
+      if ((key == 't' || key == 'T') && (millis() - lastZoomTime > 200)) {
+        frameTelemetry.setStreaming(!frameTelemetry.isStreaming());
+        if (!showMenu && !showBrowser) {
+          showNotification(frameTelemetry.isStreaming() ? "Telemetry stream: ON" : "Telemetry stream: OFF",
+                           frameTelemetry.isStreaming() ? TFT_GREEN : TFT_RED, 1000);
+        }
+        lastZoomTime = millis();
+        skipZXKeys = true;
+      }
+      
+      // OPT + R → ЗАПИСЬ ЗВУКА В WAV (V3.151)
+      if ((key == 'r' || key == 'R') && (millis() - lastZoomTime > 200)) {
+        toggleRecording();
+        lastZoomTime = millis();
+        skipZXKeys = true;
+      }
+      
+      // OPT + I → ПРОФИЛЬ РАСКЛАДКИ (V3.153): QAOP → CURSOR → TYPING
+      if ((key == 'i' || key == 'I') && (millis() - lastZoomTime > 200)) {
+        keymap.nextProfile();
+        Serial.printf("⌨️  Keymap profile: %s\n", keymap.profileName());
+        if (!showMenu && !showBrowser) {
+          char msg[32];
+          snprintf(msg, sizeof(msg), "Keys: %s", keymap.profileName());
+          showNotification(msg, TFT_CYAN, 1000);
+        }
+        lastZoomTime = millis();
+        skipZXKeys = true;
+      }
+      
+      // OPT + F → TURBO / FAST-FORWARD (V3.158)
+      if ((key == 'f' || key == 'F') && (millis() - lastZoomTime > 200)) {
+        toggleTurbo();
+        lastZoomTime = millis();
+        skipZXKeys = true;
+      }
+      
+      // OPT + E → ЗАПИСЬ ВВОДА (V3.159)
+      if ((key == 'e' || key == 'E') && (millis() - lastZoomTime > 200)) {
+        toggleInputRecording();
+        lastZoomTime = millis();
+        skipZXKeys = true;
+      }
+      
+      // OPT + Y → ПОВТОР ПОСЛЕДНЕЙ ЗАПИСИ ВВОДА (V3.159)
+      if ((key == 'y' || key == 'Y') && (millis() - lastZoomTime > 200)) {
+        toggleInputReplay();
+        lastZoomTime = millis();
+        skipZXKeys = true;
+      }
+      
+      // OPT + S / L → БЫСТРОЕ СОХРАНЕНИЕ / ЗАГРУЗКА СЛОТА (V3.160)
+      if ((key == 's' || key == 'S') && (millis() - lastZoomTime > 200)) {
+        quickSave();
+        lastZoomTime = millis();
+        skipZXKeys = true;
+      }
+      if ((key == 'l' || key == 'L') && (millis() - lastZoomTime > 200)) {
+        quickLoad();
+        lastZoomTime = millis();
+        skipZXKeys = true;
+      }
+      
+      // OPT + 1..4 → ВЫБОР СЛОТА (V3.160)
+      if (key >= '1' && key < '1' + SaveStates::SLOT_COUNT && (millis() - lastZoomTime > 200)) {
+        saveSlot = key - '1';
+        char msg[16];
+        snprintf(msg, sizeof(msg), "Slot %d", saveSlot + 1);
+        showNotification(msg, TFT_CYAN, 800);
+        lastZoomTime = millis();
+        skipZXKeys = true;
+      }
+      
+      // OPT + B → ПЕРЕМОТКА НА СЕКУНДУ НАЗАД (V3.161)
+      if ((key == 'b' || key == 'B') && (millis() - lastZoomTime > 200)) {
+        rewindStep();
+        lastZoomTime = millis();
+        skipZXKeys = true;
+      }
+      
       // OPT + M → MUTE ON/OFF
       if ((key == 'm' || key == 'M') && (millis() - lastZoomTime > 200)) {
         soundEnabled = !soundEnabled;
@@ -3039,95 +3638,61 @@ void handleKeyboard() {
   // ═══ ОБРАБОТКА ZX SPECTRUM КЛАВИШ ═══
   
   // ⚠️ КРИТИЧНО: Если нажат OPT - это СИСТЕМНАЯ кнопка, НЕ передаем клавиши в ZX!
-  if (status.opt) {
+  // ⚠️ ВАЖНО: Если обработали ZOOM/PAN, НЕ передаем клавиши в ZX Spectrum!
+  if (status.opt || skipZXKeys) {
     // Отпускаем все клавиши ZX Spectrum
-    for (int i = 0; i < 8; i++) {
-      speckey[i] = 0xFF;
-    }
+    memset(keyboardRows, 0xFF, sizeof(keyboardRows));
     return;  // Выходим, не обрабатывая ZX клавиши
   }
   
-  // ⚠️ ВАЖНО: Если обработали ZOOM/PAN, НЕ передаем клавиши в ZX Spectrum!
-  if (skipZXKeys) {
-    // Отпускаем все клавиши ZX Spectrum
-    for (int i = 0; i < 8; i++) {
-      speckey[i] = 0xFF;
-    }
-    return;  // Выходим из функции, не обрабатывая ZX клавиши
+  // V3.153: Матрицу перестраиваем только если клавиатура изменилась
+  // (или прошлый вызов вышел раньше - меню, Opt, хоткей: строки сброшены)
+  if (keymap.rebuildDue(keyboardChanged)) {
+    buildKeyboardRows(status);  // V3.155: + проба задержки
   }
-  
-  // Сначала отпускаем ВСЕ клавиши
+}
+
+// V3.153: Опубликовать матрицу ZX одной записью на строку
+static void publishKeyMatrix() {
   for (int i = 0; i < 8; i++) {
-    speckey[i] = 0xFF;
+    speckey[i] = keyboardRows[i];
   }
-  
-  // ДОПОЛНИТЕЛЬНАЯ ДИАГНОСТИКА: показываем КАЖДЫЙ кадр (если клавиша нажата)
-  static int diagFrames = 0;
-  if (diagnostic && (status.shift || !status.word.empty())) {
-    if (diagFrames++ < 50) {  // Только первые 50 кадров
-      Serial.printf("Frame #%d: shift=%d word.size=%d\n", 
-                    diagFrames, status.shift, status.word.size());
-    }
-  }
-  
-  // Теперь нажимаем только те, которые РЕАЛЬНО нажаты СЕЙЧАС
-  
-  // ENTER
-  if (status.enter) spectrum->updateKey(SPECKEY_ENTER, 1);
-  
-  // SPACE
-  if (status.space) spectrum->updateKey(SPECKEY_SPACE, 1);
-  
-  // SHIFT → CAPS SHIFT (только если явно нажат shift!)
-  if (status.shift) {
-    spectrum->updateKey(SPECKEY_SHIFT, 1);
-    if (diagnostic) Serial.println("  >>> SHIFT PRESSED <<<");
+}
+
+// V3.155: Новое направление/огонь джойстика тоже запускает пробу задержки
+static void noteJoystickInput() {
+  uint8_t bits = spectrum->joystickBits();
+  if (bits & ~lastJoystickBits) {
+    inputLatency.noteInput(micros(), emuFrameNo);
   }
-  
-  // Fn → SYMBOL SHIFT
-  if (status.fn) spectrum->updateKey(SPECKEY_SYMB, 1);
-  
-  // BACKSPACE → DELETE (CAPS SHIFT + 0)
-  if (status.del) {
-    spectrum->updateKey(SPECKEY_SHIFT, 1);
-    spectrum->updateKey(SPECKEY_0, 1);
+  lastJoystickBits = bits;
+}
+
+// V3.155: Вызывается из runForFrame() на строке INPUT_LATCH_LINE.
+// Хоткеи и меню остаются в handleKeyboard() - здесь только матрица ZX.
+static void latchInputMidFrame(void* ctx) {
+  if (!inputLatchArmed) return;
+  Keyboard_Class& kb = M5Cardputer.Keyboard;
+  kb.updateKeyList();
+  kb.updateKeysState();
+  const Keyboard_Class::KeysState& status = kb.keysState();
+  if (status.opt) {
+    memset(keyboardRows, 0xFF, sizeof(keyboardRows));  // Opt = системная клавиша
+  } else {
+    buildKeyboardRows(status);
   }
-  
-  // Обрабатываем буквы и цифры из word[]
-  for (char c : status.word) {
-    // ═══ СТРЕЛКИ ДЛЯ ИГР (QAOP - стандартная схема ZX Spectrum) ═══
-    // ; . , / - те же кнопки что и для PAN, но БЕЗ Opt
-    if (c == ';') {
-      // ; → Q (вверх)
-      spectrum->updateKey(SPECKEY_Q, 1);
-      continue;  // Не обрабатывать дальше
-    } else if (c == '.') {
-      // . → A (вниз)
-      spectrum->updateKey(SPECKEY_A, 1);
-      continue;
-    } else if (c == ',') {
-      // , → O (влево)
-      spectrum->updateKey(SPECKEY_O, 1);
-      continue;
-    } else if (c == '/') {
-      // / → P (вправо)
-      spectrum->updateKey(SPECKEY_P, 1);
-      continue;
-    }
-    
-    // Преобразуем заглавные в строчные (Shift обрабатывается отдельно)
-    if (c >= 'A' && c <= 'Z') {
-      c = c - 'A' + 'a';  // A→a, B→b, etc.
-    }
-    
-    // Проверяем letterToSpecKeys для символов
-    auto it = letterToSpecKeys.find(c);
-    if (it != letterToSpecKeys.end()) {
-      // Нашли маппинг - нажимаем все нужные клавиши
-      for (SpecKeys key : it->second) {
-        spectrum->updateKey(key, 1);
-      }
-    }
+  publishKeyMatrix();
+  inputReplay.latch(spectrum);  // V3.159
+  noteJoystickInput();  // Сам байт z80_in читает напрямую - только проба
+}
+
+// V3.140: Ждать durationUs, отдавая свободную шину SD задачам
+static void idleFor(uint32_t durationUs) {
+  uint32_t deadline = micros() + durationUs;
+  busScheduler.runIdle(deadline);
+  int32_t remaining = (int32_t)(deadline - micros());
+  if (remaining > 0) {
+    delayMicroseconds(remaining);
   }
 }
 
@@ -3135,6 +3700,7 @@ void loop() {
   static unsigned long lastFrameTime = 0;
   static int renderCounter = 0;
   unsigned long frameStart = micros();
+  frameTelemetry.beginFrame();  // V3.142
   
   // ═══ V3.137: ПОКАЗЫВАЕМ УВЕДОМЛЕНИЕ О ПАПКЕ (ОДИН РАЗ!) ═══
   if (!folderNotificationShown && gameFolderStatus >= 0) {
@@ -3152,7 +3718,10 @@ void loop() {
   handleKeyboard();
   
   // Обновляем джойстик → клавиши (если включен и не в меню/браузере)
-  updateJoystickKeys();
+  updateJoystickRouting();  // V3.154: джойстик читается из портов, не из матрицы
+  publishKeyMatrix();  // V3.153: клавиатура → speckey
+  noteJoystickInput();  // V3.155: проба задержки
+  frameTelemetry.mark(STAGE_INPUT);
   
   // ЕСЛИ МЕНЮ ИЛИ БРАУЗЕР ОТКРЫТЫ (ПАУЗА) - НЕ ЗАПУСКАЕМ ЭМУЛЯЦИЮ!
   if (emulatorPaused || showBrowser || showInformation) {
@@ -3163,55 +3732,137 @@ void loop() {
         renderScreen();  // ✅ Рисуем экран + плашку "PAUSE"
         renderCounter = 0;
       }
-      delay(50);
+      idleFor(50000);  // V3.140: пауза = свободная шина для SD задач
       return;
     }
     
     // Меню/Браузер/Information - просто ждём
-    delay(50);  // Экономим CPU
+    // V3.139: Меню рисует поверх кадра → после выхода нужна полная перерисовка
+    zxScreen.invalidate();
+    idleFor(50000);  // Экономим CPU
     return;
   }
   
   // Запускаем эмуляцию одного кадра (69888 tstates)
-  // runForFrame() заполняет accumBuffer (312 значений 0-224)
-  int cycles = spectrum->runForFrame(accumBuffer);
-  
-  // ✅ V3.134: Отправляем данные в Audio Task (ChatGPT!)
-  ZX_BeeperSubmitFrame(accumBuffer);
+  // V3.144: runForFrame() собирает фронты beeper (beeperEdges[])
+  // V3.159: запись ввода снимает его здесь, повтор - подставляет свой
+  inputReplay.frameStart(spectrum);
+  
+  // V3.155: + повторный захват ввода на строке INPUT_LATCH_LINE (перед INT)
+  inputLatchArmed = true;
+  int cycles = spectrum->runForFrame();
+  inputLatchArmed = false;
+  emuFrameNo++;
+  if (inputReplay.frameEnd(spectrum)) {
+    onInputReplayEnd();  // V3.159: повтор закончился / буфер записи полон
+  }
+  rewindBuffer.frameDone(spectrum);  // V3.161: точка перемотки каждые 5 кадров
+  frameTelemetry.mark(STAGE_EMU);
+  
+  // ✅ V3.144: Отправляем фронты кадра в Audio Task (BLEP синтез)
+  // ✅ V3.148: + лог записей AY (синтез тоже в Audio Task)
+  // V3.158: в turbo кадр отбрасывается внутри (звук выключен)
+  ZX_SubmitAudioFrame(spectrum, spectrum->frameTstates);
+  frameTelemetry.mark(STAGE_AUDIO);
   
   frameCount++;
   intCount++;
   
   // Рендерим экран каждый 5й frame (баланс между FPS и качеством)
-  renderCounter++;
-  if (renderCounter >= 5) {
+  // V3.158: в turbo - по настенным часам (10 Гц), сколько бы кадров ни прошло
+  if (turboMode) {
+    if (turboRenderDue()) {
+      renderScreen();
+    }
+  } else if (++renderCounter >= 5) {
     renderScreen();
     renderCounter = 0;
   }
 
-  // Throttling для 50 FPS (20000 микросекунд = 20ms = 50 FPS)
-  unsigned long frameTime = micros() - frameStart;
-  if (frameTime < 20000) {
-    delayMicroseconds(20000 - frameTime);
+  // ═══ V3.146: ТЕМП = ЧАСЫ ЗВУКА (вместо delayMicroseconds) ═══
+  // Кольцо заполнено до цели → остаток кадра отдаём SD задачам (V3.140),
+  // потом БЛОКИРУЕМСЯ до уведомления Audio Task "слот освободился".
+  // V3.158: turbo - темпа нет, следующий кадр сразу; SD задачам короткое окно
+  if (turboMode) {
+    busScheduler.runIdle(micros() + 2000);
+    frameTelemetry.mark(STAGE_SD);
+  } else if (audioRing.fill() >= AUDIO_TARGET_FILL) {
+    busScheduler.runIdle(frameStart + 20000);
+    frameTelemetry.mark(STAGE_SD);
+    while (audioRing.fill() >= AUDIO_TARGET_FILL) {
+      // Таймаут 2 кадра: Audio Task завис → не вешаем эмулятор
+      if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(40)) == 0) break;
+    }
   }
+  frameTelemetry.mark(STAGE_SLEEP);
+  frameTelemetry.noteAudioState(audioRing.fill(), audioStats.lastFrameAgeUs());  // V3.149
+  frameTelemetry.endFrame();
+  frameTelemetry.flushStream();  // V3.142: CSV (если включён)
 
   // Телеметрия каждую секунду (используем mid-frame snapshot!)
   unsigned long currentTime = millis();
   if (currentTime - lastStatsTime >= 1000) {
     float fps = frameCount / ((currentTime - lastStatsTime) / 1000.0);
     float intRate = intCount / ((currentTime - lastStatsTime) / 1000.0);
-    
-    Serial.printf("FPS: %.2f | INT: %.2f/s | PC: 0x%04X | SP: 0x%04X | IM: %d | IFF1: %d | Heap: %d\n",
-                  fps, intRate, 
-                  spectrum->getHudPC(),
-                  spectrum->getHudSP(),
-                  spectrum->getHudIM(),
-                  spectrum->getHudIFF1(),
-                  ESP.getFreeHeap());
-    
+    turboSpeedX10 = turboMode ? (uint32_t)(fps / 5.0f + 0.5f) : 0;  // V3.158: кратность = fps / 50
+    
+    // V3.140: Занятость шины SPI3 (дисплей / SD / простой)
+    BusStats bus = busScheduler.takeStats();
+    
+    // V3.149: окно аудио статистики (его же показывает HUD)
+    audioStats.takeWindow(audioWindow);
+    inputLatency.takeWindow(inputLatencyWindow);  // V3.155
+    RewindStats rewind;
+    rewindBuffer.takeStats(rewind);  // V3.161
+    
+    // V3.142: при CSV потоке текстовую статистику не печатаем (не ломаем CSV)
+    if (!frameTelemetry.isStreaming()) {
+      Serial.printf("FPS: %.2f | INT: %.2f/s | PC: 0x%04X | SP: 0x%04X | IM: %d | IFF1: %d | Heap: %d\n",
+                    fps, intRate, 
+                    spectrum->getHudPC(),
+                    spectrum->getHudSP(),
+                    spectrum->getHudIM(),
+                    spectrum->getHudIFF1(),
+                    ESP.getFreeHeap());
+      
+      // V3.145: Аудио кольцо (всего с запуска)
+      // V3.149: + возраст кадра и заполнение за окно (min/avg/max), idle = пауза
+      Serial.printf("AUDIO: played %u | silence %u | overwrites %u | idle %u | age %u/%u/%u us | fill %u/%u.%u/%u of %d [%u %u %u %u %u]\n",
+                    audioStats.framesPlayed(), audioStats.silenceInserted(),
+                    audioStats.overwriteCount(), audioStats.idleFrames(),
+                    audioWindow.ageMinUs, audioWindow.ageAvgUs, audioWindow.ageMaxUs,
+                    audioWindow.fillMin, audioWindow.fillAvgX10 / 10, audioWindow.fillAvgX10 % 10,
+                    audioWindow.fillMax, audioRing.capacity(),
+                    audioWindow.fillHist[0], audioWindow.fillHist[1], audioWindow.fillHist[2],
+                    audioWindow.fillHist[3], audioWindow.fillHist[4]);
+      
+      // V3.155: нажатие → первый изменённый пиксель на дисплее
+      // (только нажатия на стоящем экране; на анимированном - skipped)
+      if (inputLatencyWindow.samples > 0 || inputLatencyWindow.timeouts > 0 || inputLatencyWindow.skipped > 0) {
+        Serial.printf("INPUT: latency %u/%u/%u us (min/avg/max) | %u frames avg | %u samples | %u no-change | %u skipped (screen animating) | latch line %d\n",
+                      inputLatencyWindow.minUs, inputLatencyWindow.avgUs, inputLatencyWindow.maxUs,
+                      inputLatencyWindow.avgFrames, inputLatencyWindow.samples,
+                      inputLatencyWindow.timeouts, inputLatencyWindow.skipped, INPUT_LATCH_LINE);
+      }
+      
+      // V3.161: стоимость точек перемотки за окно
+      if (rewind.captures > 0) {
+        Serial.printf("REWIND: %u points | capture %u/%u us (avg/max) | %u B, %u blocks avg | %.1f s buffered\n",
+                      rewind.captures, rewind.avgUs, rewind.maxUs,
+                      rewind.avgBytes, rewind.avgBlocks, rewindBuffer.seconds());
+      }
+      
+      if (bus.windowUs > 0) {
+        uint32_t dispPct = (uint32_t)((uint64_t)bus.displayUs * 100 / bus.windowUs);
+        uint32_t sdPct = (uint32_t)((uint64_t)bus.sdUs * 100 / bus.windowUs);
+        Serial.printf("BUS: display %u%% | SD %u%% (%u B, %u chunks, %u deferred) | idle %u%% | jobs: %u\n",
+                      dispPct, sdPct, bus.sdBytes, bus.chunks, bus.deferred,
+                      (dispPct + sdPct < 100) ? 100 - dispPct - sdPct : 0, bus.pending);
+      }
+    }
     
     // Проверяем критерии (только warning для INT rate, IM=0 нормально в начале)
-    if (intRate < 45 || intRate > 55) {
+    if ((intRate < 45 || intRate > 55) && !frameTelemetry.isStreaming() && !turboMode) {
       Serial.println("⚠️  WARNING: INT rate not ~50/s!");
     }
 
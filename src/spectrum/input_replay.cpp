@@ -0,0 +1,278 @@
+#include "input_replay.h"
+#include <esp_heap_caps.h>
+
+static const uint8_t REPLAY_MAGIC[4] = {'Z', 'X', 'I', 'R'};
+static const size_t FRAME_MAX_BYTES = 1 + 9 + 9 + 2 + 2;   // Тег + 2 состояния + подпись
+static const uint8_t JOY_MASK = (1 << ZXSpectrum::JOY_BITS) - 1;  // Байт джойстика из файла
+
+static inline void put16(uint8_t* p, uint16_t v) {
+  p[0] = v & 0xFF;
+  p[1] = v >> 8;
+}
+
+static inline void put32(uint8_t* p, uint32_t v) {
+  put16(p, v & 0xFFFF);
+  put16(p + 2, v >> 16);
+}
+
+static inline uint16_t get16(const uint8_t* p) {
+  return p[0] | (p[1] << 8);
+}
+
+static inline uint32_t get32(const uint8_t* p) {
+  return get16(p) | ((uint32_t)get16(p + 2) << 16);
+}
+
+InputReplay::InputReplay()
+  : state(IDLE), buf(nullptr), capacity(0), pos(0), tagPos(0), frameNo(0), totalFrames(0),
+    lastReads(0), lastTsum(0), joyByte(0), liveJoystick(nullptr),
+    savedJoystickMode(JOY_QAOP), savedLatchLine(-1) {
+  memset(&last, 0xFF, sizeof(last));
+  lastResult = {0, 0, -1};
+}
+
+InputReplay::~InputReplay() {
+  releaseBuffer();
+}
+
+void InputReplay::releaseBuffer() {
+  if (buf) free(buf);
+  buf = nullptr;
+  capacity = 0;
+  pos = 0;
+}
+
+// ═══ ЗАПИСЬ ═══
+
+bool InputReplay::startRecording(ZXSpectrum* spectrum) {
+  if (state != IDLE) return false;
+  if (!snapshot.capture(spectrum)) return false;
+
+  buf = (uint8_t*)heap_caps_malloc(MAX_BYTES, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  if (!buf) {
+    Serial.println("❌ Replay: no PSRAM for recording");
+    return false;
+  }
+  capacity = MAX_BYTES;
+
+  // Заголовок (frames допишет finishRecording) + снимок
+  memcpy(buf, REPLAY_MAGIC, 4);
+  buf[4] = VERSION;
+  buf[5] = (uint8_t)spectrum->joystickMode;
+  put16(buf + 6, (uint16_t)(int16_t)spectrum->inputLatchLine);
+  put32(buf + 8, 0);
+  put32(buf + 12, MachineSnapshot::SERIAL_SIZE);
+  snapshot.serialize(buf + HEADER_SIZE);
+  snapshot.release();  // Образ уже в буфере - 48K копия не нужна
+  pos = HEADER_SIZE + MachineSnapshot::SERIAL_SIZE;
+
+  frameNo = 0;
+  lastReads = 0;
+  lastTsum = 0;
+  state = RECORDING;
+  Serial.printf("🎬 Replay: recording (latch line %d, joystick %s)\n",
+                spectrum->inputLatchLine, ZXSpectrum::joystickModeName(spectrum->joystickMode));
+  return true;
+}
+
+uint8_t* InputReplay::finishRecording(size_t* len) {
+  if (state != RECORDING) return nullptr;
+  put32(buf + 8, frameNo);
+  uint8_t* out = buf;
+  *len = pos;
+  Serial.printf("🎬 Replay: recorded %u frames, %u bytes\n", (unsigned)frameNo, (unsigned)pos);
+
+  buf = nullptr;   // Владелец теперь вызывающий
+  capacity = 0;
+  pos = 0;
+  state = IDLE;
+  return out;
+}
+
+// ═══ ПОВТОР ═══
+
+bool InputReplay::startPlayback(uint8_t* file, size_t len, ZXSpectrum* spectrum) {
+  if (state != IDLE) {
+    free(file);
+    return false;
+  }
+  buf = file;
+  capacity = len;
+
+  if (len < HEADER_SIZE || memcmp(buf, REPLAY_MAGIC, 4) != 0 || buf[4] != VERSION) {
+    Serial.println("❌ Replay: not a ZXIR file");
+    releaseBuffer();
+    return false;
+  }
+  uint32_t snapSize = get32(buf + 12);
+  if (snapSize != MachineSnapshot::SERIAL_SIZE || len < HEADER_SIZE + snapSize ||
+      buf[5] >= JOY_MODE_COUNT ||
+      !snapshot.deserialize(buf + HEADER_SIZE, snapSize)) {
+    Serial.println("❌ Replay: bad snapshot");
+    releaseBuffer();
+    return false;
+  }
+  // Ни одного кадра (запись остановлена сразу) - нечего повторять,
+  // а frameStart/frameEnd читали бы тег за концом буфера
+  if (get32(buf + 8) == 0 || len <= HEADER_SIZE + snapSize) {
+    Serial.println("❌ Replay: empty recording");
+    snapshot.release();
+    releaseBuffer();
+    return false;
+  }
+
+  snapshot.restore(spectrum);
+  snapshot.release();
+  memset(speckey, 0xFF, sizeof(speckey));
+
+  // Режим джойстика и строка захвата - как при записи (вернём в stop)
+  savedJoystickMode = spectrum->joystickMode;
+  savedLatchLine = spectrum->inputLatchLine;
+  spectrum->setJoystickMode((JoystickMode)buf[5]);
+  spectrum->inputLatchLine = (int16_t)get16(buf + 6);
+
+  totalFrames = get32(buf + 8);
+  pos = HEADER_SIZE + snapSize;
+  frameNo = 0;
+  lastReads = 0;
+  lastTsum = 0;
+  memset(&last, 0xFF, sizeof(last));
+  lastResult = {0, 0, -1};
+  state = PLAYING;
+  Serial.printf("🎬 Replay: playing %u frames (latch line %d, joystick %s)\n",
+                (unsigned)totalFrames, spectrum->inputLatchLine,
+                ZXSpectrum::joystickModeName(spectrum->joystickMode));
+  return true;
+}
+
+void InputReplay::stop(ZXSpectrum* spectrum) {
+  spectrum->joystickSource = liveJoystick;
+  spectrum->inputSignature = false;
+  if (state == PLAYING) {
+    spectrum->setJoystickMode(savedJoystickMode);
+    spectrum->inputLatchLine = savedLatchLine;
+    memset(speckey, 0xFF, sizeof(speckey));
+  }
+  releaseBuffer();
+  state = IDLE;
+}
+
+void InputReplay::abort(ZXSpectrum* spectrum) {
+  if (state == IDLE) return;
+  Serial.printf("🎬 Replay: %s aborted at frame %u\n",
+                state == RECORDING ? "recording" : "playback", (unsigned)frameNo);
+  stop(spectrum);
+}
+
+// ═══ ТОЧКИ КАДРА ═══
+
+// Состояние точки ввода: запись - снять (и записать, если изменилось),
+// повтор - прочитать (если есть в теге) и подставить эмулятору
+void InputReplay::applyPoint(ZXSpectrum* spectrum, uint8_t tagBit) {
+  if (state == RECORDING) {
+    InputState now;
+    memcpy(now.rows, speckey, sizeof(now.rows));
+    now.joy = liveJoystick ? (liveJoystick->load(std::memory_order_relaxed) & JOY_MASK) : 0;
+    joyByte.store(now.joy, std::memory_order_relaxed);
+    if ((frameNo == 0 && tagBit == TAG_START) || memcmp(&now, &last, sizeof(now)) != 0) {
+      buf[tagPos] |= tagBit;
+      memcpy(buf + pos, now.rows, sizeof(now.rows));
+      buf[pos + 8] = now.joy;
+      pos += 9;
+      last = now;
+    }
+    return;
+  }
+
+  // PLAYING
+  if ((buf[tagPos] & tagBit) && pos + 9 <= capacity) {
+    memcpy(last.rows, buf + pos, sizeof(last.rows));
+    last.joy = buf[pos + 8] & JOY_MASK;  // Старшие биты файла - не джойстик
+    pos += 9;
+  }
+  memcpy(speckey, last.rows, sizeof(last.rows));
+  joyByte.store(last.joy, std::memory_order_relaxed);
+}
+
+void InputReplay::frameStart(ZXSpectrum* spectrum) {
+  if (state == IDLE) return;
+  // Повтор: frameEnd останавливает на конце буфера, startPlayback не
+  // пускает пустой файл - сюда это не дойдёт, но тег за концом не читаем
+  if (state == PLAYING && pos >= capacity) {
+    Serial.printf("⚠️  Replay: stream ended at frame %u\n", (unsigned)frameNo);
+    stop(spectrum);
+    return;
+  }
+
+  // Джойстик эмулятору - только из нашего байта (меняется лишь в точках)
+  liveJoystick = spectrum->joystickSource;
+  spectrum->joystickSource = &joyByte;
+  spectrum->inputSignature = true;
+  spectrum->inputReads = 0;
+  spectrum->inputReadTsum = 0;
+
+  tagPos = pos++;
+  if (state == RECORDING) buf[tagPos] = 0;
+  applyPoint(spectrum, TAG_START);
+}
+
+void InputReplay::latch(ZXSpectrum* spectrum) {
+  if (state == IDLE) return;
+  applyPoint(spectrum, TAG_LATCH);
+}
+
+bool InputReplay::frameEnd(ZXSpectrum* spectrum) {
+  if (state == IDLE) return false;
+  spectrum->joystickSource = liveJoystick;
+  spectrum->inputSignature = false;
+
+  uint16_t reads = (uint16_t)spectrum->inputReads;
+  uint16_t tsum = (uint16_t)spectrum->inputReadTsum;
+
+  if (state == RECORDING) {
+    if (reads != lastReads) {
+      buf[tagPos] |= TAG_READS;
+      put16(buf + pos, reads);
+      pos += 2;
+      lastReads = reads;
+    }
+    if (tsum != lastTsum) {
+      buf[tagPos] |= TAG_TSUM;
+      put16(buf + pos, tsum);
+      pos += 2;
+      lastTsum = tsum;
+    }
+    frameNo++;
+    // Буфер кончается → вызывающий должен закончить запись
+    return !room(FRAME_MAX_BYTES);
+  }
+
+  // PLAYING: подпись кадра должна совпасть с записанной
+  uint8_t tag = buf[tagPos];
+  if ((tag & TAG_READS) && pos + 2 <= capacity) {
+    lastReads = get16(buf + pos);
+    pos += 2;
+  }
+  if ((tag & TAG_TSUM) && pos + 2 <= capacity) {
+    lastTsum = get16(buf + pos);
+    pos += 2;
+  }
+  if (reads != lastReads || tsum != lastTsum) {
+    if (lastResult.firstMismatch < 0) {
+      lastResult.firstMismatch = frameNo;
+      Serial.printf("⚠️  Replay: diverged at frame %u (IN %u/%u, expected %u/%u)\n",
+                    (unsigned)frameNo, reads, tsum, lastReads, lastTsum);
+    }
+    lastResult.mismatches++;
+  }
+  frameNo++;
+  lastResult.frames = frameNo;
+
+  if (frameNo >= totalFrames || pos >= capacity) {
+    Serial.printf("🎬 Replay: done, %u frames, %u mismatched\n",
+                  (unsigned)lastResult.frames, (unsigned)lastResult.mismatches);
+    stop(spectrum);
+    return true;
+  }
+  return false;
+}
@@ -0,0 +1,123 @@
+#ifndef INPUT_REPLAY_H
+#define INPUT_REPLAY_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "spectrum_mini.h"
+#include "machine_snapshot.h"
+
+// ═══════════════════════════════════════════════════════════
+// 🎬 INPUT REPLAY (V3.159): запись ввода по кадрам и точный повтор
+// ═══════════════════════════════════════════════════════════
+//
+// Как RZX: стартовый снимок машины + ввод, который видела программа.
+// Ввод попадает в эмулятор в двух точках кадра - перед runForFrame()
+// (publishKeyMatrix) и на строке захвата (V3.155, latchInputMidFrame).
+// В этих точках фиксируется состояние: 8 строк speckey + байт
+// джойстика. Джойстик на время записи/повтора читается не из задачи
+// опроса (меняется когда угодно), а из своего байта, обновляемого
+// только в этих точках → эмуляция детерминирована.
+//
+// Подпись кадра: число IN ввода и сумма их t-states (ZXSpectrum::
+// inputReads/inputReadTsum). При повторе сверяется каждый кадр -
+// первое расхождение = повтор "уехал" (другая сборка ядра, баг).
+//
+// Формат (little-endian):
+//   "ZXIR" ver(1) joystickMode(1) latchLine(int16) frames(u32) snapSize(u32)
+//   снимок (MachineSnapshot::serialize)
+//   на кадр: тег (бит 0/1 - состояние начала/строки захвата, 9 байт;
+//            бит 2/3 - число/сумма IN изменились, u16) + данные
+// Кадр без новых нажатий и с прежней подписью = 1 байт (~3 KB в минуту).
+//
+// Без SD: запись копится в PSRAM, файл пишет вызывающий (main - через
+// busScheduler); повтор получает уже прочитанный буфер. Так тот же код
+// крутится в хост-сборке (ZXSpectrum + ядро Z80 без железа):
+// test/host/test_input_replay.cpp.
+// ═══════════════════════════════════════════════════════════
+
+struct ReplayResult {
+  uint32_t frames;           // Кадров повторено
+  uint32_t mismatches;       // Кадров с другой подписью IN
+  int32_t firstMismatch;     // Первый такой кадр (-1 = нет)
+};
+
+class InputReplay {
+public:
+  static const size_t MAX_BYTES = 512 * 1024;    // PSRAM под запись (~40 мин с нажатиями)
+  static const size_t HEADER_SIZE = 16;
+  static const uint8_t VERSION = 1;
+
+  enum Mode : uint8_t { IDLE = 0, RECORDING, PLAYING };
+
+  InputReplay();
+  ~InputReplay();
+
+  // ═══ ЗАПИСЬ ═══
+  // Снимок машины сейчас (граница кадра) + пустой поток. false - нет памяти
+  bool startRecording(ZXSpectrum* spectrum);
+  // Закончить: буфер файла (heap_caps_malloc, владелец - вызывающий, free())
+  // и его длина. nullptr - запись не шла
+  uint8_t* finishRecording(size_t* len);
+
+  // ═══ ПОВТОР ═══
+  // Буфер файла (владение переходит сюда). Восстанавливает снимок,
+  // режим джойстика и строку захвата. false - не тот формат
+  bool startPlayback(uint8_t* file, size_t len, ZXSpectrum* spectrum);
+
+  // Прервать запись/повтор (загрузка игры, сброс). Буферы освобождаются
+  void abort(ZXSpectrum* spectrum);
+
+  // ═══ ТОЧКИ КАДРА (loop) ═══
+  // Перед runForFrame(): после публикации клавиатуры
+  void frameStart(ZXSpectrum* spectrum);
+  // Строка захвата: после публикации клавиатуры
+  void latch(ZXSpectrum* spectrum);
+  // После runForFrame(). true - повтор только что закончился (см. result())
+  // или буфер записи полон (вызвать finishRecording)
+  bool frameEnd(ZXSpectrum* spectrum);
+
+  inline Mode mode() const { return state; }
+  inline bool active() const { return state != IDLE; }
+  inline uint32_t frames() const { return frameNo; }
+  inline const ReplayResult& result() const { return lastResult; }
+
+private:
+  enum Tag : uint8_t {
+    TAG_START = 0x01,
+    TAG_LATCH = 0x02,
+    TAG_READS = 0x04,
+    TAG_TSUM = 0x08
+  };
+
+  struct InputState {
+    uint8_t rows[8];
+    uint8_t joy;
+  };
+
+  void applyPoint(ZXSpectrum* spectrum, uint8_t tagBit);
+  void stop(ZXSpectrum* spectrum);
+  void releaseBuffer();
+  bool room(size_t bytes) const { return pos + bytes <= capacity; }
+
+  Mode state;
+  uint8_t* buf;
+  size_t capacity;
+  size_t pos;                 // Запись: конец данных; повтор: курсор чтения
+  size_t tagPos;              // Запись: тег текущего кадра
+  uint32_t frameNo;
+  uint32_t totalFrames;       // Повтор: кадров в файле
+
+  InputState last;            // Последнее записанное/прочитанное состояние
+  uint16_t lastReads;
+  uint16_t lastTsum;
+
+  std::atomic<uint8_t> joyByte;                    // Джойстик для эмулятора
+  const std::atomic<uint8_t>* liveJoystick;        // Задача опроса (запись)
+  JoystickMode savedJoystickMode;
+  int savedLatchLine;
+
+  MachineSnapshot snapshot;
+  ReplayResult lastResult;
+};
+
+#endif // INPUT_REPLAY_H
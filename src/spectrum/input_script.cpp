@@ -0,0 +1,173 @@
+#include "input_script.h"
+
+InputScript::InputScript() {
+  clear();
+}
+
+void InputScript::clear() {
+  stepCount = 0;
+  pc = 0;
+  phase = 0;
+  stepFrames = 0;
+  frameCount = 0;
+  active = false;
+  error = false;
+  memset(keyRows, 0xFF, sizeof(keyRows));
+}
+
+bool InputScript::add(const Step& s) {
+  if (stepCount >= MAX_STEPS) {
+    Serial.println("⚠️  InputScript: too many steps");
+    return false;
+  }
+  steps[stepCount++] = s;
+  return true;
+}
+
+bool InputScript::press(SpecKeys key) {
+  return add({OP_PRESS, (uint8_t)key, SPECKEY_NONE, 0, 0, 0, 0});
+}
+
+bool InputScript::release(SpecKeys key) {
+  return add({OP_RELEASE, (uint8_t)key, SPECKEY_NONE, 0, 0, 0, 0});
+}
+
+bool InputScript::waitFrames(uint16_t frames) {
+  return add({OP_WAIT_FRAMES, SPECKEY_NONE, SPECKEY_NONE, 0, 0, 0, frames});
+}
+
+bool InputScript::waitRomReady(uint16_t timeout) {
+  return add({OP_WAIT_ROM_READY, SPECKEY_NONE, SPECKEY_NONE, 0, 0, 0, timeout});
+}
+
+bool InputScript::type(SpecKeys key, SpecKeys modifier, uint16_t timeout) {
+  return add({OP_TYPE, (uint8_t)key, (uint8_t)modifier, 0, 0, 0, timeout});
+}
+
+bool InputScript::waitMem(uint16_t addr, uint8_t mask, uint8_t value, uint16_t timeout) {
+  return add({OP_WAIT_MEM, SPECKEY_NONE, SPECKEY_NONE, mask, value, addr, timeout});
+}
+
+void InputScript::start() {
+  pc = 0;
+  phase = 0;
+  stepFrames = 0;
+  frameCount = 0;
+  error = false;
+  active = stepCount > 0;
+  memset(keyRows, 0xFF, sizeof(keyRows));
+}
+
+void InputScript::setKey(uint8_t key, bool down) {
+  if (key <= SPECKEY_NONE || key >= SPECKEY_MAX_NORMAL) return;
+  if (down) {
+    keyRows[key2specy[0][key]] &= key2specy[1][key];
+  } else {
+    keyRows[key2specy[0][key]] |= key2specy[1][key] ^ 0xFF;
+  }
+}
+
+bool InputScript::kstateFree(ZXSpectrum* spectrum) const {
+  // Оба набора KSTATE свободны (бит 7) → та же клавиша снова будет новой
+  return (spectrum->z80_peek(SV_KSTATE) & 0x80) && (spectrum->z80_peek(SV_KSTATE + 4) & 0x80);
+}
+
+void InputScript::nextStep() {
+  pc++;
+  phase = 0;
+  stepFrames = 0;
+}
+
+bool InputScript::step(ZXSpectrum* spectrum) {
+  if (!active) return false;
+
+  while (pc < stepCount) {
+    const Step& s = steps[pc];
+    bool done = false;
+
+    switch (s.op) {
+      case OP_PRESS:
+      case OP_RELEASE:
+        setKey(s.key, s.op == OP_PRESS);
+        done = true;
+        break;
+
+      case OP_WAIT_FRAMES:
+        done = stepFrames >= s.frames;
+        break;
+
+      case OP_WAIT_ROM_READY: {
+        // (IFF1 на границе кадра не смотрим - INT только что его сбросил)
+        if (spectrum->romReady()) {
+          Serial.printf("⌨️  Script: ROM ready after %u frames\n", (unsigned)frameCount);
+          done = true;
+        } else if (stepFrames >= s.frames) {
+          // Нестандартная ROM/прошивка - дальше как раньше, вслепую
+          Serial.printf("⚠️  Script: ROM ready not seen in %u frames, continuing\n", s.frames);
+          done = true;
+        }
+        break;
+      }
+
+      case OP_TYPE: {
+        uint8_t flags = spectrum->z80_peek(SV_FLAGS);
+        if (phase == 0 && !(flags & 0x20) && kstateFree(spectrum)) {
+          // Прошлая клавиша забрана редактором и KSTATE свободен → нажимаем
+          setKey(s.modifier, true);
+          setKey(s.key, true);
+          phase = 1;
+        } else if (phase == 1 && ((flags & 0x20) || !kstateFree(spectrum))) {
+          // KEYBOARD (IM1) занял набор KSTATE и выставил LAST-K → отпускаем
+          // (редактор часто забирает клавишу в том же кадре - бит 5 уже 0)
+          setKey(s.key, false);
+          setKey(s.modifier, false);
+          phase = 2;
+        } else if (phase == 2 && !(flags & 0x20)) {
+          done = true;  // Редактор забрал (KEY-INPUT сбросил бит 5)
+        }
+        break;
+      }
+
+      case OP_WAIT_MEM:
+        done = (spectrum->z80_peek(s.addr) & s.mask) == s.value;
+        break;
+    }
+
+    if (done) {
+      nextStep();
+      continue;
+    }
+
+    // Ждём следующий кадр (с таймаутом для ожиданий ROM)
+    if (s.op != OP_WAIT_FRAMES && s.op != OP_WAIT_ROM_READY && stepFrames >= s.frames) {
+      Serial.printf("❌ Script: step %d (op %d) timed out after %u frames\n", pc, s.op, s.frames);
+      error = true;
+      active = false;
+      memset(keyRows, 0xFF, sizeof(keyRows));
+      return false;
+    }
+    stepFrames++;
+    frameCount++;
+    return true;
+  }
+
+  active = false;
+  memset(keyRows, 0xFF, sizeof(keyRows));
+  return false;
+}
+
+int InputScript::run(ZXSpectrum* spectrum, int maxFrames) {
+  start();
+  while (step(spectrum)) {
+    if ((int)frameCount > maxFrames) {
+      Serial.printf("❌ Script: exceeded %d frames\n", maxFrames);
+      active = false;
+      error = true;
+      break;
+    }
+    memcpy(speckey, keyRows, sizeof(keyRows));
+    spectrum->runForFrame();
+  }
+  memset(speckey, 0xFF, sizeof(keyRows));
+  return error ? -1 : (int)frameCount;
+}
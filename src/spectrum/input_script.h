@@ -0,0 +1,113 @@
+#ifndef INPUT_SCRIPT_H
+#define INPUT_SCRIPT_H
+
+#include <Arduino.h>
+#include "spectrum_mini.h"
+
+// ═══════════════════════════════════════════════════════════
+// ⌨️ INPUT SCRIPT (V3.156): сценарий нажатий по кадрам и состоянию ROM
+// ═══════════════════════════════════════════════════════════
+//
+// Раньше TAPLoader ждал 200 кадров "на всякий случай" и набирал
+// LOAD "" через updateKey + 10 кадров на каждое нажатие/отпускание.
+//
+// Теперь сценарий - список шагов, исполняемый по кадрам:
+// - press/release  - клавиша в матрице сценария (держится между шагами)
+// - waitFrames     - ровно N кадров
+// - waitRomReady   - ROM закончил инициализацию (ZXSpectrum::romReady;
+//                    после быстрого старта из снимка - сразу)
+// - type           - ждать свободный KSTATE (иначе ROM примет ту же
+//                    клавишу за автоповтор) → нажать (с модификатором) →
+//                    ждать, пока KEYBOARD её зарегистрирует (KSTATE занят /
+//                    FLAGS бит 5, LAST-K) → отпустить → ждать, пока
+//                    редактор заберёт её (FLAGS бит 5 = 0)
+// - waitMem        - (адрес & mask) == value (любая системная переменная)
+//
+// ROM опрашивает клавиатуру только в INT, поэтому шаг = кадр (точнее
+// t-states не нужно); каждое ожидание - минимум кадров, который реально
+// нужен ROM (с таймаутом).
+//
+// Исполнение:
+// - run()  - блокирующий прогон кадров подряд (fast-forward, без
+//            рендера и звука) - так набирает TAPLoader и хост-тест
+//            (test/host/test_input_script.cpp)
+// - step() - один кадр сценария: смотрит состояние ROM после прошлого
+//            кадра, клавиши сценария - rows() (для своего цикла кадров)
+// ═══════════════════════════════════════════════════════════
+
+class InputScript {
+public:
+  static const int MAX_STEPS = 32;
+  static const uint16_t DEFAULT_TIMEOUT = 150;   // Кадров на ожидание ROM (3 с)
+
+  // Системные переменные 48K ROM
+  static const uint16_t SV_KSTATE = 23552;  // 2 набора по 4 байта (бит 7 = свободен)
+  static const uint16_t SV_LAST_K = 23560;
+  static const uint16_t SV_FLAGS = 23611;   // Бит 5 = есть новая клавиша
+
+  InputScript();
+
+  // ═══ ПОСТРОЕНИЕ (false = сценарий переполнен) ═══
+  void clear();
+  bool press(SpecKeys key);
+  bool release(SpecKeys key);
+  bool waitFrames(uint16_t frames);
+  bool waitRomReady(uint16_t timeout = DEFAULT_TIMEOUT * 2);
+  bool type(SpecKeys key, SpecKeys modifier = SPECKEY_NONE, uint16_t timeout = DEFAULT_TIMEOUT);
+  bool waitMem(uint16_t addr, uint8_t mask, uint8_t value, uint16_t timeout = DEFAULT_TIMEOUT);
+
+  // ═══ ИСПОЛНЕНИЕ ═══
+  // Начать с первого шага (матрица сценария отпущена)
+  void start();
+  // Перед кадром: проверить ROM, обновить rows(). false = закончен или ошибка
+  bool step(ZXSpectrum* spectrum);
+  // Блокирующий прогон: speckey = rows() перед каждым кадром.
+  // Кадров использовано, или -1 при ошибке/maxFrames
+  int run(ZXSpectrum* spectrum, int maxFrames);
+
+  inline bool running() const { return active; }
+  inline bool failed() const { return error; }
+  inline uint32_t frames() const { return frameCount; }
+  inline int currentStep() const { return pc; }
+
+  // Матрица сценария (1 = отпущена) - AND с клавиатурой
+  inline const uint8_t* rows() const { return keyRows; }
+
+private:
+  enum Op : uint8_t {
+    OP_PRESS = 0,
+    OP_RELEASE,
+    OP_WAIT_FRAMES,
+    OP_WAIT_ROM_READY,
+    OP_TYPE,
+    OP_WAIT_MEM
+  };
+
+  struct Step {
+    Op op;
+    uint8_t key;        // SpecKeys
+    uint8_t modifier;   // SpecKeys (OP_TYPE)
+    uint8_t mask;       // OP_WAIT_MEM
+    uint8_t value;
+    uint16_t addr;
+    uint16_t frames;    // Кадры (OP_WAIT_FRAMES) или таймаут
+  };
+
+  bool add(const Step& s);
+  void setKey(uint8_t key, bool down);
+  bool kstateFree(ZXSpectrum* spectrum) const;
+  void nextStep();
+
+  Step steps[MAX_STEPS];
+  int stepCount;
+
+  int pc;                 // Текущий шаг
+  uint8_t phase;          // Фаза OP_TYPE
+  uint16_t stepFrames;    // Кадров в текущем шаге
+  uint32_t frameCount;    // Кадров с start()
+  bool active;
+  bool error;
+  uint8_t keyRows[8];
+};
+
+#endif // INPUT_SCRIPT_H
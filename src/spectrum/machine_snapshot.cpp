@@ -0,0 +1,202 @@
+#include "machine_snapshot.h"
+#include <esp_heap_caps.h>
+
+MachineSnapshot::MachineSnapshot()
+  : ram(nullptr), captured(false), borderColor(7), soundBits(0), micLevel(false),
+    ayLatch(0), flashCounter(0), flashPhase(false) {
+  memset(&regs, 0, sizeof(regs));
+  memset(ayRegs, 0, sizeof(ayRegs));
+}
+
+MachineSnapshot::~MachineSnapshot() {
+  release();
+}
+
+void MachineSnapshot::release() {
+  if (ram) heap_caps_free(ram);
+  ram = nullptr;
+  captured = false;
+}
+
+bool MachineSnapshot::allocRam() {
+  if (!ram) {
+    ram = (uint8_t*)heap_caps_malloc(RAM_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!ram) {
+      Serial.println("⚠️  Snapshot: no PSRAM for 48K copy");
+      return false;
+    }
+  }
+  return true;
+}
+
+// Всё, кроме RAM: регистры, порты, AY, FLASH
+void MachineSnapshot::readMachine(const ZXSpectrum* spectrum) {
+  regs = *spectrum->z80Regs;
+  borderColor = spectrum->borderColor;
+  soundBits = spectrum->soundBits;
+  micLevel = spectrum->micLevel;
+  memcpy(ayRegs, spectrum->ayRegs, sizeof(ayRegs));
+  ayLatch = spectrum->ayLatch;
+  flashCounter = spectrum->flashCounter;
+  flashPhase = spectrum->flashPhase;
+}
+
+void MachineSnapshot::writeMachine(ZXSpectrum* spectrum) const {
+  void* userInfo = spectrum->z80Regs->userInfo;
+  *spectrum->z80Regs = regs;
+  spectrum->z80Regs->userInfo = userInfo;
+
+  spectrum->borderColor = borderColor;
+  spectrum->soundBits = soundBits;
+  spectrum->micLevel = micLevel;
+  spectrum->flashCounter = flashCounter;
+  spectrum->flashPhase = flashPhase;
+
+  // AY: регистры целиком, Audio Task подхватит через ayResync
+  memcpy(spectrum->ayRegs, ayRegs, sizeof(ayRegs));
+  spectrum->ayLatch = ayLatch;
+  spectrum->ayWriteCount = 0;
+  spectrum->ayResyncPending = true;
+}
+
+bool MachineSnapshot::capture(const ZXSpectrum* spectrum) {
+  if (!allocRam()) return false;
+  readMachine(spectrum);
+  memcpy(ram, spectrum->mem.ram, RAM_SIZE);
+  captured = true;
+  return true;
+}
+
+bool MachineSnapshot::restore(ZXSpectrum* spectrum) const {
+  if (!captured) return false;
+  writeMachine(spectrum);
+  memcpy(spectrum->mem.ram, ram, RAM_SIZE);
+  spectrum->mem.markAllDirty();  // V3.161: RAM сменилась мимо poke
+  return true;
+}
+
+// ═══ V3.159: ФАЙЛОВЫЙ ОБРАЗ ═══
+
+static const uint8_t SERIAL_MAGIC[4] = {'Z', 'X', 'M', 'S'};
+
+static inline uint8_t* put16(uint8_t* p, uint16_t v) {
+  p[0] = v & 0xFF;
+  p[1] = v >> 8;
+  return p + 2;
+}
+
+static inline const uint8_t* get16(const uint8_t* p, uint16_t& v) {
+  v = p[0] | (p[1] << 8);
+  return p + 2;
+}
+
+bool MachineSnapshot::validImage(const uint8_t* in, size_t len) {
+  return len >= SERIAL_SIZE && memcmp(in, SERIAL_MAGIC, 4) == 0 && in[4] == SERIAL_VERSION;
+}
+
+// Заголовок образа (всё до RAM). Возвращает начало RAM в образе
+uint8_t* MachineSnapshot::packHeader(uint8_t* out) const {
+  uint8_t* p = out;
+  memcpy(p, SERIAL_MAGIC, 4); p += 4;
+  *p++ = SERIAL_VERSION;
+
+  // Регистры (13 пар + 6 байт + IRequest + префикс DD/FD + резерв = 36)
+  const eword* pairs[13] = {&regs.AF, &regs.BC, &regs.DE, &regs.HL, &regs.IX, &regs.IY,
+                            &regs.PC, &regs.SP, &regs.R, &regs.AFs, &regs.BCs, &regs.DEs, &regs.HLs};
+  for (int i = 0; i < 13; i++) p = put16(p, pairs[i]->W);
+  *p++ = regs.IFF1;
+  *p++ = regs.IFF2;
+  *p++ = regs.I;
+  *p++ = regs.halted;
+  *p++ = (uint8_t)regs.IM;
+  *p++ = regs.ei_pending;
+  p = put16(p, regs.IRequest);
+  *p++ = (uint8_t)regs.we_are_on_ddfd;
+  *p++ = 0;  // Резерв
+
+  // Порты, AY, FLASH (22)
+  *p++ = borderColor;
+  *p++ = soundBits;
+  *p++ = micLevel ? 1 : 0;
+  memcpy(p, ayRegs, sizeof(ayRegs)); p += sizeof(ayRegs);
+  *p++ = ayLatch;
+  *p++ = flashCounter;
+  *p++ = flashPhase ? 1 : 0;
+  return p;
+}
+
+const uint8_t* MachineSnapshot::unpackHeader(const uint8_t* in) {
+  const uint8_t* p = in + SERIAL_HEADER;
+  memset(&regs, 0, sizeof(regs));
+  eword* pairs[13] = {&regs.AF, &regs.BC, &regs.DE, &regs.HL, &regs.IX, &regs.IY,
+                      &regs.PC, &regs.SP, &regs.R, &regs.AFs, &regs.BCs, &regs.DEs, &regs.HLs};
+  for (int i = 0; i < 13; i++) p = get16(p, pairs[i]->W);
+  regs.IFF1 = *p++;
+  regs.IFF2 = *p++;
+  regs.I = *p++;
+  regs.halted = *p++;
+  regs.IM = (char)*p++;
+  regs.ei_pending = *p++;
+  p = get16(p, regs.IRequest);
+  regs.we_are_on_ddfd = *p++;
+  p++;
+
+  borderColor = *p++;
+  soundBits = *p++;
+  micLevel = *p++ != 0;
+  memcpy(ayRegs, p, sizeof(ayRegs)); p += sizeof(ayRegs);
+  ayLatch = *p++;
+  flashCounter = *p++;
+  flashPhase = *p++ != 0;
+  return p;
+}
+
+bool MachineSnapshot::serialize(uint8_t* out) const {
+  if (!captured) return false;
+  memcpy(packHeader(out), ram, RAM_SIZE);
+  return true;
+}
+
+bool MachineSnapshot::deserialize(const uint8_t* in, size_t len) {
+  if (!validImage(in, len)) {
+    Serial.println("⚠️  Snapshot: bad image");
+    return false;
+  }
+  if (!allocRam()) return false;
+  memcpy(ram, unpackHeader(in), RAM_SIZE);
+  captured = true;
+  return true;
+}
+
+// ═══ V3.160: ОБРАЗ ПРЯМО ИЗ/В МАШИНУ (одна копия 48K) ═══
+
+void MachineSnapshot::captureImage(const ZXSpectrum* spectrum, uint8_t* out) {
+  MachineSnapshot state;   // Без RAM - только регистры/порты
+  state.readMachine(spectrum);
+  memcpy(state.packHeader(out), spectrum->mem.ram, RAM_SIZE);
+}
+
+bool MachineSnapshot::restoreImage(const uint8_t* in, size_t len, ZXSpectrum* spectrum) {
+  if (!validImage(in, len)) {
+    Serial.println("⚠️  Snapshot: bad image");
+    return false;
+  }
+  MachineSnapshot state;
+  const uint8_t* image = state.unpackHeader(in);
+  state.writeMachine(spectrum);
+  memcpy(spectrum->mem.ram, image, RAM_SIZE);
+  spectrum->mem.markAllDirty();  // V3.161
+  return true;
+}
+
+void MachineSnapshot::captureState(const ZXSpectrum* spectrum, uint8_t* out) {
+  MachineSnapshot state;
+  state.readMachine(spectrum);
+  state.packHeader(out);
+}
+
+void MachineSnapshot::restoreState(const uint8_t* in, ZXSpectrum* spectrum) {
+  MachineSnapshot state;
+  state.unpackHeader(in);
+  state.writeMachine(spectrum);
+}
@@ -0,0 +1,86 @@
+#ifndef MACHINE_SNAPSHOT_H
+#define MACHINE_SNAPSHOT_H
+
+#include <Arduino.h>
+#include "spectrum_mini.h"
+
+// ═══════════════════════════════════════════════════════════
+// 📸 MACHINE SNAPSHOT (V3.157): полное состояние машины в памяти
+// ═══════════════════════════════════════════════════════════
+//
+// Регистры Z80 + 48K RAM + порты (border, beeper, EAR) + AY + фаза FLASH.
+// RAM копия живёт в PSRAM (внутренняя куча не тратится).
+//
+// Первый пользователь - быстрый старт: ROM после сброса ~80 кадров
+// тестирует RAM и инициализируется. Состояние в точке готовности
+// (ZXSpectrum::romReady) снимается один раз при запуске (пока висит
+// splash), а дальше сброс / TAP загрузка просто восстанавливают его
+// (ZXSpectrum::warmReset) - ~50 мкс memcpy вместо секунд эмуляции.
+//
+// V3.159: serialize/deserialize - плоский little-endian образ (без
+// указателей и выравнивания структур) для файлов: одинаков на ESP32
+// и в хост-сборке. Первый файловый пользователь - запись ввода.
+//
+// V3.160: captureImage/restoreImage - образ прямо из машины / в машину,
+// без промежуточной копии RAM (слоты сохранения: одна копия 48K в PSRAM
+// ~0.5 мс). hwopt не сохраняется - это константы таймингов 48K.
+// ═══════════════════════════════════════════════════════════
+
+class MachineSnapshot {
+public:
+  static const size_t RAM_SIZE = 0xC000;   // 48K (0x4000-0xFFFF)
+  // Образ: "ZXMS" + версия + регистры (36) + порты/AY/FLASH (22) + RAM
+  static const uint8_t SERIAL_VERSION = 1;
+  static const size_t SERIAL_HEADER = 5;
+  static const size_t SERIAL_REGS = 36;
+  static const size_t SERIAL_PORTS = 22;
+  static const size_t STATE_SIZE = SERIAL_HEADER + SERIAL_REGS + SERIAL_PORTS;   // Образ без RAM
+  static const size_t SERIAL_SIZE = STATE_SIZE + RAM_SIZE;
+
+  MachineSnapshot();
+  ~MachineSnapshot();
+
+  // Снять состояние (буфер RAM выделяется при первом вызове).
+  // false - нет памяти
+  bool capture(const ZXSpectrum* spectrum);
+
+  // Восстановить состояние (userInfo Z80 не трогаем). false - снимка нет
+  bool restore(ZXSpectrum* spectrum) const;
+
+  // V3.159: Образ в out (SERIAL_SIZE байт). false - снимка нет
+  bool serialize(uint8_t* out) const;
+  // V3.159: Снимок из образа. false - не тот формат / нет памяти
+  bool deserialize(const uint8_t* in, size_t len);
+
+  // V3.160: Образ текущей машины в out (SERIAL_SIZE байт) / машина из образа
+  static void captureImage(const ZXSpectrum* spectrum, uint8_t* out);
+  static bool restoreImage(const uint8_t* in, size_t len, ZXSpectrum* spectrum);
+  static bool validImage(const uint8_t* in, size_t len);
+  // V3.161: Только регистры/порты/AY/FLASH (STATE_SIZE байт) - RAM ведёт вызывающий
+  static void captureState(const ZXSpectrum* spectrum, uint8_t* out);
+  static void restoreState(const uint8_t* in, ZXSpectrum* spectrum);
+
+  inline bool valid() const { return captured; }
+  void release();
+
+private:
+  bool allocRam();
+  void readMachine(const ZXSpectrum* spectrum);
+  void writeMachine(ZXSpectrum* spectrum) const;
+  uint8_t* packHeader(uint8_t* out) const;
+  const uint8_t* unpackHeader(const uint8_t* in);
+
+  Z80Regs regs;
+  uint8_t* ram;
+  bool captured;
+
+  uint8_t borderColor;
+  uint8_t soundBits;
+  bool micLevel;
+  uint8_t ayRegs[16];
+  uint8_t ayLatch;
+  uint8_t flashCounter;
+  bool flashPhase;
+};
+
+#endif // MACHINE_SNAPSHOT_H
@@ -0,0 +1,189 @@
+#include "rewind_buffer.h"
+#include <esp_heap_caps.h>
+
+static const int BLOCK_SIZE = 1 << Memory::DIRTY_SHIFT;
+
+RewindBuffer::RewindBuffer()
+  : ring(nullptr), ref(nullptr), head(0), first(0), count(0), needBase(true), frameCounter(0),
+    wCaptures(0), wSumUs(0), wMaxUs(0), wSumBytes(0), wSumBlocks(0) {
+}
+
+RewindBuffer::~RewindBuffer() {
+  if (ring) heap_caps_free(ring);
+  if (ref) heap_caps_free(ref);
+}
+
+bool RewindBuffer::begin() {
+  if (ring) return true;
+  ring = (uint8_t*)heap_caps_malloc(RING_BYTES, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  ref = (uint8_t*)heap_caps_malloc(MachineSnapshot::RAM_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  if (!ring || !ref) {
+    Serial.println("⚠️  Rewind: no PSRAM, disabled");
+    if (ring) heap_caps_free(ring);
+    if (ref) heap_caps_free(ref);
+    ring = nullptr;
+    ref = nullptr;
+    return false;
+  }
+  Serial.printf("⏪ Rewind: %u KB ring, point every %d frames\n",
+                (unsigned)(RING_BYTES / 1024), CAPTURE_EVERY);
+  clear();
+  return true;
+}
+
+void RewindBuffer::clear() {
+  head = 0;
+  first = 0;
+  count = 0;
+  needBase = true;
+  frameCounter = 0;
+}
+
+void RewindBuffer::frameDone(ZXSpectrum* spectrum) {
+  if (!ring) return;
+  if (++frameCounter < CAPTURE_EVERY) return;
+  frameCounter = 0;
+  capture(spectrum);
+}
+
+// ═══ КОДИРОВАНИЕ БЛОКА ═══
+// x = ram XOR ref: пары (нулей 0-255, литералов 0-255, литералы x...)
+// до конца блока. Блок без изменений не кодируется вовсе.
+size_t RewindBuffer::encodeBlock(const uint8_t* ram, const uint8_t* ref, uint8_t* out) {
+  uint8_t* p = out;
+  int i = 0;
+  while (i < BLOCK_SIZE) {
+    int zeros = 0;
+    while (i < BLOCK_SIZE && ram[i] == ref[i] && zeros < 255) {
+      zeros++;
+      i++;
+    }
+    uint8_t* lenPos = p + 1;
+    *p = zeros;
+    p += 2;
+    int lits = 0;
+    while (i < BLOCK_SIZE && ram[i] != ref[i] && lits < 255) {
+      *p++ = ram[i] ^ ref[i];
+      lits++;
+      i++;
+    }
+    *lenPos = lits;
+  }
+  return p - out;
+}
+
+const uint8_t* RewindBuffer::applyBlock(const uint8_t* in, uint8_t* ref) {
+  int i = 0;
+  while (i < BLOCK_SIZE) {
+    i += *in++;
+    int lits = *in++;
+    for (int k = 0; k < lits; k++) ref[i++] ^= *in++;
+  }
+  return in;
+}
+
+// ═══ КОЛЬЦО ═══
+
+bool RewindBuffer::overlaps(const Point& p, size_t start, size_t len) const {
+  return p.offset < start + len && start < p.offset + p.size;
+}
+
+void RewindBuffer::dropOldest() {
+  first = (first + 1) % MAX_POINTS;
+  count--;
+}
+
+void RewindBuffer::capture(ZXSpectrum* spectrum) {
+  uint32_t t0 = micros();
+  const uint8_t* ram = spectrum->mem.ram;
+  uint8_t* dirty = spectrum->mem.dirty;
+
+  // Место под худший случай - непрерывно; не влезает до конца → с начала кольца
+  if (head + POINT_WORST > RING_BYTES) head = 0;
+  while (count > 0 && overlaps(points[first], head, POINT_WORST)) dropOldest();
+  if (count == MAX_POINTS) dropOldest();
+
+  uint8_t* out = ring + head;
+  uint8_t* p = out;
+  MachineSnapshot::captureState(spectrum, p);
+  p += MachineSnapshot::STATE_SIZE;
+  uint8_t* blockCountPos = p;
+  p += 2;
+  int blocks = 0;
+
+  if (needBase || count == 0) {
+    // База: ref = RAM целиком, дельты нет (назад дальше неё не ходим)
+    memcpy(ref, ram, MachineSnapshot::RAM_SIZE);
+    memset(dirty, 0, Memory::DIRTY_BLOCKS);
+    count = 0;
+    first = 0;
+    needBase = false;
+  } else {
+    for (int b = 0; b < Memory::DIRTY_BLOCKS; b++) {
+      if (!dirty[b]) continue;
+      dirty[b] = 0;
+      size_t off = (size_t)b << Memory::DIRTY_SHIFT;
+      if (memcmp(ram + off, ref + off, BLOCK_SIZE) == 0) continue;  // Записали то же самое
+      *p++ = (uint8_t)b;
+      p += encodeBlock(ram + off, ref + off, p);
+      memcpy(ref + off, ram + off, BLOCK_SIZE);
+      blocks++;
+    }
+  }
+  blockCountPos[0] = blocks & 0xFF;
+  blockCountPos[1] = blocks >> 8;
+
+  Point& pt = points[(first + count) % MAX_POINTS];
+  pt.offset = head;
+  pt.size = p - out;
+  count++;
+  head += pt.size;
+
+  uint32_t dt = micros() - t0;
+  wCaptures++;
+  wSumUs += dt;
+  if (dt > wMaxUs) wMaxUs = dt;
+  wSumBytes += pt.size;
+  wSumBlocks += blocks;
+}
+
+// ═══ ШАГ НАЗАД ═══
+// Дельта точки k переводит ref из RAM(k) в RAM(k-1): применяем дельты
+// новейших точек и отбрасываем их, состояние - из новой последней точки.
+int RewindBuffer::stepBack(ZXSpectrum* spectrum, int steps) {
+  // Одна точка (база) - назад некуда: машину не трогаем, а не прыгаем
+  // молча на 0-4 кадра к ней (вызывающий покажет "nothing buffered")
+  if (!ring || count <= 1 || needBase) return 0;
+
+  int stepped = 0;
+  while (stepped < steps && count > 1) {
+    const Point& pt = points[(first + count - 1) % MAX_POINTS];
+    const uint8_t* in = ring + pt.offset + MachineSnapshot::STATE_SIZE;
+    int blocks = in[0] | (in[1] << 8);
+    in += 2;
+    for (int i = 0; i < blocks; i++) {
+      int b = *in++;
+      in = applyBlock(in, ref + ((size_t)b << Memory::DIRTY_SHIFT));
+    }
+    head = pt.offset;  // Место отброшенной точки - под следующие
+    count--;
+    stepped++;
+  }
+
+  const Point& target = points[(first + count - 1) % MAX_POINTS];
+  MachineSnapshot::restoreState(ring + target.offset, spectrum);
+  memcpy(spectrum->mem.ram, ref, MachineSnapshot::RAM_SIZE);
+  memset(spectrum->mem.dirty, 0, Memory::DIRTY_BLOCKS);  // RAM == ref
+  head = target.offset + target.size;
+  frameCounter = 0;
+  return stepped;
+}
+
+void RewindBuffer::takeStats(RewindStats& out) {
+  out.captures = wCaptures;
+  out.avgUs = wCaptures ? wSumUs / wCaptures : 0;
+  out.maxUs = wMaxUs;
+  out.avgBytes = wCaptures ? wSumBytes / wCaptures : 0;
+  out.avgBlocks = wCaptures ? wSumBlocks / wCaptures : 0;
+  wCaptures = wSumUs = wMaxUs = wSumBytes = wSumBlocks = 0;
+}
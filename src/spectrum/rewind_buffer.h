@@ -0,0 +1,100 @@
+#ifndef REWIND_BUFFER_H
+#define REWIND_BUFFER_H
+
+#include <Arduino.h>
+#include "spectrum_mini.h"
+#include "machine_snapshot.h"
+
+// ═══════════════════════════════════════════════════════════
+// ⏪ REWIND BUFFER (V3.161): последние секунды игры в PSRAM
+// ═══════════════════════════════════════════════════════════
+//
+// Точка перемотки каждые CAPTURE_EVERY кадров (10 в секунду):
+// - состояние без RAM (MachineSnapshot::captureState, 63 байта)
+// - XOR дельта RAM к прошлой точке, только блоки 256 байт с флагом
+//   Memory::dirty (poke их ставит), RLE: (нулей, литералов, литералы...)
+// - ref (PSRAM, 48K) = RAM последней точки
+//
+// Цепочка идёт назад: RAM(k-1) = RAM(k) XOR дельта(k), поэтому шаг
+// назад = применить дельты новых точек к ref и отбросить их. Полные
+// ключевые снимки не нужны: ref всегда точен, а самая старая точка -
+// просто база, её дельта не применяется (место в кольце - только дельтам).
+//
+// Память фиксирована и выделяется один раз (begin): кольцо байт +
+// индекс точек. Запись точки вытесняет самые старые точки.
+// Стоимость снятия замеряется (takeStats) - блоков за 5 кадров обычно
+// десятки, а не 192.
+// ═══════════════════════════════════════════════════════════
+
+struct RewindStats {
+  uint32_t captures;         // Точек снято за окно
+  uint32_t avgUs, maxUs;     // Время снятия точки
+  uint32_t avgBytes;         // Средний размер точки
+  uint32_t avgBlocks;        // Изменённых блоков на точку
+};
+
+class RewindBuffer {
+public:
+  static const size_t RING_BYTES = 1024 * 1024;   // ~30-100 с игры
+  static const int MAX_POINTS = 1024;
+  static const int CAPTURE_EVERY = 5;              // Кадров между точками
+  static const int FRAMES_PER_SECOND = 50;
+
+  RewindBuffer();
+  ~RewindBuffer();
+
+  // Выделить кольцо и ref в PSRAM. false - нет памяти (перемотка выключена)
+  bool begin();
+  inline bool ready() const { return ring != nullptr; }
+
+  // Забыть историю (загрузка игры, сброс): следующая точка - новая база
+  void clear();
+
+  // После каждого эмулированного кадра
+  void frameDone(ZXSpectrum* spectrum);
+
+  // Назад на points точек (не дальше самой старой) и к ней же - живая
+  // машина ушла от последней точки на 0-4 кадра. Возвращает, на сколько
+  // точек реально отошли (0 - некуда, машина не тронута)
+  int stepBack(ZXSpectrum* spectrum, int points);
+
+  // Секунд в буфере (от самой старой точки до последней)
+  inline float seconds() const {
+    return count > 1 ? (float)(count - 1) * CAPTURE_EVERY / FRAMES_PER_SECOND : 0.0f;
+  }
+
+  void takeStats(RewindStats& out);
+
+private:
+  struct Point {
+    uint32_t offset;         // В кольце
+    uint32_t size;
+  };
+
+  // Худший случай точки: состояние + все блоки с чередованием 0/не 0
+  // (пара "0 нулей, 1 литерал" = 3 байта на 2 байта блока)
+  static const size_t BLOCK_WORST = 1 + 256 / 2 * 3 + 2;
+  static const size_t POINT_WORST = MachineSnapshot::STATE_SIZE + 2 + Memory::DIRTY_BLOCKS * BLOCK_WORST;
+
+  void capture(ZXSpectrum* spectrum);
+  void dropOldest();
+  bool overlaps(const Point& p, size_t start, size_t len) const;
+  static size_t encodeBlock(const uint8_t* ram, const uint8_t* ref, uint8_t* out);
+  static const uint8_t* applyBlock(const uint8_t* in, uint8_t* ref);
+
+  uint8_t* ring;
+  uint8_t* ref;
+  size_t head;               // Куда пишется следующая точка
+
+  Point points[MAX_POINTS];  // Кольцевой индекс: first - самая старая
+  int first;
+  int count;
+
+  bool needBase;             // ref не совпадает с RAM - следующая точка = база
+  int frameCounter;
+
+  // Окно статистики
+  uint32_t wCaptures, wSumUs, wMaxUs, wSumBytes, wSumBlocks;
+};
+
+#endif // REWIND_BUFFER_H
@@ -0,0 +1,194 @@
+#include "save_states.h"
+#include <esp_heap_caps.h>
+
+static const char* const SAVE_DIR = "/ZXsaves";
+
+static const char* const RESULT_TEXT[] = {
+  "ok", "pending", "busy", "no PSRAM", "no /ZXsaves", "SD queue full",
+  "empty", "bad file", "read error", "write FAILED", "game changed", "failed"
+};
+static_assert(sizeof(RESULT_TEXT) / sizeof(RESULT_TEXT[0]) == SLOT_FAILED + 1, "RESULT_TEXT out of sync");
+
+SaveStates::SaveStates() : dirReady(false), userDone(nullptr), userCtx(nullptr) {
+  for (int i = 0; i < SLOT_COUNT; i++) {
+    slots[i].owner = this;
+    slots[i].index = i;
+    slots[i].image = nullptr;
+    slots[i].cached = false;
+    slots[i].writing = false;
+    slots[i].reading = false;
+    slots[i].offset = 0;
+    slots[i].target = nullptr;
+    slots[i].readError = SLOT_READ_ERROR;
+  }
+  strcpy(game, "BASIC");
+}
+
+const char* SaveStates::resultText(SaveLoadResult result) {
+  if (result < SLOT_OK || result > SLOT_FAILED) return RESULT_TEXT[SLOT_FAILED];
+  return RESULT_TEXT[result];
+}
+
+void SaveStates::setGame(const char* name) {
+  char next[sizeof(game)];
+  if (!name || !name[0]) {
+    strcpy(next, "BASIC");
+  } else {
+    // Имя файла без расширения (ATICATAC.TAP → ATICATAC)
+    strncpy(next, name, sizeof(next) - 1);
+    next[sizeof(next) - 1] = '\0';
+    char* dot = strrchr(next, '.');
+    if (dot && dot != next) *dot = '\0';
+  }
+  if (strcmp(next, game) == 0) return;
+
+  strcpy(game, next);
+  // Кэш - слоты прошлой игры (буферы остаются, идущая запись допишет старый файл);
+  // идущее чтение уже не восстанавливает машину
+  for (int i = 0; i < SLOT_COUNT; i++) {
+    slots[i].cached = false;
+    slots[i].target = nullptr;
+  }
+}
+
+void SaveStates::slotPath(int slot, char* out, size_t size) const {
+  snprintf(out, size, "%s/%s_%d.zxs", SAVE_DIR, game, slot + 1);
+}
+
+// /ZXsaves - один раз (первое сохранение), а не SD.exists на каждом:
+// это синхронный доступ к карте посреди кадра
+bool SaveStates::ensureDir() {
+  if (dirReady) return true;
+  if (!SD.exists(SAVE_DIR) && !SD.mkdir(SAVE_DIR)) {
+    Serial.println("❌ SAVE: failed to create /ZXsaves");
+    return false;
+  }
+  dirReady = true;
+  return true;
+}
+
+bool SaveStates::allocImage(Slot& s) {
+  if (!s.image) {
+    s.image = (uint8_t*)heap_caps_malloc(MachineSnapshot::SERIAL_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!s.image) {
+      Serial.println("❌ SAVE: no PSRAM for slot buffer");
+      return false;
+    }
+  }
+  return true;
+}
+
+// ═══ СОХРАНЕНИЕ ═══
+
+SaveLoadResult SaveStates::save(int slot, const ZXSpectrum* spectrum) {
+  if (slot < 0 || slot >= SLOT_COUNT) return SLOT_FAILED;
+  Slot& s = slots[slot];
+  if (busy(slot)) {
+    Serial.printf("⚠️  SAVE: slot %d still busy\n", slot + 1);
+    return SLOT_BUSY;
+  }
+  if (!ensureDir()) return SLOT_NO_DIR;
+  if (!allocImage(s)) return SLOT_NO_MEMORY;
+
+  uint32_t t0 = micros();
+  MachineSnapshot::captureImage(spectrum, s.image);
+  uint32_t dt = micros() - t0;
+
+  char path[64];
+  slotPath(slot, path, sizeof(path));
+  // Буфер не освобождается - он же кэш слота (writing защищает от перезаписи)
+  if (!busScheduler.submitFileWrite(path, s.image, MachineSnapshot::SERIAL_SIZE, false, writeDone, &s)) {
+    // Образ в буфере уже не тот, что в файле слота → кэш недействителен,
+    // загрузка прочитает файл (то, что реально сохранено)
+    s.cached = false;
+    Serial.println("⚠️  SAVE: bus queue full");
+    return SLOT_QUEUE_FULL;
+  }
+  s.cached = true;
+  s.writing = true;
+  Serial.printf("💾 SAVE: slot %d staged in %u us → %s\n", slot + 1, (unsigned)dt, path);
+  return SLOT_OK;
+}
+
+void SaveStates::writeDone(void* ctx, bool ok) {
+  Slot& s = *(Slot*)ctx;
+  s.writing = false;
+  if (!ok) s.owner->dirReady = false;  // Карту могли вынуть - проверить каталог заново
+  Serial.printf("%s SAVE: slot %d %s\n", ok ? "💾" : "❌", s.index + 1, ok ? "written" : "write failed");
+  if (s.owner->userDone) s.owner->userDone(s.owner->userCtx, s.index, true, ok ? SLOT_OK : SLOT_WRITE_ERROR);
+}
+
+// ═══ ЗАГРУЗКА ═══
+
+SaveLoadResult SaveStates::load(int slot, ZXSpectrum* spectrum) {
+  if (slot < 0 || slot >= SLOT_COUNT) return SLOT_FAILED;
+  Slot& s = slots[slot];
+  if (s.reading) return SLOT_BUSY;
+
+  if (s.cached) {
+    uint32_t t0 = micros();
+    if (!MachineSnapshot::restoreImage(s.image, MachineSnapshot::SERIAL_SIZE, spectrum)) return SLOT_BAD_FILE;
+    Serial.printf("💾 LOAD: slot %d from PSRAM in %u us\n", slot + 1, (unsigned)(micros() - t0));
+    return SLOT_OK;
+  }
+
+  if (s.writing) return SLOT_BUSY;
+  if (!allocImage(s)) return SLOT_NO_MEMORY;
+  s.offset = 0;
+  s.target = spectrum;
+  s.readError = SLOT_READ_ERROR;
+  BusJob job = {"save-read", readStep, readDone, &s};
+  if (!busScheduler.submit(job)) {
+    Serial.println("⚠️  LOAD: bus queue full");
+    return SLOT_QUEUE_FULL;
+  }
+  s.reading = true;
+  return SLOT_PENDING;
+}
+
+BusJobResult SaveStates::readStep(void* ctx, size_t maxBytes, size_t* bytesDone) {
+  Slot& s = *(Slot*)ctx;
+
+  // Первый шаг: только открытие (как запись планировщика)
+  if (!s.file) {
+    char path[64];
+    s.owner->slotPath(s.index, path, sizeof(path));
+    s.file = SD.open(path);
+    if (!s.file) {
+      Serial.printf("⚠️  LOAD: %s missing\n", path);
+      s.readError = SLOT_EMPTY;
+      return BUS_JOB_ERROR;
+    }
+    if (s.file.size() != MachineSnapshot::SERIAL_SIZE) {
+      Serial.printf("⚠️  LOAD: %s wrong size\n", path);
+      s.readError = SLOT_BAD_FILE;
+      return BUS_JOB_ERROR;
+    }
+    return BUS_JOB_MORE;
+  }
+
+  size_t toRead = MachineSnapshot::SERIAL_SIZE - s.offset;
+  if (toRead > maxBytes) toRead = maxBytes;
+  int got = s.file.read(s.image + s.offset, toRead);
+  if (got <= 0) return BUS_JOB_ERROR;
+  *bytesDone = got;
+  s.offset += got;
+  return s.offset >= MachineSnapshot::SERIAL_SIZE ? BUS_JOB_DONE : BUS_JOB_MORE;
+}
+
+void SaveStates::readDone(void* ctx, bool ok) {
+  Slot& s = *(Slot*)ctx;
+  if (s.file) s.file.close();
+  s.reading = false;
+
+  // Между кадрами (runIdle в loop) - машину можно подменять.
+  // target = nullptr - игра сменилась (setGame), слот чужой
+  SaveLoadResult result = !s.target ? SLOT_GAME_CHANGED : !ok ? s.readError : SLOT_OK;
+  if (result == SLOT_OK && !MachineSnapshot::restoreImage(s.image, MachineSnapshot::SERIAL_SIZE, s.target)) {
+    result = SLOT_BAD_FILE;
+  }
+  s.cached = result == SLOT_OK;
+  Serial.printf("%s LOAD: slot %d %s\n", s.cached ? "💾" : "❌", s.index + 1,
+                s.cached ? "restored from SD" : resultText(result));
+  if (s.owner->userDone) s.owner->userDone(s.owner->userCtx, s.index, false, result);
+}
@@ -0,0 +1,95 @@
+#ifndef SAVE_STATES_H
+#define SAVE_STATES_H
+
+#include <Arduino.h>
+#include <SD.h>
+#include "spectrum_mini.h"
+#include "machine_snapshot.h"
+#include "../external_display/spi_bus_scheduler.h"
+
+// ═══════════════════════════════════════════════════════════
+// 💾 SAVE STATES (V3.160): слоты быстрого сохранения
+// ═══════════════════════════════════════════════════════════
+//
+// Сохранение = MachineSnapshot::captureImage в PSRAM буфер слота
+// (одна копия 48K, ~0.5 мс между кадрами), файл пишет busScheduler
+// в окнах простоя шины - игра не стоит, пока карта занята.
+//
+// Буфер слота остаётся кэшем: загрузка сохранённого в этой сессии
+// слота = restoreImage из PSRAM, SD не трогается. Слот не в кэше
+// (после включения) → чтение файла фоновой задачей шины, машина
+// восстанавливается в done() (loop, между кадрами).
+//
+// Файлы: /ZXsaves/<игра>_<N>.zxs (образ MachineSnapshot, 49 KB).
+// Кэш привязан к игре: другая игра → слоты читаются из её файлов.
+// ═══════════════════════════════════════════════════════════
+
+enum SaveLoadResult {
+  SLOT_OK = 0,         // Сохранено в PSRAM (файл - в фоне) / восстановлено сразу (кэш)
+  SLOT_PENDING,        // Читается с SD, done-колбэк сообщит
+  SLOT_BUSY,           // Слот сейчас пишется/читается
+  SLOT_NO_MEMORY,      // Нет PSRAM под буфер слота
+  SLOT_NO_DIR,         // Не удалось создать /ZXsaves
+  SLOT_QUEUE_FULL,     // Очередь шины полна
+  SLOT_EMPTY,          // Файла слота нет
+  SLOT_BAD_FILE,       // Файл не того размера / не образ MachineSnapshot
+  SLOT_READ_ERROR,     // Ошибка чтения SD
+  SLOT_WRITE_ERROR,    // Ошибка записи SD
+  SLOT_GAME_CHANGED,   // Игра сменилась, пока слот читался (машину не трогаем)
+  SLOT_FAILED          // Неверный номер слота
+};
+
+// Завершение фоновой операции: saved = запись (false = загрузка),
+// result = SLOT_OK или причина ошибки
+typedef void (*SaveStateDoneFn)(void* ctx, int slot, bool saved, SaveLoadResult result);
+
+class SaveStates {
+public:
+  static const int SLOT_COUNT = 4;
+
+  SaveStates();
+
+  // game - имя файла игры ("" = BASIC); меняет набор слотов
+  void setGame(const char* game);
+
+  // Снимок в слот + фоновая запись. SLOT_OK или причина отказа
+  SaveLoadResult save(int slot, const ZXSpectrum* spectrum);
+  SaveLoadResult load(int slot, ZXSpectrum* spectrum);
+
+  // Короткое описание результата для уведомления ("busy", "no PSRAM", ...)
+  static const char* resultText(SaveLoadResult result);
+
+  inline bool busy(int slot) const { return slots[slot].writing || slots[slot].reading; }
+  void setDoneCallback(SaveStateDoneFn fn, void* ctx) { userDone = fn; userCtx = ctx; }
+
+private:
+  struct Slot {
+    SaveStates* owner;
+    int index;
+    uint8_t* image;        // PSRAM, MachineSnapshot::SERIAL_SIZE
+    bool cached;           // image = содержимое слота этой игры
+    bool writing;
+    bool reading;
+    // Фоновое чтение
+    File file;
+    size_t offset;
+    ZXSpectrum* target;
+    SaveLoadResult readError;   // Причина, если readStep вернул ошибку
+  };
+
+  bool allocImage(Slot& s);
+  bool ensureDir();
+  void slotPath(int slot, char* out, size_t size) const;
+
+  static void writeDone(void* ctx, bool ok);
+  static BusJobResult readStep(void* ctx, size_t maxBytes, size_t* bytesDone);
+  static void readDone(void* ctx, bool ok);
+
+  Slot slots[SLOT_COUNT];
+  char game[48];
+  bool dirReady;             // /ZXsaves уже есть (проверено один раз)
+  SaveStateDoneFn userDone;
+  void* userCtx;
+};
+
+#endif // SAVE_STATES_H
@@ -1,5 +1,6 @@
 #include "spectrum_mini.h"
 #include "48k_rom.h"
+#include "machine_snapshot.h"
 
 // ZX Spectrum 16-color palette in RGB565 format
 const uint16_t specpal565[16] = {
@@ -36,6 +37,7 @@ ZXSpectrum::ZXSpectrum() {
     Serial.println("Failed to allocate Z80Regs");
   }
   z80Regs->userInfo = this;
+  setJoystickMode(JOY_QAOP);  // V3.154: таблица клавиш джойстика
 }
 
 // HUD snapshot (taken at mid-frame, not during INT!)
@@ -47,11 +49,30 @@ static uint16_t hud_sp = 0;
 void ZXSpectrum::reset() {
   Z80Reset(z80Regs);
   Z80FlagTables();
+  resetAY();
+}
+
+void ZXSpectrum::warmReset() {
+  if (readySnapshot && readySnapshot->restore(this)) {
+    memset(speckey, 0xFF, 8);  // Клавиши с прошлой игры не "залипают"
+    return;
+  }
+  reset();
+}
+
+// V3.148: Сброс AY (регистры → 0, микшер выключен). Audio Task узнаёт
+// об этом через ayResync следующего кадра.
+void ZXSpectrum::resetAY() {
+  memset(ayRegs, 0, sizeof(ayRegs));
+  ayRegs[7] = 0xFF;
+  ayLatch = 0;
+  ayWriteCount = 0;
+  ayResyncPending = true;
 }
 
 // Run emulation for one frame (312 lines × 224 tstates = 69888 tstates)
-// ТАКЖЕ генерирует audioBuffer для звука!
-int ZXSpectrum::runForFrame(uint16_t *accumOut) {
+// ТАКЖЕ собирает фронты beeper (beeperEdges) для звука!
+int ZXSpectrum::runForFrame() {
   static int totalFrames = 0;
   static bool im1Detected = false;
   
@@ -59,21 +80,20 @@ int ZXSpectrum::runForFrame(uint16_t *accumOut) {
   const int TSTATES_PER_LINE = 224;
   int cyclesExecuted = 0;
   
+  // V3.144: новый кадр фронтов beeper (V3.150: + EAR, AY)
+  beginAudioFrame();
+  
   // ═══ ЭМУЛЯЦИЯ КАДРА ПО ЛИНИЯМ (как ESP32-Rainbow) ═══
   for (int line = 0; line < LINES_PER_FRAME; line++) {
-    // Сброс звукового аккумулятора перед каждой линией
-    soundAccumulator = 0;
+    // V3.155: Свежий ввод перед INT (клавиатура/джойстик)
+    if (line == inputLatchLine && inputLatchFn) {
+      inputLatchFn(inputLatchCtx);
+    }
     
     // Запускаем Z80 на 224 t-states (1 линия)
     int used = runForCycles(TSTATES_PER_LINE);
     cyclesExecuted += used;
     
-    // ═══ V3.111: СОХРАНЕНИЕ RAW ACCUMULATOR для ChatGPT beeper ═══
-    // soundAccumulator = сколько t-states beeper был включен (0-224)
-    if (accumOut) {
-      accumOut[line] = soundAccumulator;  // ✅ Передаем RAW значение (0-224)!
-    }
-    
     // Snapshot в середине кадра (линия 156 из 312)
     if (line == 156) {
       hud_pc = z80Regs->PC.W;
@@ -95,10 +115,74 @@ int ZXSpectrum::runForFrame(uint16_t *accumOut) {
                   totalFrames, totalFrames / 50.0);
   }
   
+  // ═══ V3.139: ФАЗА FLASH (привязана к эмулируемым кадрам) ═══
+  if (++flashCounter >= 16) {
+    flashCounter = 0;
+    flashPhase = !flashPhase;
+  }
+  
   totalFrames++;
   return cyclesExecuted;
 }
 
+// ═══ V3.150: АУДИО КАДР ═══
+void ZXSpectrum::beginAudioFrame() {
+  frameTstates = 0;
+  beeperEdgeCount = 0;
+  beeperStartLevel = audioLevels();
+  
+  // V3.148: новый кадр записей AY
+  ayWriteCount = 0;
+  latchAYResync();
+}
+
+// V3.148: ресинхронизация AY - снимок регистров на НАЧАЛО кадра. Audio Task
+// принимает его, затем проигрывает лог кадра → состояние в конце кадра точное
+// (снимок на конец + лог поверх оставлял бы чип на последней записи лога)
+void ZXSpectrum::latchAYResync() {
+  ayResync = ayResyncPending;
+  ayResyncPending = false;
+  if (ayResync) memcpy(ayResyncRegs, ayRegs, sizeof(ayResyncRegs));
+}
+
+int ZXSpectrum::audioEdgesBefore(uint32_t frameLen) const {
+  int n = beeperEdgeCount;
+  while (n > 0 && (beeperEdges[n - 1] & ~BeeperSynth::EDGE_EAR) >= frameLen) n--;
+  return n;
+}
+
+int ZXSpectrum::ayWritesBefore(uint32_t frameLen) const {
+  int n = ayWriteCount;
+  while (n > 0 && ayWrites[n - 1].t >= frameLen) n--;
+  return n;
+}
+
+void ZXSpectrum::carryAudioFrame(uint32_t frameLen) {
+  // Уровни на границе = текущие минус переключения из хвоста
+  // (не из суммы отправленных - лог мог переполниться)
+  uint8_t levels = audioLevels();
+  int n = audioEdgesBefore(frameLen);
+  int tail = beeperEdgeCount - n;
+  for (int i = 0; i < tail; i++) {
+    uint32_t e = beeperEdges[n + i];
+    levels ^= (e & BeeperSynth::EDGE_EAR) ? 2 : 1;
+    beeperEdges[i] = e - frameLen;  // Флаг EAR в старшем бите не задет
+  }
+  beeperEdgeCount = tail;
+  beeperStartLevel = levels;
+  
+  int na = ayWritesBefore(frameLen);
+  int ayTail = ayWriteCount - na;
+  for (int i = 0; i < ayTail; i++) {
+    ayWrites[i] = ayWrites[na + i];
+    ayWrites[i].t -= frameLen;
+  }
+  ayWriteCount = ayTail;
+  latchAYResync();  // Записи хвоста уже в ayRegs - повтор их из лога безвреден
+  
+  frameTstates = (frameTstates > frameLen) ? frameTstates - frameLen : 0;
+}
+
 void ZXSpectrum::interrupt() {
   Z80Interrupt(z80Regs, 0x38);  // IM1: RST 38h
 }
@@ -115,6 +199,38 @@ void ZXSpectrum::updateKey(SpecKeys key, uint8_t state) {
   }
 }
 
+// V3.154: Клавиши режимов джойстика в порядке битов: RIGHT, LEFT, DOWN, UP, FIRE
+static const SpecKeys JOY_MODE_KEYS[JOY_MODE_COUNT][ZXSpectrum::JOY_BITS] = {
+  {SPECKEY_P, SPECKEY_O, SPECKEY_A, SPECKEY_Q, SPECKEY_SPACE},   // QAOP
+  {SPECKEY_NONE, SPECKEY_NONE, SPECKEY_NONE, SPECKEY_NONE, SPECKEY_NONE},  // Kempston (порт)
+  {SPECKEY_7, SPECKEY_6, SPECKEY_8, SPECKEY_9, SPECKEY_0},       // Sinclair 1
+  {SPECKEY_2, SPECKEY_1, SPECKEY_3, SPECKEY_4, SPECKEY_5},       // Sinclair 2
+  {SPECKEY_8, SPECKEY_5, SPECKEY_6, SPECKEY_7, SPECKEY_0},       // Cursor
+};
+
+static const char* const JOY_MODE_NAMES[JOY_MODE_COUNT] = {
+  "QAOP", "KEMPSTON", "SINCLAIR1", "SINCLAIR2", "CURSOR"
+};
+
+void ZXSpectrum::setJoystickMode(JoystickMode mode) {
+  if (mode < 0 || mode >= JOY_MODE_COUNT) mode = JOY_QAOP;
+  joystickMode = mode;
+  for (int i = 0; i < JOY_BITS; i++) {
+    SpecKeys key = JOY_MODE_KEYS[mode][i];
+    if (key > SPECKEY_NONE && key < SPECKEY_MAX_NORMAL) {
+      joyKeyRow[i] = key2specy[0][key];
+      joyKeyMask[i] = key2specy[1][key];
+    } else {
+      joyKeyRow[i] = 0;
+      joyKeyMask[i] = 0xFF;  // Ничего не нажимает
+    }
+  }
+}
+
+const char* ZXSpectrum::joystickModeName(JoystickMode mode) {
+  return (mode >= 0 && mode < JOY_MODE_COUNT) ? JOY_MODE_NAMES[mode] : "?";
+}
+
 bool ZXSpectrum::init_48k() {
   // ULA config for 48K
   hwopt.emulate_FF = 1;
@@ -165,6 +281,7 @@ bool ZXSpectrum::init_48k() {
 
 void ZXSpectrum::reset_spectrum() {
   Z80Reset(z80Regs);
+  resetAY();
 }
 
 // HUD getters (return mid-frame snapshot, not INT state!)
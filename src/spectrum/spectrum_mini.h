@@ -5,15 +5,33 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <atomic>
 #include "../z80/z80.h"
+#include "../audio/ay_chip.h"
+#include "../audio/beeper_synth.h"
 #include "keyboard_defs.h"
 
 // Global keyboard state (8 rows, bit 0 = pressed)
 extern uint8_t speckey[8];
 
+// SpecKeys → {строка матрицы, AND-маска нажатия} (V3.153: нужна input/keymap)
+extern const int key2specy[2][41];
+
+class MachineSnapshot;  // V3.157: machine_snapshot.h
+
 // ZX Spectrum 16-color palette in RGB565 format
 extern const uint16_t specpal565[16];
 
+// V3.154: Как игра видит джойстик (выбирается для каждой игры, Opt+K)
+enum JoystickMode {
+  JOY_QAOP = 0,      // Клавиши Q A O P + SPACE (по умолчанию, как раньше)
+  JOY_KEMPSTON,      // Порт 0x1F (A5 = 0)
+  JOY_SINCLAIR1,     // Interface 2 порт 1: клавиши 6 7 8 9 0
+  JOY_SINCLAIR2,     // Interface 2 порт 2: клавиши 1 2 3 4 5
+  JOY_CURSOR,        // Protek/AGF: клавиши 5 6 7 8 + 0
+  JOY_MODE_COUNT
+};
+
 enum models_enum
 {
   SPECMDL_48K = 2,
@@ -45,6 +63,12 @@ public:
   uint8_t *rom = nullptr;      // 16K ROM @ 0x0000-0x3FFF
   uint8_t *ram = nullptr;      // 48K RAM @ 0x4000-0xFFFF
   uint8_t *screen = nullptr;   // Pointer to screen @ 0x4000
+  
+  // V3.161: Блоки RAM по 256 байт, изменённые с последнего снимка перемотки
+  // (RewindBuffer кодирует только их). Запись мимо poke → markAllDirty()
+  static const int DIRTY_SHIFT = 8;
+  static const int DIRTY_BLOCKS = 0xC000 >> DIRTY_SHIFT;
+  uint8_t dirty[DIRTY_BLOCKS];
 
   Memory() {
     // Allocate ROM (16K)
@@ -63,6 +87,7 @@ public:
 
     // Screen points to 0x4000 in RAM
     screen = ram;
+    markAllDirty();
   }
 
   ~Memory() {
@@ -81,10 +106,15 @@ public:
   inline void poke(uint16_t address, uint8_t value) {
     if (address >= 0x4000) {
       ram[address - 0x4000] = value;
+      dirty[(address - 0x4000) >> DIRTY_SHIFT] = 1;
     }
     // Ignore writes to ROM
   }
 
+  inline void markAllDirty() {
+    memset(dirty, 1, sizeof(dirty));
+  }
+
   void loadRom(const uint8_t *rom_data, int rom_len) {
     if (rom_len > 0x4000) rom_len = 0x4000;
     memcpy(rom, rom_data, rom_len);
@@ -114,23 +144,88 @@ public:
   
   // ═══ ЗВУКОВАЯ СИСТЕМА (BEEPER) ═══
   uint8_t soundBits = 0;           // Бит 4 из порта 0xFE (beeper state)
-  uint16_t soundAccumulator = 0;   // Накопленные t-states когда beeper активен
+  
+  // ═══ V3.144: ЛОГ ФРОНТОВ BEEPER (вместо накопления по строкам) ═══
+  // z80_out пишет t-state каждого переключения бита 4 от начала кадра.
+  // Audio Task строит по ним band-limited звук (audio/beeper_synth.h).
+  // V3.150: + фронты EAR (лента) в том же логе, с флагом BeeperSynth::EDGE_EAR
+  static const int MAX_BEEPER_EDGES = 1024;  // ~50 кГц переключений - с запасом
+  static const uint32_t FRAME_TSTATES = 69888;
+  uint32_t beeperEdges[MAX_BEEPER_EDGES];
+  uint16_t beeperEdgeCount = 0;
+  uint8_t beeperStartLevel = 0;    // Уровни в начале кадра: бит 0 beeper, бит 1 EAR
+  uint32_t frameTstates = 0;       // t-states кадра до текущего Z80Run
+  int runBudget = 0;               // numcycles текущего Z80Run
+  
+  // ═══ V3.148: AY-3-8912 (порты 0xFFFD выбор / 0xBFFD запись) ═══
+  // Здесь только регистры + лог записей кадра; синтез - в Audio Task
+  static const int MAX_AY_WRITES = 256;      // Обычный плеер пишет ~14 за кадр
+  AYWrite ayWrites[MAX_AY_WRITES];
+  uint16_t ayWriteCount = 0;
+  uint8_t ayLatch = 0;             // Выбранный регистр (≥16 → никакой)
+  uint8_t ayRegs[16] = {0};        // Текущие значения (для IN 0xFFFD и ресинхронизации)
+  bool ayResync = false;           // Кадр начинается с ayResyncRegs целиком (потом лог)
+  bool ayResyncPending = false;    // Сброс / переполнение лога → ресинхронизация в следующем кадре
+  uint8_t ayResyncRegs[16] = {0};  // ayRegs на начало кадра с ayResync
+  
+  // ═══ V3.139: FLASH (атрибут бит 7) ═══
+  // ULA меняет фазу каждые 16 кадров (период мигания 32 кадра = 0.64 с)
+  uint8_t flashCounter = 0;        // Кадры с последней смены фазы (0-15)
+  bool flashPhase = false;         // true = ink/paper переставлены
+  
+  // ═══ V3.154: ДЖОЙСТИК В ПОРТАХ ═══
+  // Источник - ОДИН опубликованный байт (KEMPSTON_*: 0 R, 1 L, 2 D, 3 U, 4 FIRE),
+  // который обновляет задача опроса. z80_in читает его на каждом IN:
+  // Kempston - как порт, остальные режимы - как нажатия в полустроках.
+  // Матрица speckey не переписывается, гонки со сканом клавиатуры нет.
+  const std::atomic<uint8_t>* joystickSource = nullptr;  // nullptr = отключён
+  JoystickMode joystickMode = JOY_QAOP;
+  static const int JOY_BITS = 5;   // Значимые биты байта (старшие отбрасываются)
+  uint8_t joyKeyRow[JOY_BITS] = {0};      // Бит направления → строка матрицы
+  uint8_t joyKeyMask[JOY_BITS] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF};  // → AND-маска строки
+  
+  // ═══ V3.159: ПОДПИСЬ ЧТЕНИЙ ВВОДА (запись/повтор ввода) ═══
+  // Каждый IN клавиатуры (0xFE) и Kempston: счётчик + сумма t-states.
+  // InputReplay обнуляет перед кадром и сверяет после: расхождение =
+  // программа прочитала ввод не там же, где при записи.
+  // Считается только пока inputSignature (кадр записи/повтора) - без
+  // них IN не платит за счётчики
+  bool inputSignature = false;
+  uint32_t inputReads = 0;
+  uint32_t inputReadTsum = 0;
+  
+  // ═══ V3.155: ЗАХВАТ ВВОДА ПОСРЕДИ КАДРА ═══
+  // runForFrame() вызывает hook в начале строки inputLatchLine (0-311),
+  // т.е. ввод обновляется незадолго до INT, а не за целый кадр до него
+  typedef void (*InputLatchFn)(void* ctx);
+  int inputLatchLine = -1;         // < 0 = выключено
+  InputLatchFn inputLatchFn = nullptr;
+  void* inputLatchCtx = nullptr;
+  
+  // ═══ V3.157: БЫСТРЫЙ СТАРТ ═══
+  // Снимок в точке готовности ROM (снимается при запуске, см. main setup)
+  const MachineSnapshot* readySnapshot = nullptr;
 
   ZXSpectrum();
   void reset();
-  int runForFrame(uint16_t *accumOut);  // ✅ V3.111: uint16_t[312] для ChatGPT beeper
+  // V3.157: Сброс сразу в готовую ROM (снимок), без снимка - обычный reset()
+  void warmReset();
+  
+  // V3.157: ROM закончил инициализацию: IM 1 и напечатан копирайт
+  // (TV_FLAG бит 5 - "очистить нижний экран при нажатии")
+  inline bool romReady() const {
+    return z80Regs->IM == 1 && (mem.ram[23612 - 0x4000] & 0x20);
+  }
+  int runForFrame();  // ✅ V3.144: звук = beeperEdges[] (t-states фронтов)
   inline int runForCycles(int cycles) {
     static int callCount = 0;
     uint16_t pcBefore = z80Regs->PC.W;
     int cyclesBefore = z80Regs->cycles;
     
+    runBudget = cycles;  // V3.144: для t-state фронта в z80_out
     int used = Z80Run(z80Regs, cycles);
-    
-    // ═══ НАКОПЛЕНИЕ ЗВУКА ═══
-    // Если beeper активен (soundBits != 0), накапливаем t-states
-    if (soundBits) {
-      soundAccumulator += used;
-    }
+    frameTstates += used;
+    runBudget = z80Regs->cycles;  // V3.150: вне Z80Run frameTstateNow() == frameTstates
     
     uint16_t pcAfter = z80Regs->PC.W;
     int cyclesAfter = z80Regs->cycles;
@@ -145,6 +240,38 @@ public:
 
   void interrupt();
   void updateKey(SpecKeys key, uint8_t state);
+  void resetAY();
+  void setJoystickMode(JoystickMode mode);
+  inline void setInputLatch(int line, InputLatchFn fn, void* ctx) {
+    inputLatchLine = line;
+    inputLatchFn = fn;
+    inputLatchCtx = ctx;
+  }
+  static const char* joystickModeName(JoystickMode mode);
+  
+  // Kempston отдаёт только биты 0-4; они же - индексы joyKeyRow/joyKeyMask
+  inline uint8_t joystickBits() const {
+    return joystickSource ? (joystickSource->load(std::memory_order_relaxed) & ((1 << JOY_BITS) - 1)) : 0;
+  }
+  
+  // ═══ V3.150: АУДИО КАДР (фронты beeper/EAR + записи AY) ═══
+  // runForFrame() начинает кадр сам. TapeListener крутит runForCycles()
+  // кусками любой длины и закрывает кадр, когда frameTstates ≥ FRAME_TSTATES:
+  // первые N фронтов/записей (t < frameLen) уходят в Audio Task,
+  // хвост переносится в следующий кадр со сдвигом на -frameLen.
+  void beginAudioFrame();
+  void latchAYResync();
+  int audioEdgesBefore(uint32_t frameLen) const;
+  int ayWritesBefore(uint32_t frameLen) const;
+  void carryAudioFrame(uint32_t frameLen);
+  inline uint8_t audioLevels() const {
+    return (soundBits ? 1 : 0) | (micLevel ? 2 : 0);
+  }
+
+  // V3.148: t-state от начала кадра (cycles считает вниз от runBudget внутри Z80Run)
+  inline uint32_t frameTstateNow() const {
+    return frameTstates + (runBudget - z80Regs->cycles);
+  }
 
   inline uint8_t z80_peek(uint16_t address) {
     return mem.peek(address);
@@ -157,6 +284,10 @@ public:
   // Port 0xFE read (keyboard + border + mic)
   inline uint8_t z80_in(uint16_t port) {
     if ((port & 0x01) == 0) {
+      if (inputSignature) {  // V3.159
+        inputReads++;
+        inputReadTsum += frameTstateNow();
+      }
       uint8_t data = 0xFF;
       if (!(port & 0x0100)) data &= speckey[0]; // SHIFT, Z-V
       if (!(port & 0x0200)) data &= speckey[1]; // A-G
@@ -167,6 +298,14 @@ public:
       if (!(port & 0x4000)) data &= speckey[6]; // ENTER-H
       if (!(port & 0x8000)) data &= speckey[7]; // SPACE-B
 
+      // V3.154: Клавишные режимы джойстика - поверх матрицы, без записи в неё
+      if (joystickMode != JOY_KEMPSTON) {
+        uint8_t joy = joystickBits();
+        for (int i = 0; i < JOY_BITS && joy; i++, joy >>= 1) {
+          if ((joy & 1) && !(port & (0x0100 << joyKeyRow[i]))) data &= joyKeyMask[i];
+        }
+      }
+
       // Bit 6 = MIC/EAR
       if (micLevel) {
         data |= 0x40;
@@ -175,6 +314,18 @@ public:
       }
       return data;
     }
+    // V3.154: Kempston - интерфейс декодирует только A5 (0x1F, 0xDF...)
+    if ((port & 0x20) == 0 && joystickMode == JOY_KEMPSTON) {
+      if (inputSignature) {  // V3.159
+        inputReads++;
+        inputReadTsum += frameTstateNow();
+      }
+      return joystickBits();
+    }
+    // V3.148: AY - чтение выбранного регистра (0xFFFD)
+    if ((port & 0xC002) == 0xC000) {
+      return (ayLatch < 16) ? ayRegs[ayLatch] : 0xFF;
+    }
     // Port 0xFF emulation
     if ((port & 0xFF) == 0xFF && hwopt.emulate_FF) {
       return hwopt.portFF;
@@ -182,11 +333,36 @@ public:
     return 0xFF;
   }
 
-  // Port 0xFE write (border + beeper)
+  // Port 0xFE write (border + beeper), 0xFFFD/0xBFFD (AY)
   inline void z80_out(uint16_t port, uint8_t data) {
     if (!(port & 0x01)) {  // Порт 0xFE (ULA)
       borderColor = (data & 0x07);        // Биты 0-2: Border Color
-      soundBits = (data & 0b00010000);    // Бит 4: BEEPER (звук!)
+      // Бит 4: BEEPER (звук!)
+      // V3.144: логируем только ПЕРЕКЛЮЧЕНИЯ - сравнение вместо присваивания
+      uint8_t bit = (data & 0b00010000);
+      if (bit != soundBits) {
+        soundBits = bit;
+        if (beeperEdgeCount < MAX_BEEPER_EDGES) {
+          beeperEdges[beeperEdgeCount++] = frameTstateNow();
+        }
+      }
+    } else if ((port & 0xC002) == 0xC000) {  // 0xFFFD: выбор регистра AY
+      ayLatch = data;
+    } else if ((port & 0xC002) == 0x8000) {  // 0xBFFD: запись в регистр AY
+      if (ayLatch < 16) {
+        ayRegs[ayLatch] = data & AYChip::REG_MASK[ayLatch];
+        // V3.148: стоимость на ядре эмуляции - одна запись в лог
+        if (ayWriteCount < MAX_AY_WRITES) {
+          AYWrite& w = ayWrites[ayWriteCount++];
+          w.t = frameTstateNow();
+          w.reg = ayLatch;
+          w.val = data;
+        } else {
+          // Лог переполнен: записи до конца кадра теряются, следующий кадр
+          // начнётся с ayRegs целиком (снимок на его начало - точный)
+          ayResyncPending = true;
+        }
+      }
     }
   }
 
@@ -194,16 +370,25 @@ public:
   void reset_spectrum();
   
   // ═══ TAPE EMULATION: MIC/EAR CONTROL ═══
+  // V3.150: каждое переключение EAR - фронт в общем логе (звук загрузки)
+  inline void setMic(bool level) {
+    if (level == micLevel) return;
+    micLevel = level;
+    if (beeperEdgeCount < MAX_BEEPER_EDGES) {
+      beeperEdges[beeperEdgeCount++] = frameTstateNow() | BeeperSynth::EDGE_EAR;
+    }
+  }
+  
   inline void setMicHigh() {
-    micLevel = true;
+    setMic(true);
   }
   
   inline void setMicLow() {
-    micLevel = false;
+    setMic(false);
   }
   
   inline void toggleMic() {
-    micLevel = !micLevel;
+    setMic(!micLevel);
   }
   
   // HUD getters (snapshot taken at mid-frame, not during INT!)
@@ -1,6 +1,7 @@
 #include "tap_loader.h"
 #include "tape_listener.h"
 #include "tape_cas.h"
+#include "input_script.h"
 #include <SD.h>
 
 TAPLoader::TAPLoader() {
@@ -55,49 +56,29 @@ bool TAPLoader::loadTAP(const char* filename, ZXSpectrum* spectrum, RenderCallba
   file.close();
   
   // ═══ 3. RESET SPECTRUM ═══
+  // V3.157: из снимка готовой ROM (если есть) - без ~80 кадров инициализации
   Serial.println("\n🔄 Resetting Spectrum...");
-  spectrum->reset();
-  
-  // ═══ 4. ЖДЁМ ИНИЦИАЛИЗАЦИЮ ROM (~200 кадров = 4 секунды) ═══
-  Serial.println("⏳ Waiting for ROM initialization...");
-  for (int i = 0; i < 200; i++) {
-    spectrum->runForFrame(nullptr);  // Без звука во время загрузки
-    if (i % 50 == 0) {
-      Serial.printf("  Frame %d/200\n", i);
-    }
+  spectrum->warmReset();
+  
+  // ═══ 4-5. ЖДЁМ ROM И НАБИРАЕМ LOAD "" (V3.156: сценарий, без фиксированных пауз) ═══
+  // Раньше: 200 кадров ожидания + 10 кадров на каждое нажатие/отпускание
+  Serial.println("⌨️  Typing: LOAD \"\" (input script)");
+  InputScript script;
+  script.waitRomReady();
+  script.type(SPECKEY_J);                  // J = LOAD (режим K)
+  script.type(SPECKEY_P, SPECKEY_SYMB);    // SYMBOL SHIFT + P = "
+  script.type(SPECKEY_P, SPECKEY_SYMB);    // " (снова)
+  script.type(SPECKEY_ENTER);
+  
+  int typedFrames = script.run(spectrum, 600);
+  if (typedFrames < 0) {
+    snprintf(lastError, sizeof(lastError), "LOAD \"\" not accepted by ROM");
+    free(tapData);
+    Serial.println("❌ LOAD \"\" script failed");
+    return false;
   }
   
-  // ═══ 5. СИМУЛИРУЕМ НАЖАТИЕ "LOAD ""  ═══
-  Serial.println("\n⌨️  Typing: LOAD \"\"");
-  
-  // J = LOAD
-  spectrum->updateKey(SPECKEY_J, 1);
-  for (int i = 0; i < 10; i++) spectrum->runForFrame(nullptr);
-  spectrum->updateKey(SPECKEY_J, 0);
-  for (int i = 0; i < 10; i++) spectrum->runForFrame(nullptr);
-  
-  // SYMBOL SHIFT + P = "
-  spectrum->updateKey(SPECKEY_SYMB, 1);
-  for (int i = 0; i < 10; i++) spectrum->runForFrame(nullptr);
-  spectrum->updateKey(SPECKEY_P, 1);
-  for (int i = 0; i < 10; i++) spectrum->runForFrame(nullptr);
-  spectrum->updateKey(SPECKEY_P, 0);
-  for (int i = 0; i < 10; i++) spectrum->runForFrame(nullptr);
-  
-  // SYMBOL SHIFT + P = " (снова)
-  spectrum->updateKey(SPECKEY_P, 1);
-  for (int i = 0; i < 10; i++) spectrum->runForFrame(nullptr);
-  spectrum->updateKey(SPECKEY_P, 0);
-  for (int i = 0; i < 10; i++) spectrum->runForFrame(nullptr);
-  spectrum->updateKey(SPECKEY_SYMB, 0);
-  
-  // ENTER
-  spectrum->updateKey(SPECKEY_ENTER, 1);
-  for (int i = 0; i < 10; i++) spectrum->runForFrame(nullptr);
-  spectrum->updateKey(SPECKEY_ENTER, 0);
-  for (int i = 0; i < 10; i++) spectrum->runForFrame(nullptr);
-  
-  Serial.println("✅ LOAD \"\" entered!");
+  Serial.printf("✅ LOAD \"\" entered! (%d frames, was 290)\n", typedFrames);
   
   // ═══ 6. ЗАПУСКАЕМ TAPE EMULATION ═══
   Serial.println("\n📼 Starting tape emulation...");
@@ -17,6 +17,7 @@
 // 
 // V3.115: Добавлен callback для рендеринга loading screen! 🎨
 // V3.117: Добавлена генерация beeper звука во время загрузки! 🔊
+// V3.150: Звук загрузки - фронты EAR в общем логе кадра (без своего буфера)
 // 
 // Реализовано по аналогии с ESP32-Rainbow:
 // - ZXSpectrumTapeListener из esp32-rainbow/firmware/src/TZX/
@@ -28,11 +29,8 @@
 // Callback для рендеринга экрана
 using RenderCallback = std::function<void()>;
 
-// Forward declaration для аудио системы
-extern void ZX_BeeperSubmitFrame(const uint16_t* accum312);
-// Доступ к настройкам громкости
-extern int soundVolume;      // 0-10
-extern bool soundEnabled;    // true/false
+// Forward declaration для аудио системы (V3.150: кадр фронтов beeper/EAR + AY)
+extern void ZX_SubmitAudioFrame(ZXSpectrum* spec, uint32_t frameLen);
 
 class TapeListener {
 public:
@@ -44,16 +42,10 @@ protected:
   RenderCallback renderCallback;
   int renderCounter = 0;
   
-  // ═══ АУДИО ДЛЯ BEEPER ЗВУКОВ ═══
-  uint16_t audioBuffer[312];     // Буфер для 312 строк
-  int audioLineCounter = 0;       // Счётчик строк
-  uint64_t audioTicksAccumulator = 0;  // Накопленные t-states
-  uint16_t lastAmplitude = 0;     // Предыдущее значение (для сглаживания)
-  
 public:
   TapeListener(ZXSpectrum* spec, RenderCallback callback = nullptr) 
     : spectrum(spec), renderCallback(callback) {
-    memset(audioBuffer, 0, sizeof(audioBuffer));
+    spectrum->beginAudioFrame();  // V3.150: кадры загрузки с нуля
   }
   virtual ~TapeListener() {}
   
@@ -72,62 +64,25 @@ public:
   }
   
   // ═══ ЗАПУСК ЭМУЛЯТОРА ═══
+  // V3.150: звук ленты = фронты EAR в логе ZXSpectrum (setMic*), тот же
+  // синтез и громкость, что у beeper. Здесь только закрываем аудио кадры
+  // по 69888 t-states - длина кусков runForTicks может быть любой.
   
   inline void runForTicks(uint64_t ticks) {
     addTicks(ticks);
     spectrum->runForCycles(ticks);
-    
-    // 🔊 АУДИО: накапливаем t-states и генерируем звук
-    audioTicksAccumulator += ticks;
-    
-    // Каждые 224 t-states = 1 строка
-    while (audioTicksAccumulator >= 224) {
-      audioTicksAccumulator -= 224;
-      
-      // Записываем текущее значение EAR input с учётом громкости!
-      // Во время tape emulation звук идёт от micLevel, а не soundBits!
-      // Применяем громкость: 0-10 → 0.0-1.0
-      // 🔊 TAPE LOADING: Автоматически на 2 уровня тише!
-      int tapeVolume = soundVolume >= 2 ? (soundVolume - 2) : 0;
-      float volumeScale = soundEnabled ? (float(tapeVolume) / 10.0f) : 0.0f;
-      uint16_t targetAmplitude = spectrum->micLevel ? uint16_t(224 * volumeScale) : 0;
-      
-      // 🎵 СГЛАЖИВАНИЕ для чистоты: среднее между текущим и предыдущим
-      uint16_t smoothedAmplitude = (targetAmplitude + lastAmplitude) / 2;
-      audioBuffer[audioLineCounter] = smoothedAmplitude;
-      lastAmplitude = targetAmplitude;
-      audioLineCounter++;
-      
-      // Когда накопилось 312 строк = 1 кадр → отправляем!
-      if (audioLineCounter >= 312) {
-        ZX_BeeperSubmitFrame(audioBuffer);
-        audioLineCounter = 0;
-        memset(audioBuffer, 0, sizeof(audioBuffer));
-      }
-    }
+    flushAudioFrames();
   }
   
   inline void pause1Millis() {
     addTicks(MILLI_SECOND);
     spectrum->runForCycles(MILLI_SECOND);
-    
-    // Аудио для пауз тоже генерируем (с учётом громкости + сглаживание)
-    audioTicksAccumulator += MILLI_SECOND;
-    while (audioTicksAccumulator >= 224) {
-      audioTicksAccumulator -= 224;
-      // 🔊 TAPE LOADING: Автоматически на 2 уровня тише!
-      int tapeVolume = soundVolume >= 2 ? (soundVolume - 2) : 0;
-      float volumeScale = soundEnabled ? (float(tapeVolume) / 10.0f) : 0.0f;
-      uint16_t targetAmplitude = spectrum->micLevel ? uint16_t(224 * volumeScale) : 0;
-      uint16_t smoothedAmplitude = (targetAmplitude + lastAmplitude) / 2;
-      audioBuffer[audioLineCounter] = smoothedAmplitude;
-      lastAmplitude = targetAmplitude;
-      audioLineCounter++;
-      if (audioLineCounter >= 312) {
-        ZX_BeeperSubmitFrame(audioBuffer);
-        audioLineCounter = 0;
-        memset(audioBuffer, 0, sizeof(audioBuffer));
-      }
+    flushAudioFrames();
+  }
+  
+  inline void flushAudioFrames() {
+    while (spectrum->frameTstates >= ZXSpectrum::FRAME_TSTATES) {
+      ZX_SubmitAudioFrame(spectrum, ZXSpectrum::FRAME_TSTATES);
     }
   }
   
@@ -16,43 +16,114 @@ uint16_t Z80Loader::readUInt16(uint8_t* data) {
 }
 
 // ═══════════════════════════════════════════════════════════
-// RLE декомпрессия (ED ED xx yy)
+// V3.162: Потоковая RLE декомпрессия (ED ED xx yy)
 // ═══════════════════════════════════════════════════════════
-bool Z80Loader::decompressBlock(uint8_t* compressed, size_t compressedSize, 
-                                 uint8_t* output, size_t outputSize) {
-  size_t inPos = 0;
-  size_t outPos = 0;
+void Z80RleStream::begin(uint8_t* output, size_t outputSize) {
+  out = output;
+  outPos = 0;
+  outSize = outputSize;
+  state = RLE_DATA;
+  count = 0;
+  endMarker = false;
+}
+
+bool Z80RleStream::feed(const uint8_t* in, size_t len) {
+  const uint8_t* end = in + len;
   
-  while (inPos < compressedSize && outPos < outputSize) {
-    uint8_t byte = compressed[inPos++];
+  while (in < end) {
+    if (outPos >= outSize) return false;
     
-    // Проверяем на RLE маркер (ED ED)
-    if (byte == 0xED && inPos < compressedSize && compressed[inPos] == 0xED) {
-      inPos++; // Пропускаем второй ED
-      
-      if (inPos + 1 >= compressedSize) {
-        snprintf(lastError, sizeof(lastError), "RLE: unexpected end");
-        return false;
+    switch (state) {
+      case RLE_DATA: {
+        // Литералы до следующего ED - одним memcpy
+        size_t n = end - in;
+        if (n > outSize - outPos) n = outSize - outPos;
+        size_t lits = 0;
+        while (lits < n && in[lits] != 0xED) lits++;
+        memcpy(out + outPos, in, lits);
+        outPos += lits;
+        in += lits;
+        if (lits < n) {
+          in++;
+          state = RLE_ED;
+        }
+        break;
       }
       
-      uint8_t count = compressed[inPos++];
-      uint8_t value = compressed[inPos++];
+      case RLE_ED:
+        if (*in == 0xED) {
+          in++;
+          state = RLE_COUNT;
+        } else {
+          out[outPos++] = 0xED;  // Одиночный ED - обычный байт
+          state = RLE_DATA;
+        }
+        break;
       
-      // ED ED 00 00 = конец блока (для версии 1)
-      if (count == 0 && value == 0) {
+      case RLE_COUNT:
+        count = *in++;
+        state = RLE_VALUE;
         break;
-      }
       
-      // Повторяем value count раз
-      for (int i = 0; i < count && outPos < outputSize; i++) {
-        output[outPos++] = value;
+      case RLE_VALUE: {
+        uint8_t value = *in++;
+        state = RLE_DATA;
+        
+        // ED ED 00 00 = конец блока (для версии 1)
+        if (count == 0 && value == 0) {
+          endMarker = true;
+          return false;
+        }
+        
+        // Повторяем value count раз
+        size_t n = count;
+        if (n > outSize - outPos) n = outSize - outPos;
+        memset(out + outPos, value, n);
+        outPos += n;
+        break;
       }
-    } else {
-      // Обычный байт
-      output[outPos++] = byte;
     }
   }
   
+  return outPos < outSize;
+}
+
+bool Z80RleStream::finish() {
+  if (state == RLE_ED) {
+    if (outPos < outSize) out[outPos++] = 0xED;
+    state = RLE_DATA;
+  }
+  return state == RLE_DATA;
+}
+
+bool Z80Loader::streamBlock(File& file, size_t inLen, uint8_t* out, size_t outSize, size_t* produced) {
+  uint8_t chunk[CHUNK_SIZE];
+  Z80RleStream rle;
+  rle.begin(out, outSize);
+  
+  size_t left = inLen;
+  bool more = true;
+  while (more && left > 0) {
+    size_t want = (left < CHUNK_SIZE) ? left : CHUNK_SIZE;
+    int got = file.read(chunk, want);
+    if (got <= 0) break;
+    left -= got;
+    more = rle.feed(chunk, got);
+  }
+  *produced = rle.produced();
+  
+  // Остановились сами (маркер / выход полон) - остаток входа не нужен
+  if (!more) return true;
+  
+  if (left > 0 && inLen != SIZE_MAX) {
+    snprintf(lastError, sizeof(lastError), "Failed to read block");
+    return false;
+  }
+  if (!rle.finish()) {
+    snprintf(lastError, sizeof(lastError), "RLE: unexpected end");
+    return false;
+  }
+  *produced = rle.produced();
   return true;
 }
 
@@ -102,45 +173,31 @@ bool Z80Loader::loadVersion1(File& file, ZXSpectrum* spectrum) {
   Serial.printf("   Compressed: %s\n", compressed ? "YES" : "NO");
   
   // ═══ ПАМЯТЬ ═══
+  // V3.162: прямо в RAM эмулятора (16384-65535 = RAM 48K), без буферов
   size_t remainingSize = file.size() - 30;
-  uint8_t* memData = (uint8_t*)malloc(remainingSize);
-  if (!memData) {
-    snprintf(lastError, sizeof(lastError), "Out of memory");
-    return false;
-  }
-  
-  if (file.read(memData, remainingSize) != remainingSize) {
-    free(memData);
-    snprintf(lastError, sizeof(lastError), "Failed to read memory");
-    return false;
-  }
+  uint32_t t0 = micros();
+  size_t produced = 0;
   
-  // Декомпрессия (если нужно)
   if (compressed) {
     Serial.println("   Decompressing memory...");
-    uint8_t* decompressed = (uint8_t*)malloc(49152);  // 48K
-    if (!decompressed) {
-      free(memData);
-      snprintf(lastError, sizeof(lastError), "Out of memory for decompression");
-      return false;
-    }
-    
-    if (!decompressBlock(memData, remainingSize, decompressed, 49152)) {
-      free(memData);
-      free(decompressed);
+    // Данные до ED ED 00 00 или до конца файла
+    if (!streamBlock(file, SIZE_MAX, spectrum->mem.ram, 49152, &produced)) {
       return false;
     }
-    
-    // Копируем в эмулятор (16384-65535 = RAM 48K)
-    memcpy(spectrum->mem.ram, decompressed, 49152);
-    free(decompressed);
   } else {
-    // Несжатый - копируем напрямую
+    // Несжатый - читаем напрямую
     size_t copySize = (remainingSize < 49152) ? remainingSize : 49152;
-    memcpy(spectrum->mem.ram, memData, copySize);
+    produced = file.read(spectrum->mem.ram, copySize);
+    if (produced != copySize) {
+      snprintf(lastError, sizeof(lastError), "Failed to read memory");
+      return false;
+    }
   }
   
-  free(memData);
+  Serial.printf("   Memory: %u bytes in %u us\n", (unsigned)produced, (unsigned)(micros() - t0));
+  if (produced < 49152) {
+    Serial.printf("⚠️  WARNING: only %u of 49152 RAM bytes in file\n", (unsigned)produced);
+  }
   
   // ═══ ЗАГРУЗКА РЕГИСТРОВ В ЭМУЛЯТОР ═══
   // Используем .B.h и .B.l как в ESP32 Rainbow!
@@ -268,6 +325,8 @@ bool Z80Loader::loadVersion2or3(File& file, ZXSpectrum* spectrum, int version) {
   //   5 = 0xC000-0xFFFF (49152-65535)
   //   8 = 0x4000-0x7FFF (16384-32767)
   
+  uint32_t t0 = micros();
+  
   while (file.available()) {
     uint16_t blockLen;
     uint8_t page;
@@ -284,45 +343,37 @@ bool Z80Loader::loadVersion2or3(File& file, ZXSpectrum* spectrum, int version) {
     else if (page == 8) destAddr = 0x4000;  // 16384
     else {
       Serial.printf("⚠️  WARNING: Unknown page %d, skipping\n", page);
-      file.seek(file.position() + blockLen);
+      file.seek(file.position() + (blockLen == 0xFFFF ? 16384 : blockLen));
       continue;
     }
     
-    // Читаем сжатые данные
-    uint8_t* compressed = (uint8_t*)malloc(blockLen);
-    if (!compressed) {
-      snprintf(lastError, sizeof(lastError), "Out of memory for block");
-      return false;
-    }
+    // V3.162: распаковка прямо в страницу (destAddr - 0x4000 = offset в RAM)
+    uint8_t* dest = &spectrum->mem.ram[destAddr - 0x4000];
+    size_t produced = 0;
     
-    if (file.read(compressed, blockLen) != blockLen) {
-      free(compressed);
-      snprintf(lastError, sizeof(lastError), "Failed to read block");
-      return false;
-    }
-    
-    // Декомпрессия
-    uint8_t* decompressed = (uint8_t*)malloc(16384);  // Каждый блок = 16K
-    if (!decompressed) {
-      free(compressed);
-      snprintf(lastError, sizeof(lastError), "Out of memory for decompression");
-      return false;
+    if (blockLen == 0xFFFF) {
+      // v3: 0xFFFF = страница не сжата, 16384 байт как есть
+      produced = file.read(dest, 16384);
+      if (produced != 16384) {
+        snprintf(lastError, sizeof(lastError), "Failed to read block");
+        return false;
+      }
+    } else {
+      size_t blockEnd = file.position() + blockLen;
+      if (!streamBlock(file, blockLen, dest, 16384, &produced)) {
+        return false;
+      }
+      // Декодер мог остановиться раньше (страница полна) - к следующему блоку
+      if (file.position() != blockEnd) file.seek(blockEnd);
     }
     
-    if (!decompressBlock(compressed, blockLen, decompressed, 16384)) {
-      free(compressed);
-      free(decompressed);
-      return false;
+    if (produced < 16384) {
+      Serial.printf("⚠️  WARNING: page %d only %u of 16384 bytes\n", page, (unsigned)produced);
     }
-    
-    // Копируем в память эмулятора
-    // destAddr - 0x4000 = offset в RAM
-    memcpy(&spectrum->mem.ram[destAddr - 0x4000], decompressed, 16384);
-    
-    free(compressed);
-    free(decompressed);
   }
   
+  Serial.printf("   Memory pages decoded in %u us\n", (unsigned)(micros() - t0));
+  
   // ═══ ЗАГРУЗКА РЕГИСТРОВ ═══
   // Используем .B.h и .B.l как в ESP32 Rainbow!
   spectrum->z80Regs->AF.B.h = A;
@@ -424,6 +475,8 @@ bool Z80Loader::loadZ80(const char* filename, ZXSpectrum* spectrum) {
   file.close();
   
   if (success) {
+    spectrum->mem.markAllDirty();  // V3.161: RAM записана в обход poke
+
     Serial.println("═══════════════════════════════════════════");
     Serial.println("✅ .Z80 FILE LOADED SUCCESSFULLY!");
     Serial.println("═══════════════════════════════════════════\n");
@@ -18,12 +18,50 @@
 //   - ED ED 00 00 = конец блока
 //   - ED ED xx yy = повторить yy байт xx раз
 // 
+// V3.162: декомпрессия потоковая - файл читается кусками по
+// Z80Loader::CHUNK_SIZE байт в буфер на стеке, распакованное пишется
+// прямо в Memory::ram. Промежуточных буферов в куче нет: загрузка не
+// падает при фрагментированной куче и не копирует 48K лишний раз.
+// 
 // Референс:
 // - https://worldofspectrum.org/faq/reference/z80format.htm
 // ═══════════════════════════════════════════════════════════
 
+// ═══ V3.162: ПОТОКОВЫЙ RLE ДЕКОДЕР ═══
+// Вход - кусками любого размера, состояние (ED / ED ED / счётчик)
+// переживает границу куска. Без SD и ZXSpectrum - крутится на хосте
+// (test/host/test_z80_loader.cpp).
+class Z80RleStream {
+public:
+  // Выход - outSize байт начиная с out (страница RAM)
+  void begin(uint8_t* out, size_t outSize);
+  
+  // Очередной кусок. false - дальше не кормить: выход заполнен
+  // или встретился ED ED 00 00 (конец данных v1, см. terminated())
+  bool feed(const uint8_t* in, size_t len);
+  
+  // Вход кончился. Висящий одиночный ED - обычный байт;
+  // false - оборван посреди ED ED xx yy
+  bool finish();
+  
+  inline size_t produced() const { return outPos; }
+  inline bool terminated() const { return endMarker; }
+  
+private:
+  enum State : uint8_t { RLE_DATA = 0, RLE_ED, RLE_COUNT, RLE_VALUE };
+  
+  uint8_t* out;
+  size_t outPos;
+  size_t outSize;
+  State state;
+  uint8_t count;
+  bool endMarker;
+};
+
 class Z80Loader {
 public:
+  static const size_t CHUNK_SIZE = 512;   // Кусок чтения с SD (на стеке)
+  
   Z80Loader();
   ~Z80Loader();
   
@@ -39,9 +77,9 @@ private:
   // Чтение little-endian значений
   uint16_t readUInt16(uint8_t* data);
   
-  // RLE декомпрессия
-  bool decompressBlock(uint8_t* compressed, size_t compressedSize, 
-                       uint8_t* output, size_t outputSize);
+  // V3.162: inLen сжатых байт из файла (SIZE_MAX - до конца файла)
+  // → out, кусками CHUNK_SIZE. Распаковано байт - в *produced
+  bool streamBlock(File& file, size_t inLen, uint8_t* out, size_t outSize, size_t* produced);
   
   // Загрузка версии 1 (48K)
   bool loadVersion1(File& file, ZXSpectrum* spectrum);
@@ -0,0 +1,12 @@
+#include "zx_pixel_kernel.h"
+
+// Little-endian: пиксель 0 (левый) = младшие 16 бит
+#define ZX_LANE(n, i) ((((n) >> (3 - (i))) & 1) ? (0xFFFFULL << ((i) * 16)) : 0ULL)
+#define ZX_NIBBLE(n)  (ZX_LANE(n, 0) | ZX_LANE(n, 1) | ZX_LANE(n, 2) | ZX_LANE(n, 3))
+
+const uint64_t zxNibbleMask64[16] = {
+  ZX_NIBBLE(0),  ZX_NIBBLE(1),  ZX_NIBBLE(2),  ZX_NIBBLE(3),
+  ZX_NIBBLE(4),  ZX_NIBBLE(5),  ZX_NIBBLE(6),  ZX_NIBBLE(7),
+  ZX_NIBBLE(8),  ZX_NIBBLE(9),  ZX_NIBBLE(10), ZX_NIBBLE(11),
+  ZX_NIBBLE(12), ZX_NIBBLE(13), ZX_NIBBLE(14), ZX_NIBBLE(15)
+};
@@ -0,0 +1,83 @@
+#ifndef ZX_PIXEL_KERNEL_H
+#define ZX_PIXEL_KERNEL_H
+
+#include <stdint.h>
+#include <string.h>
+
+// ═══════════════════════════════════════════════════════════
+// ⚡ PIXEL EXPANSION KERNEL (V3.141): bitmap + attr → RGB565
+// ═══════════════════════════════════════════════════════════
+//
+// Знакоместо = 1 байт bitmap (8 пикселей, бит 7 = левый) + атрибут.
+// Цвета берутся из attribute LUT ({paper, ink}, см. zx_screen.h).
+//
+// Три реализации, результат БИТ-В-БИТ одинаковый:
+// - zxExpandCellsRef  : эталон, по пикселю (test/host/test_pixel_kernel.cpp)
+// - zxExpandCells     : 2 × 64-bit записи на знакоместо,
+//                       маска по таблице полубайтов, без ветвлений
+//                       out = paper ^ ((paper ^ ink) & mask)
+// - ZX_PIXEL_KERNEL_VEC128 (build flag): 1 × 128-bit запись через
+//   GCC vector extensions (компилятор сам выбирает SIMD, если есть)
+//
+// dst должен быть выровнен минимум на 4 байта (8 пикселей = 16 байт).
+// Запись - через memcpy (без алиасинга uint16_t/uint64_t), компилятор
+// сводит её к широким store с учётом этого выравнивания.
+// Без Arduino зависимостей - собирается и на хосте.
+// ═══════════════════════════════════════════════════════════
+
+// Маски 4 пикселей (4 × 16 бит) для полубайта: бит 3 → пиксель 0
+extern const uint64_t zxNibbleMask64[16];
+
+// Эталонная версия (по одному пикселю)
+static inline void zxExpandCellsRef(uint16_t* dst, const uint8_t* bitmap, const uint8_t* attrs,
+                                    int count, const uint16_t (*lut)[2]) {
+  for (int c = 0; c < count; c++) {
+    uint8_t bits = bitmap[c];
+    const uint16_t* pair = lut[attrs[c]];
+    for (int i = 0; i < 8; i++) {
+      *dst++ = pair[(bits >> (7 - i)) & 1];
+    }
+  }
+}
+
+#ifdef ZX_PIXEL_KERNEL_VEC128
+
+typedef uint16_t zx_v8u16 __attribute__((vector_size(16)));
+
+static inline void zxExpandCells(uint16_t* dst, const uint8_t* bitmap, const uint8_t* attrs,
+                                 int count, const uint16_t (*lut)[2]) {
+  const zx_v8u16 bitSel = {0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01};
+  for (int c = 0; c < count; c++) {
+    const uint16_t* pair = lut[attrs[c]];
+    zx_v8u16 paper = (zx_v8u16){} + pair[0];
+    zx_v8u16 diff = paper ^ ((zx_v8u16){} + pair[1]);
+    zx_v8u16 bits = (zx_v8u16){} + (uint16_t)bitmap[c];
+    zx_v8u16 mask = (zx_v8u16)((bits & bitSel) != 0);
+    zx_v8u16 out = paper ^ (diff & mask);
+    memcpy(dst, &out, sizeof(out));  // 128-bit запись
+    dst += 8;
+  }
+}
+
+#else
+
+static inline void zxExpandCells(uint16_t* dst, const uint8_t* bitmap, const uint8_t* attrs,
+                                 int count, const uint16_t (*lut)[2]) {
+  dst = (uint16_t*)__builtin_assume_aligned(dst, 4);
+  for (int c = 0; c < count; c++) {
+    const uint16_t* pair = lut[attrs[c]];
+    // Цвет размноженный на 4 lane'а
+    uint64_t paper = pair[0] * 0x0001000100010001ULL;
+    uint64_t diff = paper ^ (pair[1] * 0x0001000100010001ULL);
+    uint8_t bits = bitmap[c];
+    uint64_t out[2];
+    out[0] = paper ^ (diff & zxNibbleMask64[bits >> 4]);
+    out[1] = paper ^ (diff & zxNibbleMask64[bits & 0x0F]);
+    memcpy(dst, out, sizeof(out));  // 2 × 64-bit запись (без type punning)
+    dst += 8;
+  }
+}
+
+#endif // ZX_PIXEL_KERNEL_VEC128
+
+#endif // ZX_PIXEL_KERNEL_H
@@ -0,0 +1,102 @@
+#include "zx_screen.h"
+
+// Палитра (swap565) из spectrum_mini.cpp
+extern const uint16_t specpal565[16];
+
+ZXScreen zxScreen;
+
+ZXScreen::ZXScreen() : flashPhase(false), fullRedraw(true) {
+  memset(rowDirty, 0, sizeof(rowDirty));
+  memset(shadow, 0, sizeof(shadow));
+  buildAttrLUT();
+}
+
+void ZXScreen::buildAttrLUT() {
+  for (int attr = 0; attr < 256; attr++) {
+    int ink = attr & 0x07;
+    int paper = (attr >> 3) & 0x07;
+    if (attr & 0x40) {  // BRIGHT
+      ink += 8;
+      paper += 8;
+    }
+    attrLUT[attr][0] = specpal565[paper];
+    attrLUT[attr][1] = specpal565[ink];
+  }
+  flashPhase = false;
+}
+
+void ZXScreen::applyFlashPhase(bool phase, const uint8_t* attrs) {
+  if (phase == flashPhase) return;
+  flashPhase = phase;
+
+  // Переставляем ink/paper ТОЛЬКО у атрибутов с FLASH (0x80-0xFF)
+  for (int attr = 0x80; attr < 256; attr++) {
+    uint16_t tmp = attrLUT[attr][0];
+    attrLUT[attr][0] = attrLUT[attr][1];
+    attrLUT[attr][1] = tmp;
+  }
+
+  // Помечаем грязными только знакоместа с битом FLASH
+  for (int row = 0; row < CHAR_ROWS; row++) {
+    const uint8_t* a = attrs + row * CHAR_COLS;
+    uint32_t mask = 0;
+    for (int col = 0; col < CHAR_COLS; col++) {
+      if (a[col] & 0x80) mask |= (1u << col);
+    }
+    rowDirty[row] |= mask;
+  }
+}
+
+void ZXScreen::scan(const uint8_t* vram, bool phase) {
+  if (fullRedraw) {
+    // Всё равно перерисуем всё - просто синхронизируем тень
+    memcpy(shadow, vram, sizeof(shadow));
+    if (phase != flashPhase) {
+      applyFlashPhase(phase, vram + BITMAP_SIZE);
+    }
+    return;
+  }
+
+  // ═══ BITMAP: 192 линии × 32 байта (сравниваем по 4 байта) ═══
+  for (int zy = 0; zy < 192; zy++) {
+    int offset = ((zy & 0xC0) << 5) + ((zy & 0x07) << 8) + ((zy & 0x38) << 2);
+    const uint32_t* cur = (const uint32_t*)(vram + offset);
+    uint32_t* old = (uint32_t*)(shadow + offset);
+    uint32_t mask = 0;
+    for (int w = 0; w < CHAR_COLS / 4; w++) {
+      if (cur[w] != old[w]) {
+        uint32_t diff = cur[w] ^ old[w];
+        // Little-endian: байт 0 = колонка w*4
+        if (diff & 0x000000FF) mask |= 1u << (w * 4);
+        if (diff & 0x0000FF00) mask |= 1u << (w * 4 + 1);
+        if (diff & 0x00FF0000) mask |= 1u << (w * 4 + 2);
+        if (diff & 0xFF000000) mask |= 1u << (w * 4 + 3);
+        old[w] = cur[w];
+      }
+    }
+    rowDirty[zy >> 3] |= mask;
+  }
+
+  // ═══ АТРИБУТЫ: 24 × 32 ═══
+  const uint8_t* attrs = vram + BITMAP_SIZE;
+  uint8_t* oldAttrs = shadow + BITMAP_SIZE;
+  for (int row = 0; row < CHAR_ROWS; row++) {
+    const uint8_t* a = attrs + row * CHAR_COLS;
+    uint8_t* o = oldAttrs + row * CHAR_COLS;
+    if (memcmp(a, o, CHAR_COLS) == 0) continue;
+    uint32_t mask = 0;
+    for (int col = 0; col < CHAR_COLS; col++) {
+      if (a[col] != o[col]) mask |= (1u << col);
+    }
+    memcpy(o, a, CHAR_COLS);
+    rowDirty[row] |= mask;
+  }
+
+  // ═══ FLASH: фаза сменилась → только клетки с битом 7 ═══
+  applyFlashPhase(phase, attrs);
+}
+
+void ZXScreen::clearDirty() {
+  memset(rowDirty, 0, sizeof(rowDirty));
+  fullRedraw = false;
+}
@@ -0,0 +1,77 @@
+#ifndef ZX_SCREEN_H
+#define ZX_SCREEN_H
+
+#include <Arduino.h>
+
+// ═══════════════════════════════════════════════════════════
+// 🖼️ ZX SCREEN CACHE (V3.139): атрибуты + FLASH + dirty-знакоместа
+// ═══════════════════════════════════════════════════════════
+//
+// 1) Attribute LUT: attr (0-255) → {paper, ink} в swap565.
+//    Индекс [attr][pixelBit] → цвет без ветвлений по BRIGHT/FLASH.
+//    FLASH реализован ПЕРЕСТАНОВКОЙ ink/paper в LUT при смене фазы
+//    (только для 128 атрибутов с битом 7) - в горячем цикле ничего
+//    не проверяется.
+//
+// 2) Dirty-знакоместа: 24 строки × 32 бита. scan() сравнивает VRAM
+//    с теневой копией и помечает изменившиеся клетки; при смене фазы
+//    FLASH помечаются только клетки с битом FLASH.
+//
+// Renderer перерисовывает только строки с грязными клетками.
+// ═══════════════════════════════════════════════════════════
+
+class ZXScreen {
+public:
+  static const int CHAR_ROWS = 24;
+  static const int CHAR_COLS = 32;
+  static const int BITMAP_SIZE = 6144;
+  static const int ATTR_SIZE = 768;
+
+  ZXScreen();
+
+  // Сравнить VRAM с теневой копией + применить фазу FLASH.
+  // Вызывать один раз перед рендером кадра.
+  void scan(const uint8_t* vram, bool flashPhase);
+
+  // Полная перерисовка (смена режима/зума/пана, возврат из меню)
+  void invalidate() { fullRedraw = true; }
+
+  // Есть ли в строке знакомест (0-23) изменения с прошлого кадра?
+  inline bool isRowDirty(int charRow) const {
+    return fullRedraw || rowDirty[charRow] != 0;
+  }
+  inline bool isFullRedraw() const { return fullRedraw; }
+
+  // V3.155: Изменилось ли на экране хоть что-то (проба задержки ввода)
+  inline bool anyRowDirty() const {
+    if (fullRedraw) return true;
+    for (int r = 0; r < CHAR_ROWS; r++) {
+      if (rowDirty[r]) return true;
+    }
+    return false;
+  }
+
+  // Сбросить dirty-флаги после отрисовки кадра
+  void clearDirty();
+
+  // {paper, ink} для атрибута (с учётом BRIGHT и текущей фазы FLASH)
+  inline const uint16_t* colors(uint8_t attr) const { return attrLUT[attr]; }
+
+  // Вся таблица (для zxExpandCells)
+  inline const uint16_t (*attrTable() const)[2] { return attrLUT; }
+
+private:
+  void buildAttrLUT();
+  void applyFlashPhase(bool phase, const uint8_t* attrs);
+
+  uint16_t attrLUT[256][2];          // [attr][0]=paper, [attr][1]=ink
+  uint32_t rowDirty[CHAR_ROWS];      // Бит N = знакоместо в колонке N
+  uint8_t shadow[BITMAP_SIZE + ATTR_SIZE];  // Копия VRAM с прошлого scan()
+  bool flashPhase;                   // Текущая фаза в LUT (true = ink/paper переставлены)
+  bool fullRedraw;
+};
+
+// Глобальный кэш экрана (используется renderScreen)
+extern ZXScreen zxScreen;
+
+#endif // ZX_SCREEN_H
@@ -0,0 +1,121 @@
+#include "frame_telemetry.h"
+
+FrameTelemetry frameTelemetry;
+
+static const char* const STAGE_NAMES[STAGE_COUNT] = {
+  "input", "emu", "audio", "compose", "push", "sd", "sleep"
+};
+
+static inline uint16_t sat16(uint32_t v) {
+  return v > 0xFFFF ? 0xFFFF : (uint16_t)v;
+}
+
+FrameTelemetry::FrameTelemetry()
+  : hudEnabled(false), writeCount(0), streamedCount(0),
+    frameStartUs(0), lastMarkUs(0), audioStarvedSinceUs(0), audioLateUs(0),
+    audioFill(0), audioAgeUs(0),
+    streaming(false) {
+  memset(ring, 0, sizeof(ring));
+  memset(stageUs, 0, sizeof(stageUs));
+}
+
+void FrameTelemetry::beginFrame() {
+  frameStartUs = esp_timer_get_time();
+  lastMarkUs = frameStartUs;
+  memset(stageUs, 0, sizeof(stageUs));
+  audioLateUs = 0;
+}
+
+void FrameTelemetry::endFrame() {
+  FrameSample& s = ring[writeCount & (RING_SIZE - 1)];
+  s.frame = writeCount;
+  for (int i = 0; i < STAGE_COUNT; i++) {
+    s.us[i] = sat16(stageUs[i]);
+  }
+  s.audioLateUs = sat16(audioLateUs);
+  s.audioAgeUs = audioAgeUs;
+  s.audioFill = audioFill;
+  s.totalUs = sat16((uint32_t)(esp_timer_get_time() - frameStartUs));
+  writeCount++;
+}
+
+void FrameTelemetry::noteAudioPull(bool hadFrame) {
+  // Вызывается из Audio Task (core 1) - только запись одного atomic uint32
+  if (hadFrame) {
+    audioStarvedSinceUs.store(0, std::memory_order_relaxed);
+  } else if (audioStarvedSinceUs.load(std::memory_order_relaxed) == 0) {
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    audioStarvedSinceUs.store(now ? now : 1, std::memory_order_relaxed);  // 0 занят под "не голодает"
+  }
+}
+
+void FrameTelemetry::noteAudioSubmit() {
+  uint32_t since = audioStarvedSinceUs.load(std::memory_order_relaxed);
+  if (since != 0) {
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    audioLateUs += now - since;  // По модулю 2^32
+    // Голод продолжается - следующему кадру только время после этого.
+    // CAS: если Audio Task уже взял кадр (0), не затираем
+    audioStarvedSinceUs.compare_exchange_strong(since, now ? now : 1, std::memory_order_relaxed);
+  }
+}
+
+void FrameTelemetry::formatHud(char* out, size_t size) const {
+  uint32_t n = writeCount < RING_SIZE ? writeCount : RING_SIZE;
+  if (n == 0) {
+    snprintf(out, size, "no frames");
+    return;
+  }
+
+  uint32_t sum[STAGE_COUNT] = {0};
+  uint32_t late = 0, total = 0;
+  for (uint32_t i = 0; i < n; i++) {
+    const FrameSample& s = ring[(writeCount - 1 - i) & (RING_SIZE - 1)];
+    for (int k = 0; k < STAGE_COUNT; k++) sum[k] += s.us[k];
+    late += s.audioLateUs;
+    total += s.totalUs;
+  }
+
+  // Средние в мс (одна цифра после точки)
+  #define AVG_MS(v) ((float)(v) / n / 1000.0f)
+  snprintf(out, size, "E%.1f C%.1f P%.1f I%.1f S%.1f L%.1f T%.1f",
+           AVG_MS(sum[STAGE_EMU]), AVG_MS(sum[STAGE_COMPOSE]), AVG_MS(sum[STAGE_PUSH]),
+           AVG_MS(sum[STAGE_INPUT]), AVG_MS(sum[STAGE_SD]), AVG_MS(late), AVG_MS(total));
+  #undef AVG_MS
+}
+
+void FrameTelemetry::setStreaming(bool on) {
+  streaming = on;
+  if (on) {
+    // Начинаем с текущего кадра + заголовок CSV
+    streamedCount = writeCount;
+    Serial.print("#frame");
+    for (int i = 0; i < STAGE_COUNT; i++) {
+      Serial.print(',');
+      Serial.print(STAGE_NAMES[i]);
+    }
+    Serial.println(",audio_late,audio_fill,audio_age,total");
+  }
+}
+
+void FrameTelemetry::flushStream() {
+  if (!streaming) return;
+
+  // Отстали больше чем на кольцо - пропускаем потерянные кадры
+  if (writeCount - streamedCount > RING_SIZE) {
+    streamedCount = writeCount - RING_SIZE;
+  }
+
+  char line[96];
+  while (streamedCount != writeCount) {
+    const FrameSample& s = ring[streamedCount & (RING_SIZE - 1)];
+    int len = snprintf(line, sizeof(line), "%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u\n",
+                       s.frame, s.us[STAGE_INPUT], s.us[STAGE_EMU], s.us[STAGE_AUDIO],
+                       s.us[STAGE_COMPOSE], s.us[STAGE_PUSH], s.us[STAGE_SD], s.us[STAGE_SLEEP],
+                       s.audioLateUs, s.audioFill, s.audioAgeUs, s.totalUs);
+    // USB CDC: не ждём - если буфер полон, допишем в следующем кадре
+    if (Serial.availableForWrite() < len) break;
+    Serial.write((const uint8_t*)line, len);
+    streamedCount++;
+  }
+}
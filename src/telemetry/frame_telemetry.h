@@ -0,0 +1,114 @@
+#ifndef FRAME_TELEMETRY_H
+#define FRAME_TELEMETRY_H
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <atomic>
+
+// ═══════════════════════════════════════════════════════════
+// ⏱️ FRAME TELEMETRY (V3.142): куда уходит время кадра
+// ═══════════════════════════════════════════════════════════
+//
+// Каждый кадр loop() разбивается на стадии (esp_timer, мкс):
+//   INPUT   - клавиатура + джойстик
+//   EMU     - runForFrame (69888 t-states)
+//   AUDIO   - передача кадра звука в Audio Task
+//   COMPOSE - сборка frameBuffer (renderScreen до pushImage)
+//   PUSH    - передача на дисплей по SPI
+//   SD      - фоновые SD задачи (busScheduler)
+//   SLEEP   - throttle до 20 мс
+// + опоздание звука: сколько Audio Task ждал кадр (0 = вовремя).
+// + V3.149: заполнение аудио кольца и возраст кадра (audio/audio_stats.h)
+//
+// Кадры пишутся в кольцевой буфер (64 кадра). Оттуда:
+// - HUD: средние значения в одной строке (overlay слой)
+// - CSV поток по USB CDC (без блокировки - только сколько влезет)
+// ═══════════════════════════════════════════════════════════
+
+enum FrameStage {
+  STAGE_INPUT = 0,
+  STAGE_EMU,
+  STAGE_AUDIO,
+  STAGE_COMPOSE,
+  STAGE_PUSH,
+  STAGE_SD,
+  STAGE_SLEEP,
+  STAGE_COUNT
+};
+
+struct FrameSample {
+  uint32_t frame;                 // Номер кадра
+  uint16_t us[STAGE_COUNT];       // Время стадий (мкс, насыщение 65535)
+  uint16_t audioLateUs;           // Опоздание кадра звука (мкс)
+  uint16_t audioAgeUs;            // V3.149: возраст последнего сыгранного кадра (мкс)
+  uint8_t audioFill;              // V3.149: кадров в аудио кольце на конец кадра
+  uint16_t totalUs;               // Весь кадр
+};
+
+class FrameTelemetry {
+public:
+  static const int RING_SIZE = 64;   // Степень двойки
+
+  FrameTelemetry();
+
+  // Начало кадра (в начале loop)
+  void beginFrame();
+
+  // Закрыть стадию: время с прошлой отметки добавляется к stage
+  inline void mark(FrameStage stage) {
+    int64_t now = esp_timer_get_time();
+    stageUs[stage] += (uint32_t)(now - lastMarkUs);
+    lastMarkUs = now;
+  }
+
+  // Конец кадра → запись в кольцо
+  void endFrame();
+
+  // ═══ ОПОЗДАНИЕ ЗВУКА ═══
+  // Audio Task: взял кадр (hadFrame) или не дождался (тишина)
+  void noteAudioPull(bool hadFrame);
+  // Эмулятор: отдал кадр звука
+  void noteAudioSubmit();
+  // V3.149: состояние аудио кольца на конец кадра (пишется в CSV)
+  inline void noteAudioState(uint8_t fill, uint32_t ageUs) {
+    audioFill = fill;
+    audioAgeUs = ageUs > 0xFFFF ? 0xFFFF : (uint16_t)ageUs;
+  }
+
+  // ═══ HUD ═══
+  bool hudEnabled;
+  // Строка со средними значениями за кольцо (мс), например:
+  // "E9.8 C3.1 P6.0 I0.2 S0.0 L0.0"
+  void formatHud(char* out, size_t size) const;
+
+  // ═══ CSV ПОТОК ═══
+  void setStreaming(bool on);
+  inline bool isStreaming() const { return streaming; }
+  // Выгрузить накопленные кадры в Serial (без блокировки)
+  void flushStream();
+
+private:
+  FrameSample ring[RING_SIZE];
+  uint32_t writeCount;       // Всего записано кадров
+  uint32_t streamedCount;    // Сколько уже ушло в поток
+
+  int64_t frameStartUs;
+  int64_t lastMarkUs;
+  uint32_t stageUs[STAGE_COUNT];
+
+  // Пишет Audio Task (другое ядро): 32 бита, как остальные межъядерные
+  // поля - int64 на Xtensa читается не атомарно. Мкс по модулю 2^32
+  // (разность переживает переполнение), 0 = Audio Task не голодает.
+  // noteAudioSubmit сдвигает на момент учёта - кадр не платит за прошлые
+  std::atomic<uint32_t> audioStarvedSinceUs;
+  uint32_t audioLateUs;
+  uint8_t audioFill;
+  uint16_t audioAgeUs;
+
+  bool streaming;
+};
+
+// Глобальная телеметрия
+extern FrameTelemetry frameTelemetry;
+
+#endif // FRAME_TELEMETRY_H
@@ -0,0 +1,113 @@
+#ifndef INPUT_LATENCY_H
+#define INPUT_LATENCY_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// ═══════════════════════════════════════════════════════════
+// 🎯 INPUT LATENCY PROBE (V3.155): нажатие → первый изменённый пиксель
+// ═══════════════════════════════════════════════════════════
+//
+// Замер "от пальца до экрана" целиком:
+// - noteInput(): захват ввода увидел НОВОЕ нажатие (клавиша или
+//   направление джойстика) → старт замера (если замер не идёт)
+// - notePush(): renderScreen отправил кадр на дисплей; если VRAM
+//   изменилась с прошлого рендера - замер закончен
+// - нажатие, после которого экран не менялся TIMEOUT_US, считается
+//   "без отклика" (меню игры, пауза) и в статистику не попадает
+//
+// Признак отклика - любое изменение VRAM, поэтому меряем только
+// нажатия на СТОЯЩЕМ экране (последний рендер до нажатия без
+// изменений): тогда первое изменение - почти наверняка ответ на
+// нажатие. Нажатие на анимированном экране не меряется (skipped):
+// иначе замер обрывала бы чужая анимация и выходило бы "время до
+// следующего рендера". Итог - оценка для меню, редакторов, пошаговых
+// игр; в экшен-играх с постоянной анимацией замеров мало или нет.
+// Только loop() (один поток) - atomic не нужен.
+// Без Arduino зависимостей - время передаётся снаружи (мкс).
+// ═══════════════════════════════════════════════════════════
+
+struct InputLatencyWindow {
+  uint32_t samples;          // Завершённых замеров в окне
+  uint32_t timeouts;         // Нажатий без изменения экрана
+  uint32_t skipped;          // Нажатий на анимированном экране (не мерились)
+  uint32_t minUs, avgUs, maxUs;
+  uint32_t avgFrames;        // Среднее число эмулированных кадров до пикселя
+};
+
+class InputLatencyProbe {
+public:
+  static const uint32_t TIMEOUT_US = 500000;   // 25 кадров
+
+  InputLatencyProbe() { pending = false; screenChanging = true; clearWindow(); }
+
+  // Новое нажатие (frame - номер эмулированного кадра)
+  inline void noteInput(uint32_t nowUs, uint32_t frame) {
+    if (pending) return;        // Меряем от ПЕРВОГО нажатия
+    if (screenChanging) {       // Экран и так менялся - отклик не отличить
+      wSkipped++;
+      return;
+    }
+    pending = true;
+    startUs = nowUs;
+    startFrame = frame;
+  }
+
+  // Кадр ушёл на дисплей; pixelsChanged - VRAM изменилась с прошлого рендера
+  inline void notePush(uint32_t nowUs, uint32_t frame, bool pixelsChanged) {
+    screenChanging = pixelsChanged;  // Для следующего нажатия
+    if (!pending) return;
+    uint32_t dt = nowUs - startUs;
+    if (!pixelsChanged) {
+      if (dt > TIMEOUT_US) {
+        pending = false;
+        wTimeouts++;
+      }
+      return;
+    }
+    pending = false;
+    wSamples++;
+    wSumUs += dt;
+    wSumFrames += frame - startFrame;
+    if (dt < wMinUs) wMinUs = dt;
+    if (dt > wMaxUs) wMaxUs = dt;
+  }
+
+  // Снять окно и начать новое (идущий замер продолжается)
+  void takeWindow(InputLatencyWindow& w) {
+    w.samples = wSamples;
+    w.timeouts = wTimeouts;
+    w.skipped = wSkipped;
+    w.minUs = wSamples ? wMinUs : 0;
+    w.maxUs = wMaxUs;
+    w.avgUs = wSamples ? (uint32_t)(wSumUs / wSamples) : 0;
+    w.avgFrames = wSamples ? wSumFrames / wSamples : 0;
+    clearWindow();
+  }
+
+  // Одна строка: "IN 38/52/71ms n4 t0 s2"
+  static void format(const InputLatencyWindow& w, char* out, size_t size) {
+    snprintf(out, size, "IN %u/%u/%ums n%u t%u s%u",
+             (unsigned)(w.minUs / 1000), (unsigned)(w.avgUs / 1000), (unsigned)(w.maxUs / 1000),
+             (unsigned)w.samples, (unsigned)w.timeouts, (unsigned)w.skipped);
+  }
+
+private:
+  void clearWindow() {
+    wSamples = 0; wTimeouts = 0; wSkipped = 0;
+    wSumUs = 0; wSumFrames = 0;
+    wMinUs = 0xFFFFFFFF; wMaxUs = 0;
+  }
+
+  bool pending;
+  bool screenChanging;       // Последний рендер изменил VRAM
+  uint32_t startUs;
+  uint32_t startFrame;
+
+  uint32_t wSamples, wTimeouts, wSkipped;
+  uint64_t wSumUs;
+  uint32_t wSumFrames;
+  uint32_t wMinUs, wMaxUs;
+};
+
+#endif // INPUT_LATENCY_H
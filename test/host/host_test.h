@@ -0,0 +1,39 @@
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <chrono>
+
+// ═══════════════════════════════════════════════════════════
+// 🧪 HOST TESTS: проверки и замер времени без железа
+// ═══════════════════════════════════════════════════════════
+//
+// Каждый test_*.cpp - отдельная программа: main() возвращает число
+// проваленных проверок (0 = OK). Сборка и запуск - run.sh.
+// ═══════════════════════════════════════════════════════════
+
+static int hostFailures = 0;
+
+#define CHECK(cond, ...) do {                                   \
+    if (!(cond)) {                                              \
+      hostFailures++;                                           \
+      if (hostFailures <= 20) {                                 \
+        printf("FAIL %s:%d: %s: ", __FILE__, __LINE__, #cond);  \
+        printf(__VA_ARGS__);                                    \
+        printf("\n");                                           \
+      }                                                         \
+    }                                                           \
+  } while (0)
+
+// Секунды с момента t0 (для бенчмарков)
+static inline double hostSecondsSince(std::chrono::steady_clock::time_point t0) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static inline int hostReport(const char* name) {
+  printf("%s: %s (%d failures)\n", name, hostFailures ? "FAILED" : "OK", hostFailures);
+  return hostFailures;
+}
+
+#endif // HOST_TEST_H
@@ -0,0 +1,39 @@
+#!/bin/sh
+# Host tests: ядро эмулятора без железа (g++), см. README "Host tests".
+# Выход != 0 - есть провалы. OUT - куда класть бинарники, CXX - компилятор.
+cd "$(dirname "$0")" || exit 1
+
+SRC=../../src
+OUT=${OUT:-/tmp/zx-host-tests}
+CXX=${CXX:-g++}
+FLAGS="-std=gnu++17 -O2 -Wall -Istubs -I. -I$SRC -I$SRC/spectrum -I$SRC/z80 -I$SRC/audio -I$SRC/input -I$SRC/telemetry"
+
+mkdir -p "$OUT"
+fail=0
+
+run() {
+  name=$1
+  shift
+  if $CXX $FLAGS "$@" -o "$OUT/$name"; then
+    "$OUT/$name" || fail=1
+  else
+    echo "$name: BUILD FAILED"
+    fail=1
+  fi
+}
+
+run test_pixel_kernel test_pixel_kernel.cpp $SRC/spectrum/zx_pixel_kernel.cpp
+run test_pixel_kernel_vec128 -DZX_PIXEL_KERNEL_VEC128 test_pixel_kernel.cpp $SRC/spectrum/zx_pixel_kernel.cpp
+run test_beeper_synth test_beeper_synth.cpp $SRC/audio/beeper_synth.cpp
+run test_audio_stats -pthread test_audio_stats.cpp
+run test_ay_chip test_ay_chip.cpp $SRC/audio/ay_chip.cpp
+# Ядро целиком (ROM 48K + Z80); -Wno-unused-variable - отладочные переменные runForCycles
+CORE="$SRC/spectrum/spectrum_mini.cpp $SRC/spectrum/machine_snapshot.cpp $SRC/z80/z80.cpp $SRC/audio/ay_chip.cpp"
+run test_input_replay -Wno-unused-variable test_input_replay.cpp $SRC/spectrum/input_replay.cpp $CORE
+run test_rewind_buffer -Wno-unused-variable test_rewind_buffer.cpp $SRC/spectrum/rewind_buffer.cpp $CORE
+run test_input_script -Wno-unused-variable test_input_script.cpp $SRC/spectrum/input_script.cpp $CORE
+run test_keymap -Wno-unused-variable test_keymap.cpp $SRC/input/keymap.cpp $CORE
+# -Wno-format: printf("%d", file.size()) в загрузчике (size_t на хосте 64-битный)
+run test_z80_loader -Wno-unused-variable -Wno-format test_z80_loader.cpp $SRC/spectrum/z80_loader.cpp $CORE
+
+exit $fail
@@ -0,0 +1,47 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// Host tests: минимум Arduino для ядра эмулятора (см. ../run.sh).
+// Serial пишет в stdout (quiet - молчать), micros/millis - часы хоста.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <chrono>
+
+class HardwareSerial {
+public:
+  bool quiet = false;
+
+  size_t print(const char* s) {
+    if (quiet) return strlen(s);
+    return fputs(s, stdout) >= 0 ? strlen(s) : 0;
+  }
+  size_t println(const char* s = "") { return print(s) + print("\n"); }
+  size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3))) {
+    if (quiet) return 0;
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vprintf(fmt, ap);
+    va_end(ap);
+    return n > 0 ? n : 0;
+  }
+};
+
+extern HardwareSerial Serial;
+
+inline unsigned long micros() {
+  static const auto t0 = std::chrono::steady_clock::now();
+  return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now() - t0).count();
+}
+
+inline unsigned long millis() { return micros() / 1000; }
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+
+#endif // HOST_ARDUINO_H
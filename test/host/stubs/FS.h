@@ -0,0 +1,51 @@
+#ifndef HOST_FS_H
+#define HOST_FS_H
+
+// Host tests: File поверх байтов в памяти (файлы заводит SD.h, SDFS::files)
+
+#include <Arduino.h>
+#include <memory>
+#include <vector>
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+
+class File {
+public:
+  File() {}
+  explicit File(std::shared_ptr<std::vector<uint8_t>> bytes) : data(bytes) {}
+
+  operator bool() const { return (bool)data; }
+  size_t size() const { return data ? data->size() : 0; }
+  size_t position() const { return pos; }
+  int available() const { return pos < size() ? (int)(size() - pos) : 0; }
+  bool seek(uint32_t p) {
+    pos = p;
+    return p <= size();
+  }
+
+  int read(uint8_t* buf, size_t len) {
+    size_t n = (size_t)available() < len ? (size_t)available() : len;
+    if (n) memcpy(buf, data->data() + pos, n);
+    pos += n;
+    return (int)n;
+  }
+  int read() {
+    uint8_t b;
+    return read(&b, 1) == 1 ? b : -1;
+  }
+  size_t write(const uint8_t* buf, size_t len) {
+    if (!data) return 0;
+    if (data->size() < pos + len) data->resize(pos + len);
+    memcpy(data->data() + pos, buf, len);
+    pos += len;
+    return len;
+  }
+  void close() { data.reset(); }
+
+private:
+  std::shared_ptr<std::vector<uint8_t>> data;
+  size_t pos = 0;
+};
+
+#endif // HOST_FS_H
@@ -0,0 +1,31 @@
+#ifndef HOST_M5CARDPUTER_H
+#define HOST_M5CARDPUTER_H
+
+// Host tests: только состояние клавиатуры (поля как в M5Cardputer
+// Keyboard_Class::KeysState) - тест заполняет его сам
+
+#include <Arduino.h>
+#include <vector>
+
+class Keyboard_Class {
+public:
+  struct KeysState {
+    bool tab = false;
+    bool fn = false;
+    bool shift = false;
+    bool ctrl = false;
+    bool opt = false;
+    bool alt = false;
+    bool del = false;
+    bool enter = false;
+    bool space = false;
+    uint8_t modifiers = 0;
+    std::vector<char> word;
+    std::vector<uint8_t> hid_keys;
+    std::vector<uint8_t> modifier_keys;
+
+    void reset() { *this = KeysState(); }
+  };
+};
+
+#endif // HOST_M5CARDPUTER_H
@@ -0,0 +1,30 @@
+#ifndef HOST_SD_H
+#define HOST_SD_H
+
+// Host tests: "карта" - словарь путь → байты. Тест кладёт файл в SD.files
+
+#include "FS.h"
+#include <map>
+#include <string>
+
+class SDFS {
+public:
+  std::map<std::string, std::shared_ptr<std::vector<uint8_t>>> files;
+
+  File open(const char* path, const char* mode = FILE_READ) {
+    auto it = files.find(path);
+    if (strcmp(mode, FILE_WRITE) == 0) {
+      auto bytes = std::make_shared<std::vector<uint8_t>>();
+      files[path] = bytes;
+      return File(bytes);
+    }
+    return it == files.end() ? File() : File(it->second);
+  }
+  bool exists(const char* path) { return files.count(path) != 0; }
+  bool mkdir(const char*) { return true; }
+  bool remove(const char* path) { return files.erase(path) != 0; }
+};
+
+extern SDFS SD;
+
+#endif // HOST_SD_H
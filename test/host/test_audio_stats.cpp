@@ -0,0 +1,104 @@
+// Статистика звука (V3.149) на синтетических кадрах: эмулятор → SPSCRing →
+// "Audio Task" с AudioStats, как в main.cpp (beginWrite/commitWrite,
+// beginRead/notePlayed/endRead, тишина при пустом кольце).
+#include "host_test.h"
+#include "audio_ring.h"
+#include "audio_stats.h"
+#include <thread>
+
+struct TestFrame {
+  uint32_t submitUs;
+};
+
+static SPSCRing<TestFrame, 4> ring;
+static AudioStats stats;
+
+// Писатель: кадр в кольцо или перезапись (как ZX_BeeperSubmitEdges)
+static void submit(uint32_t nowUs) {
+  TestFrame* f = ring.beginWrite();
+  if (!f) {
+    stats.noteOverwrite();
+    return;
+  }
+  f->submitUs = nowUs;
+  ring.commitWrite();
+}
+
+// Читатель: один буфер Audio Task
+static void pull(uint32_t nowUs) {
+  const TestFrame* f = ring.beginRead();
+  if (f) {
+    stats.notePlayed(nowUs - f->submitUs, ring.fill());
+    ring.endRead();
+  } else {
+    stats.noteSilence();
+  }
+}
+
+int main() {
+  AudioStatsWindow w;
+
+  // ═══ 1) Ровный поток: кадр отдан за 5 мс до воспроизведения ═══
+  stats.reset();
+  stats.takeWindow(w);
+  for (int i = 0; i < 50; i++) {
+    uint32_t t = i * 20000;
+    submit(t);
+    pull(t + 5000);
+  }
+  stats.takeWindow(w);
+  CHECK(w.played == 50 && w.silence == 0 && w.overwrites == 0, "steady: %u/%u/%u", w.played, w.silence, w.overwrites);
+  CHECK(w.ageMinUs == 5000 && w.ageAvgUs == 5000 && w.ageMaxUs == 5000, "age %u/%u/%u", w.ageMinUs, w.ageAvgUs, w.ageMaxUs);
+  CHECK(w.fillMin == 1 && w.fillMax == 1 && w.fillHist[1] == 50, "fill %u..%u", w.fillMin, w.fillMax);
+
+  // ═══ 2) Эмулятор опоздал на 3 буфера: тишина, не idle ═══
+  pull(0); pull(0); pull(0);
+  submit(1000000);
+  pull(1010000);
+  stats.takeWindow(w);
+  CHECK(w.silence == 3 && w.played == 1, "late: silence %u played %u", w.silence, w.played);
+  CHECK(w.fillHist[0] == 3, "silence counts as fill 0 (%u)", w.fillHist[0]);
+  CHECK(w.ageMaxUs == 10000, "late frame age %u", w.ageMaxUs);
+
+  // ═══ 3) Пауза: после IDLE_AFTER буферов тишины - idle, а не underrun ═══
+  uint32_t silenceBefore = stats.silenceInserted(), idleBefore = stats.idleFrames();
+  for (int i = 0; i < AudioStats::IDLE_AFTER + 100; i++) pull(0);
+  CHECK(stats.silenceInserted() - silenceBefore == (uint32_t)AudioStats::IDLE_AFTER, "silence %u",
+        stats.silenceInserted() - silenceBefore);
+  CHECK(stats.idleFrames() - idleBefore == 100, "idle %u", stats.idleFrames() - idleBefore);
+  stats.takeWindow(w);
+
+  // ═══ 4) Читатель отстал: кольцо (4) полно → перезаписи, возраст растёт ═══
+  for (int i = 0; i < 10; i++) submit(2000000 + i * 20000);
+  for (int i = 0; i < 4; i++) pull(2200000 + i * 20000);
+  stats.takeWindow(w);
+  CHECK(w.overwrites == 6 && w.played == 4, "overrun: overwrites %u played %u", w.overwrites, w.played);
+  CHECK(w.fillMax == 4 && w.fillMin == 1, "fill incl. current %u..%u", w.fillMin, w.fillMax);
+  CHECK(w.ageMinUs == 200000 && w.ageMaxUs == 200000, "queued age %u..%u", w.ageMinUs, w.ageMaxUs);
+
+  // ═══ 5) Два потока: перезаписи (эмулятор) против окон (loop) ═══
+  // Сумма перезаписей по окнам = накопительному счётчику: ни одна не потеряна
+  stats.reset();
+  const uint32_t N = 2000000;
+  std::atomic<bool> done(false);
+  std::thread emu([&]() {
+    for (uint32_t i = 0; i < N; i++) stats.noteOverwrite();
+    done.store(true);
+  });
+  uint64_t sum = 0;
+  uint32_t windows = 0;
+  while (!done.load()) {
+    pull(0);  // Audio Task сбрасывает окно в noteSilence/notePlayed
+    stats.takeWindow(w);
+    sum += w.overwrites;
+    windows++;
+  }
+  emu.join();
+  pull(0);
+  stats.takeWindow(w);
+  sum += w.overwrites;
+  CHECK(stats.overwriteCount() == N, "total %u", stats.overwriteCount());
+  CHECK(sum == N, "windows lost %lld of %u overwrites (%u windows)", (long long)N - (long long)sum, N, windows);
+
+  return hostReport("test_audio_stats");
+}
@@ -0,0 +1,116 @@
+// AY-3-8912 (V3.148) без эмулятора: записи регистров → renderFrame, как
+// в Audio Task. Частота тона, период пилы огибающей, тишина и отсутствие
+// синтеза до первой записи (в т.ч. после ресинхронизации нулями).
+#include "host_test.h"
+#include "ay_chip.h"
+#include <string.h>
+#include <vector>
+
+static const uint32_t FRAME_LEN = 69888;   // t-states кадра 48K
+static const int OUT = 882;                // Сэмплов на кадр (~44.2 kHz)
+static const int FRAMES = 50;              // ~1 с
+static const double SECONDS = FRAMES * (double)FRAME_LEN / AYChip::CPU_HZ;
+
+// FRAMES кадров подряд; первые writes - в начале первого кадра
+static std::vector<int16_t> render(AYChip& ay, const AYWrite* writes, int count) {
+  std::vector<int16_t> pcm(OUT * FRAMES, 0);
+  for (int f = 0; f < FRAMES; f++) {
+    ay.renderFrame(f == 0 ? writes : nullptr, f == 0 ? count : 0, FRAME_LEN, &pcm[f * OUT], OUT, 10);
+  }
+  return pcm;
+}
+
+// Переходы через 0 снизу вверх (DC-блокер центрирует меандр)
+static int risingCrossings(const std::vector<int16_t>& pcm) {
+  int n = 0;
+  for (size_t i = 1; i < pcm.size(); i++) {
+    if (pcm[i - 1] < 0 && pcm[i] >= 0) n++;
+  }
+  return n;
+}
+
+// Скачки вверх больше порога: пила вниз (\|\|) = один скачок на рампу.
+// Скачок может попасть на границу сэмплов (box-фильтр) → смотрим через 2
+static int upwardJumps(const std::vector<int16_t>& pcm, int threshold) {
+  int n = 0;
+  for (size_t i = 2; i < pcm.size(); i++) {
+    if (pcm[i] - pcm[i - 2] > threshold) {
+      n++;
+      i++;
+    }
+  }
+  return n;
+}
+
+static bool silent(const std::vector<int16_t>& pcm) {
+  for (int16_t v : pcm) {
+    if (v) return false;
+  }
+  return true;
+}
+
+int main() {
+  // ═══ 1) До первой записи: тишина и синтез выключен ═══
+  {
+    AYChip ay;
+    std::vector<int16_t> pcm = render(ay, nullptr, 0);
+    CHECK(!ay.isActive() && silent(pcm), "untouched AY active %d", ay.isActive());
+  }
+
+  // ═══ 2) Ресинхронизация нулями (сброс эмулятора, 48K игра) не включает синтез ═══
+  {
+    AYChip ay;
+    uint8_t regs[16] = {0};
+    regs[7] = 0xFF;
+    ay.syncRegs(regs);
+    std::vector<int16_t> pcm = render(ay, nullptr, 0);
+    CHECK(!ay.isActive() && silent(pcm), "reset resync made AY active");
+
+    regs[8] = 0x0F;   // Канал A громкость 15 (128K снимок посреди мелодии)
+    regs[7] = 0xFE;
+    regs[0] = 100;
+    ay.syncRegs(regs);
+    pcm = render(ay, nullptr, 0);
+    CHECK(ay.isActive() && !silent(pcm), "resync with volume stayed silent");
+
+    AYChip env;
+    memset(regs, 0, sizeof(regs));
+    regs[7] = 0xFF;
+    regs[9] = 0x10;   // Канал B от огибающей
+    env.syncRegs(regs);
+    CHECK(env.isActive(), "resync with envelope amplitude stayed inactive");
+  }
+
+  // ═══ 3) Частота тона: clock / (16 · TP) ═══
+  for (int tp : {50, 100, 400, 1000}) {
+    AYChip ay;
+    AYWrite w[] = {
+      {0, 0, (uint8_t)(tp & 0xFF)}, {0, 1, (uint8_t)(tp >> 8)},
+      {0, 7, 0xFE},                  // Только тон A
+      {0, 8, 0x0F}
+    };
+    std::vector<int16_t> pcm = render(ay, w, 4);
+    double hz = risingCrossings(pcm) / SECONDS;
+    double expect = AYChip::CLOCK_HZ / (16.0 * tp);
+    CHECK(hz > expect * 0.99 - 1 && hz < expect * 1.01 + 1, "tone TP=%d: %.1f Hz, expected %.1f", tp, hz, expect);
+    printf("ay: tone TP=%4d → %7.1f Hz (expected %7.1f)\n", tp, hz, expect);
+  }
+
+  // ═══ 4) Пила огибающей: рампа = 256 · EP тактов ═══
+  for (int ep : {10, 20, 100}) {
+    AYChip ay;
+    AYWrite w[] = {
+      {0, 7, 0xFF},                  // Тон и шум выключены → канал = огибающая
+      {0, 8, 0x10},
+      {0, 11, (uint8_t)(ep & 0xFF)}, {0, 12, (uint8_t)(ep >> 8)},
+      {0, 13, 0x08}                  // Continue, спад: \|\|\|
+    };
+    std::vector<int16_t> pcm = render(ay, w, 5);
+    double hz = upwardJumps(pcm, 2000) / SECONDS;
+    double expect = AYChip::CLOCK_HZ / (256.0 * ep);
+    CHECK(hz > expect * 0.98 - 1 && hz < expect * 1.02 + 1, "envelope EP=%d: %.1f Hz, expected %.1f", ep, hz, expect);
+    printf("ay: envelope EP=%4d → %7.1f Hz (expected %7.1f)\n", ep, hz, expect);
+  }
+
+  return hostReport("test_ay_chip");
+}
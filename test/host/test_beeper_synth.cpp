@@ -0,0 +1,144 @@
+// Band-limited синтез beeper (V3.144, лента через него же - V3.150):
+// BeeperSynth::renderFrame - целочисленная функция фронты → PCM с
+// громкостью. Сверка с double эталоном того же конвейера
+// (BLIT · интегратор · DC-блокер · громкость) + скорость кадра.
+#include "host_test.h"
+#include "beeper_synth.h"
+#include <math.h>
+#include <random>
+#include <vector>
+
+// Эталон в double: то же ядро Blackman·sinc без квантования
+class RefSynth {
+public:
+  RefSynth() { reset(); }
+  void reset() {
+    for (double& d : deltas) d = 0.0;
+    integrator = 0.0;
+    dcPrevIn = dcPrevOut = 0.0;
+    level = 0;
+  }
+  void render(const uint32_t* edges, int count, uint32_t frameLen, double* out, int outCount,
+              int volume, double earAmp) {
+    for (int e = 0; e < count; e++) {
+      uint32_t t = edges[e] & ~BeeperSynth::EDGE_EAR;
+      uint8_t bit = (edges[e] & BeeperSynth::EDGE_EAR) ? 2 : 1;
+      double amp = (bit == 2) ? earAmp : BeeperSynth::AMP;
+      // Та же сетка 1/32 сэмпла, что и в синтезе (квантование позиции - часть алгоритма)
+      uint32_t pos32 = (uint32_t)(((uint64_t)t * outCount * BeeperSynth::PHASES) / frameLen);
+      addStep(pos32, (level & bit) ? -amp : amp);
+      level ^= bit;
+    }
+    const double R = 32604.0 / 32768.0;
+    for (int s = 0; s < outCount; s++) {
+      integrator += deltas[s];
+      double y = integrator - dcPrevIn + dcPrevOut * R;
+      dcPrevIn = integrator;
+      dcPrevOut = y;
+      double v = y * volume / 10.0;
+      out[s] = v > 32767 ? 32767 : (v < -32768 ? -32768 : v);
+    }
+    for (int i = 0; i < BeeperSynth::TAPS; i++) deltas[i] = deltas[outCount + i];
+    for (int i = BeeperSynth::TAPS; i < BeeperSynth::MAX_OUT + BeeperSynth::TAPS; i++) deltas[i] = 0.0;
+  }
+
+private:
+  void addStep(uint32_t pos32, double delta) {
+    const int TAPS = BeeperSynth::TAPS;
+    double frac = (double)(pos32 & (BeeperSynth::PHASES - 1)) / BeeperSynth::PHASES;
+    double raw[TAPS], sum = 0.0;
+    for (int k = 0; k < TAPS; k++) {
+      double x = (double)k - (TAPS / 2 - 1) - frac;
+      double s = (x == 0.0) ? 1.0 : sin(M_PI * 0.9 * x) / (M_PI * 0.9 * x);
+      double w = (x + TAPS / 2.0) / TAPS;
+      double win = (w <= 0.0 || w >= 1.0) ? 0.0
+                 : 0.42 - 0.5 * cos(2.0 * M_PI * w) + 0.08 * cos(4.0 * M_PI * w);
+      raw[k] = s * win;
+      sum += raw[k];
+    }
+    for (int k = 0; k < TAPS; k++) deltas[(pos32 >> 5) + k] += delta * raw[k] / sum;
+  }
+
+  double deltas[BeeperSynth::MAX_OUT + BeeperSynth::TAPS];
+  double integrator, dcPrevIn, dcPrevOut;
+  uint8_t level;
+};
+
+// Кадр фронтов: периодический тон + случайные одиночные фронты (+ EAR)
+static int makeFrame(std::mt19937& rng, uint32_t* edges, int maxEdges, bool ear) {
+  int n = 0;
+  uint32_t period = 200 + rng() % 4000;
+  for (uint32_t t = rng() % period; t < 69888 && n < maxEdges; t += period / 2 + rng() % 8) {
+    edges[n++] = t | ((ear && (rng() & 1)) ? BeeperSynth::EDGE_EAR : 0);
+  }
+  return n;  // t растёт - уже по возрастанию
+}
+
+int main() {
+  std::mt19937 rng(31);
+  static uint32_t edges[4096];
+  int16_t out[BeeperSynth::MAX_OUT];
+  double ref[BeeperSynth::MAX_OUT];
+
+  // ═══ Точность: все громкости, DRC длины кадра, beeper + EAR ═══
+  for (int volume = 0; volume <= 10; volume++) {
+    BeeperSynth synth;
+    synth.init();
+    RefSynth r;
+    double maxErr = 0.0;
+    uint8_t level = 0;
+    for (int f = 0; f < 500; f++) {
+      int outCount = BeeperSynth::SPPF - 4 + (int)(rng() % 9);
+      int n = makeFrame(rng, edges, 4096, true);
+      // startLevel = уровень конца прошлого кадра (как без переполнения лога)
+      synth.renderFrame(edges, n, level, 69888, out, outCount, volume);
+      r.render(edges, n, 69888, ref, outCount, volume, BeeperSynth::AMP);
+      for (int s = 0; s < outCount; s++) maxErr = fmax(maxErr, fabs(out[s] - ref[s]));
+      for (int i = 0; i < n; i++) level ^= (edges[i] & BeeperSynth::EDGE_EAR) ? 2 : 1;
+    }
+    // Ошибка: Q15 ядро + пол в DC-блокере (~0.5 LSB × 1/(1-R) ≈ 100 до громкости)
+    CHECK(maxErr <= 12.0 * volume + 1.0, "volume %d: max error %.1f LSB", volume, maxErr);
+    if (volume == 0) CHECK(maxErr == 0.0, "volume 0 must be silent");
+    if (volume == 10) printf("beeper synth: max error vs double %.1f LSB of 32768 at volume 10\n", maxErr);
+  }
+
+  // ═══ Насыщение: beeper + EAR ×2 одновременно, громкость 10 - без переворота знака ═══
+  {
+    BeeperSynth synth;
+    synth.init();
+    synth.setEarGain(512);
+    bool wrapped = false;
+    for (int f = 0; f < 50; f++) {
+      int n = 0;
+      for (uint32_t t = 1000; t < 69888; t += 7000) {
+        edges[n++] = t;
+        edges[n++] = t | BeeperSynth::EDGE_EAR;
+      }
+      synth.renderFrame(edges, n, 0, 69888, out, BeeperSynth::SPPF, 10);
+      for (int s = 1; s < BeeperSynth::SPPF; s++) {
+        // Соседние сэмплы band-limited сигнала не прыгают через весь диапазон
+        if (abs(out[s] - out[s - 1]) > 40000) wrapped = true;
+      }
+    }
+    CHECK(!wrapped, "saturation wrapped around");
+  }
+
+  // ═══ Скорость: кадр 320 сэмплов, тишина / тон / плотные фронты ═══
+  const int counts[3] = {0, 100, 2000};
+  for (int c = 0; c < 3; c++) {
+    BeeperSynth synth;
+    synth.init();
+    int n = 0;
+    for (int i = 0; i < counts[c]; i++) edges[n++] = (uint32_t)((uint64_t)i * 69888 / (counts[c] + 1));
+    const int FRAMES = 20000;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int f = 0; f < FRAMES; f++) {
+      synth.renderFrame(edges, n, (f * n) & 1, 69888, out, BeeperSynth::SPPF, 7);
+    }
+    double us = hostSecondsSince(t0) / FRAMES * 1e6;
+    printf("beeper synth: %4d edges/frame → %.2f us/frame (%.3f%% of a 20 ms frame) [%d]\n",
+           n, us, us / 200.0, out[17] & 1);
+  }
+
+  return hostReport("test_beeper_synth");
+}
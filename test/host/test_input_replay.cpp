@@ -0,0 +1,184 @@
+// Запись/повтор ввода (V3.159) на настоящем ядре: ROM 48K крутит BASIC,
+// "живой" ввод меняется в начале кадра и на строке захвата, как в loop()
+// (publishKeyMatrix → frameStart, latch hook → latch). Повтор должен
+// пройти без расхождений и привести машину в то же состояние.
+#include "host_test.h"
+#include "spectrum_mini.h"
+#include "input_replay.h"
+#include <vector>
+
+HardwareSerial Serial;
+
+extern "C" {
+  byte Z80MemRead(uint16_t address, void* userInfo) { return ((ZXSpectrum*)userInfo)->z80_peek(address); }
+  void Z80MemWrite(uint16_t address, byte data, void* userInfo) { ((ZXSpectrum*)userInfo)->z80_poke(address, data); }
+  byte Z80InPort(uint16_t port, void* userInfo) { return ((ZXSpectrum*)userInfo)->z80_in(port); }
+  void Z80OutPort(uint16_t port, byte data, void* userInfo) { ((ZXSpectrum*)userInfo)->z80_out(port, data); }
+}
+
+static const int RECORD_FRAMES = 1500;
+static const int LATCH_LINE = 296;
+static const size_t STREAM_START = InputReplay::HEADER_SIZE + MachineSnapshot::SERIAL_SIZE;
+
+static ZXSpectrum* spec;
+static InputReplay replay;
+static std::atomic<uint8_t> liveJoy(0);
+static int frame = 0;
+static bool liveInput = true;
+
+// "Живой" ввод: клавиша иногда нажата, джойстик со старшими битами
+// (задача опроса может отдать что угодно - в файл идут только 5 бит)
+static void publishInput(int phase) {
+  if (!liveInput) return;
+  memset(speckey, 0xFF, sizeof(uint8_t) * 8);
+  int key = ((frame * 7 + phase * 3) / 13) % 40;
+  if ((frame / 9 + phase) % 3 == 0) speckey[key / 5] &= ~(1 << (key % 5));
+  liveJoy.store(0xE0 | ((frame / 5) & 0x1F));
+}
+
+static void onLatch(void*) {
+  publishInput(1);
+  replay.latch(spec);
+}
+
+// Один кадр loop(): ввод → frameStart → runForFrame (latch внутри) → frameEnd
+static bool runFrame() {
+  spec->joystickSource = &liveJoy;
+  publishInput(0);
+  replay.frameStart(spec);
+  spec->runForFrame();
+  return replay.frameEnd(spec);
+}
+
+static uint8_t* copyOf(const uint8_t* data, size_t len) {
+  uint8_t* out = (uint8_t*)malloc(len);
+  memcpy(out, data, len);
+  return out;
+}
+
+// Смещение поля подписи READS в первом кадре, где оно записано (0 = нет)
+static size_t findReadsField(const uint8_t* data, size_t len, int* frameOut) {
+  size_t p = STREAM_START;
+  for (int f = 0; p < len; f++) {
+    uint8_t tag = data[p++];
+    if (tag & 0x01) p += 9;
+    if (tag & 0x02) p += 9;
+    if (tag & 0x04) {
+      *frameOut = f;
+      return p;
+    }
+    if (tag & 0x08) p += 2;
+  }
+  return 0;
+}
+
+int main() {
+  spec = new ZXSpectrum();
+  spec->reset();
+  spec->init_48k();
+  spec->reset_spectrum();
+  spec->setInputLatch(LATCH_LINE, onLatch, nullptr);
+  while (!spec->romReady()) spec->runForFrame();
+  spec->setJoystickMode(JOY_SINCLAIR1);
+
+  // ═══ 1) Вне записи/повтора подпись IN не считается ═══
+  spec->inputReads = 0;
+  runFrame();
+  CHECK(spec->inputReads == 0 && !spec->inputSignature, "idle frame counted %u reads", spec->inputReads);
+
+  // ═══ 2) Запись ═══
+  spec->joystickSource = &liveJoy;
+  CHECK(replay.startRecording(spec), "startRecording");
+  for (frame = 0; frame < RECORD_FRAMES; frame++) {
+    CHECK(!runFrame(), "buffer full at frame %d", frame);
+  }
+  std::vector<uint8_t> ram(spec->mem.ram, spec->mem.ram + 0xC000);
+  uint16_t pc = spec->z80Regs->PC.W;
+  size_t len = 0;
+  uint8_t* file = replay.finishRecording(&len);
+  CHECK(file && len > STREAM_START + RECORD_FRAMES, "recording %zu bytes", len);
+  CHECK(!spec->inputSignature, "signature left on after recording");
+  printf("input_replay: %d frames → %zu bytes of stream\n", RECORD_FRAMES, len - STREAM_START);
+
+  // ═══ 3) Повтор с испорченной машиной: те же IN, та же память ═══
+  memset(spec->mem.ram, 0x55, 0xC000);
+  spec->setJoystickMode(JOY_QAOP);
+  spec->setInputLatch(-1, onLatch, nullptr);
+  liveInput = false;
+  CHECK(replay.startPlayback(copyOf(file, len), len, spec), "startPlayback");
+  CHECK(spec->inputLatchLine == LATCH_LINE && spec->joystickMode == JOY_SINCLAIR1, "header not applied");
+  bool ended = false;
+  bool joyMasked = true;
+  auto t0 = std::chrono::steady_clock::now();
+  for (frame = 0; frame < RECORD_FRAMES + 10 && replay.active(); frame++) {
+    memset(speckey, 0xFF, sizeof(uint8_t) * 8);
+    spec->joystickSource = &liveJoy;
+    replay.frameStart(spec);
+    if (replay.active() && spec->joystickSource->load() > 0x1F) joyMasked = false;
+    spec->runForFrame();
+    ended = replay.frameEnd(spec);
+  }
+  double sec = hostSecondsSince(t0);
+  const ReplayResult& r = replay.result();
+  CHECK(ended && !replay.active(), "playback did not end");
+  CHECK(r.frames == RECORD_FRAMES && r.mismatches == 0, "%u frames, %u mismatched (first %d)",
+        r.frames, r.mismatches, r.firstMismatch);
+  CHECK(memcmp(ram.data(), spec->mem.ram, 0xC000) == 0, "RAM differs after replay");
+  CHECK(pc == spec->z80Regs->PC.W, "PC %04X, recorded %04X", spec->z80Regs->PC.W, pc);
+  CHECK(spec->joystickMode == JOY_QAOP && spec->inputLatchLine == -1, "joystick/latch not restored");
+  CHECK(joyMasked, "joystick byte above bit 4 reached the emulator");
+  printf("input_replay: playback %.0f frames/s (%.1fx real time)\n", r.frames / sec, r.frames / sec / 50.0);
+
+  // ═══ 4) Мусор в старших битах джойстика в файле: отбрасывается при чтении ═══
+  spec->setInputLatch(LATCH_LINE, onLatch, nullptr);
+  uint8_t* dirty = copyOf(file, len);
+  CHECK(dirty[STREAM_START] & 0x01, "first frame has no start state");
+  dirty[STREAM_START + 1 + 8] |= 0xE0;
+  CHECK(replay.startPlayback(dirty, len, spec), "startPlayback (dirty joystick)");
+  replay.frameStart(spec);
+  CHECK(spec->joystickSource->load() <= 0x1F, "joystick byte %02X from file not masked", spec->joystickSource->load());
+  replay.abort(spec);
+  CHECK(!spec->inputSignature, "signature left on after abort");
+
+  // ═══ 5) Другая подпись IN в файле → расхождение в том же кадре ═══
+  uint8_t* bad = copyOf(file, len);
+  int badFrame = -1;
+  size_t field = findReadsField(bad, len, &badFrame);
+  CHECK(field != 0, "no READS field in stream");
+  bad[field] ^= 0x01;
+  CHECK(replay.startPlayback(bad, len, spec), "startPlayback (bad signature)");
+  for (frame = 0; frame < RECORD_FRAMES + 10 && replay.active(); frame++) {
+    spec->joystickSource = &liveJoy;
+    replay.frameStart(spec);
+    spec->runForFrame();
+    replay.frameEnd(spec);
+  }
+  CHECK(replay.result().firstMismatch == badFrame, "first mismatch %d, corrupted frame %d",
+        replay.result().firstMismatch, badFrame);
+
+  // ═══ 6) Пустая запись (стоп сразу после старта) не запускается ═══
+  CHECK(replay.startRecording(spec), "startRecording (empty)");
+  size_t emptyLen = 0;
+  uint8_t* empty = replay.finishRecording(&emptyLen);
+  CHECK(empty && emptyLen == STREAM_START, "empty recording %zu bytes", emptyLen);
+  CHECK(!replay.startPlayback(empty, emptyLen, spec) && !replay.active(), "empty recording accepted");
+
+  // ═══ 7) Обрезанный файл: кадры в заголовке есть, потока нет/мало ═══
+  for (size_t cut : {STREAM_START, STREAM_START + 1, STREAM_START + 10, STREAM_START + (len - STREAM_START) / 2}) {
+    uint8_t* part = copyOf(file, cut);
+    bool started = replay.startPlayback(part, cut, spec);
+    CHECK(started == (cut > STREAM_START), "cut %zu: started %d", cut, started);
+    int frames = 0;
+    for (; frames < RECORD_FRAMES + 10 && replay.active(); frames++) {
+      spec->joystickSource = &liveJoy;
+      replay.frameStart(spec);
+      spec->runForFrame();
+      replay.frameEnd(spec);
+    }
+    CHECK(!replay.active() && frames < RECORD_FRAMES, "cut %zu: ran %d frames", cut, frames);
+    CHECK(spec->joystickSource == &liveJoy, "cut %zu: joystick source not restored", cut);
+  }
+
+  free(file);
+  return hostReport("test_input_replay");
+}
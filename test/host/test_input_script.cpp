@@ -0,0 +1,103 @@
+// Сценарий нажатий (V3.156) на настоящем ядре: LOAD "" как в TAPLoader -
+// с холодного сброса и из снимка готовой ROM (V3.157, warmReset). ROM
+// должна принять команду (вызвать LD-BYTES) за минимум кадров. Плюс
+// таймаут ожидания, предел кадров и матрица press/release.
+#include "host_test.h"
+#include "spectrum_mini.h"
+#include "machine_snapshot.h"
+#include "input_script.h"
+
+HardwareSerial Serial;
+
+extern "C" {
+  byte Z80MemRead(uint16_t address, void* userInfo) { return ((ZXSpectrum*)userInfo)->z80_peek(address); }
+  void Z80MemWrite(uint16_t address, byte data, void* userInfo) { ((ZXSpectrum*)userInfo)->z80_poke(address, data); }
+  byte Z80InPort(uint16_t port, void* userInfo) { return ((ZXSpectrum*)userInfo)->z80_in(port); }
+  void Z80OutPort(uint16_t port, byte data, void* userInfo) { ((ZXSpectrum*)userInfo)->z80_out(port, data); }
+}
+
+// LD-BYTES (0x0556) и его циклы LD-EDGE/LD-8-BITS - ROM ждёт ленту
+static const uint16_t LD_BYTES = 0x0556;
+static const uint16_t LD_BYTES_END = 0x0605;
+
+static ZXSpectrum* spec;
+
+// Сценарий TAPLoader: ROM готова → J, SS+P, SS+P, ENTER
+static void loadScript(InputScript& script) {
+  script.clear();
+  script.waitRomReady();
+  script.type(SPECKEY_J);
+  script.type(SPECKEY_P, SPECKEY_SYMB);
+  script.type(SPECKEY_P, SPECKEY_SYMB);
+  script.type(SPECKEY_ENTER);
+}
+
+// Команда принята: через пару кадров без клавиш ROM крутится в LD-BYTES
+static bool inLdBytes() {
+  for (int f = 0; f < 3; f++) spec->runForFrame();
+  uint16_t pc = spec->z80Regs->PC.W;
+  return pc >= LD_BYTES && pc <= LD_BYTES_END;
+}
+
+int main() {
+  spec = new ZXSpectrum();
+  spec->reset();
+  spec->init_48k();
+  spec->reset_spectrum();
+  Serial.quiet = true;
+
+  InputScript script;
+
+  // ═══ 1) Холодный старт: ждём ROM, набираем LOAD "" ═══
+  loadScript(script);
+  int cold = script.run(spec, 600);
+  CHECK(cold > 0 && cold < 150, "cold LOAD \"\": %d frames", cold);
+  CHECK(!script.running() && !script.failed(), "cold script state");
+  CHECK(inLdBytes(), "cold LOAD \"\" not accepted, PC %04X", spec->z80Regs->PC.W);
+
+  // ═══ 2) Из снимка готовой ROM (warmReset): только набор ═══
+  spec->reset();
+  while (!spec->romReady()) spec->runForFrame();
+  MachineSnapshot ready;
+  CHECK(ready.capture(spec), "capture ready snapshot");
+  spec->readySnapshot = &ready;
+  for (int f = 0; f < 20; f++) spec->runForFrame();   // Машина ушла от снимка
+  spec->warmReset();
+  loadScript(script);
+  int warm = script.run(spec, 600);
+  CHECK(warm > 0 && warm < 40, "warm LOAD \"\": %d frames", warm);
+  CHECK(inLdBytes(), "warm LOAD \"\" not accepted, PC %04X", spec->z80Regs->PC.W);
+  printf("input_script: LOAD \"\" accepted after %d frames cold, %d from the ready snapshot\n", cold, warm);
+
+  // ═══ 3) Ожидание памяти не дождалось → -1, матрица отпущена ═══
+  spec->warmReset();
+  script.clear();
+  script.press(SPECKEY_A);
+  script.waitMem(InputScript::SV_FLAGS, 0xFF, 0xAA, 10);
+  CHECK(script.run(spec, 600) == -1 && script.failed() && !script.running(), "waitMem timeout not reported");
+  CHECK(script.frames() == 10, "waitMem timed out after %u frames", script.frames());
+  CHECK(script.rows()[1] == 0xFF && speckey[1] == 0xFF, "keys left pressed after failure");
+
+  // ═══ 4) Предел кадров run() ═══
+  script.clear();
+  script.waitFrames(100);
+  CHECK(script.run(spec, 30) == -1 && script.failed(), "maxFrames not enforced");
+  script.start();
+  CHECK(script.run(spec, 200) == 100 && !script.failed(), "waitFrames(100): %u frames", script.frames());
+
+  // ═══ 5) press/release по шагам: rows() перед каждым кадром ═══
+  script.clear();
+  script.press(SPECKEY_A);             // Ряд 1 (A-G), бит 0
+  script.press(SPECKEY_SYMB);          // Ряд 7, бит 1
+  script.waitFrames(1);
+  script.release(SPECKEY_A);
+  script.waitFrames(1);
+  script.start();
+  CHECK(script.step(spec) && script.rows()[1] == 0xFE && script.rows()[7] == 0xFD, "press: rows %02X %02X",
+        script.rows()[1], script.rows()[7]);
+  CHECK(script.step(spec) && script.rows()[1] == 0xFF && script.rows()[7] == 0xFD, "release: rows %02X %02X",
+        script.rows()[1], script.rows()[7]);
+  CHECK(!script.step(spec) && !script.running() && script.rows()[7] == 0xFF, "finished script still holds keys");
+
+  return hostReport("test_input_script");
+}
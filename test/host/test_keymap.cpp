@@ -0,0 +1,166 @@
+// Раскладка Cardputer → ZX (V3.153): KeyMap::setProfile/build против
+// таблицы letterToSpecKeys и ожидаемых аккордов (stubs/M5Cardputer.h -
+// только KeysState). Стрелки ; . , / по профилям, заглавные буквы,
+// Fn/Shift/Del, перестройка матрицы только по изменению (rebuildDue).
+#include "host_test.h"
+#include "keymap.h"
+#include <initializer_list>
+
+HardwareSerial Serial;
+
+extern "C" {
+  byte Z80MemRead(uint16_t address, void* userInfo) { return ((ZXSpectrum*)userInfo)->z80_peek(address); }
+  void Z80MemWrite(uint16_t address, byte data, void* userInfo) { ((ZXSpectrum*)userInfo)->z80_poke(address, data); }
+  byte Z80InPort(uint16_t port, void* userInfo) { return ((ZXSpectrum*)userInfo)->z80_in(port); }
+  void Z80OutPort(uint16_t port, byte data, void* userInfo) { ((ZXSpectrum*)userInfo)->z80_out(port, data); }
+}
+
+typedef Keyboard_Class::KeysState KeysState;
+
+struct Rows {
+  uint8_t r[8];
+  bool operator==(const Rows& o) const { return memcmp(r, o.r, 8) == 0; }
+};
+
+// Матрица с нажатыми клавишами ZX (как updateKey по одной)
+static Rows expect(std::initializer_list<SpecKeys> keys) {
+  Rows e;
+  memset(e.r, 0xFF, 8);
+  for (SpecKeys k : keys) {
+    if (k > SPECKEY_NONE && k < SPECKEY_MAX_NORMAL) e.r[key2specy[0][k]] &= key2specy[1][k];
+  }
+  return e;
+}
+
+static Rows built(const KeyMap& map, const KeysState& status) {
+  Rows got;
+  map.build(status, got.r);
+  return got;
+}
+
+static KeysState typed(std::initializer_list<char> chars) {
+  KeysState s;
+  s.word.assign(chars);
+  return s;
+}
+
+static void checkChar(const KeyMap& map, char c, std::initializer_list<SpecKeys> keys) {
+  Rows got = built(map, typed({c}));
+  CHECK(got == expect(keys), "%s: '%c' → %02X %02X %02X %02X %02X %02X %02X %02X", map.profileName(), c,
+        got.r[0], got.r[1], got.r[2], got.r[3], got.r[4], got.r[5], got.r[6], got.r[7]);
+}
+
+int main() {
+  KeyMap map;
+  CHECK(map.profile() == KEYMAP_QAOP, "default profile %d", map.profile());
+
+  // ═══ 1) Все символы letterToSpecKeys (кроме стрелок) во всех профилях ═══
+  for (int p = 0; p < KEYMAP_PROFILE_COUNT; p++) {
+    map.setProfile((KeymapProfile)p);
+    for (const auto& entry : letterToSpecKeys) {
+      char c = entry.first;
+      if (p != KEYMAP_TYPING && (c == ';' || c == '.' || c == ',' || c == '/')) continue;
+      const std::vector<SpecKeys>& keys = entry.second;
+      checkChar(map, c, {keys[0], keys.size() > 1 ? keys[1] : SPECKEY_NONE});
+    }
+  }
+
+  // ═══ 2) Стрелки Cardputer по профилям ═══
+  map.setProfile(KEYMAP_QAOP);
+  checkChar(map, ';', {SPECKEY_Q});
+  checkChar(map, '.', {SPECKEY_A});
+  checkChar(map, ',', {SPECKEY_O});
+  checkChar(map, '/', {SPECKEY_P});
+  map.setProfile(KEYMAP_CURSOR);
+  checkChar(map, ';', {SPECKEY_SHIFT, SPECKEY_7});
+  checkChar(map, '.', {SPECKEY_SHIFT, SPECKEY_6});
+  checkChar(map, ',', {SPECKEY_SHIFT, SPECKEY_5});
+  checkChar(map, '/', {SPECKEY_SHIFT, SPECKEY_8});
+  map.setProfile(KEYMAP_TYPING);
+  checkChar(map, ';', {SPECKEY_O, SPECKEY_SYMB});
+  checkChar(map, '.', {SPECKEY_M, SPECKEY_SYMB});
+  checkChar(map, ',', {SPECKEY_N, SPECKEY_SYMB});
+  checkChar(map, '/', {SPECKEY_V, SPECKEY_SYMB});
+
+  // nextProfile по кругу, неверный профиль → QAOP (стрелки снова Q A O P)
+  map.nextProfile();
+  CHECK(map.profile() == KEYMAP_QAOP && !strcmp(map.profileName(), "QAOP"), "TYPING → %s", map.profileName());
+  map.nextProfile();
+  CHECK(map.profile() == KEYMAP_CURSOR, "QAOP → %s", map.profileName());
+  map.setProfile((KeymapProfile)7);
+  CHECK(map.profile() == KEYMAP_QAOP, "bad profile → %s", map.profileName());
+  checkChar(map, ';', {SPECKEY_Q});
+
+  // ═══ 3) Заглавные буквы: та же клавиша, CAPS SHIFT - от status.shift ═══
+  for (char c = 'A'; c <= 'Z'; c++) {
+    CHECK(built(map, typed({c})) == built(map, typed({(char)(c + 32)})), "'%c' differs from '%c'", c, c + 32);
+  }
+  KeysState upper = typed({'J'});
+  upper.shift = true;
+  CHECK(built(map, upper) == expect({SPECKEY_SHIFT, SPECKEY_J}), "Shift+J");
+
+  // ═══ 4) Fn / Shift / Del / Enter / Space и аккорды ═══
+  KeysState s;
+  s.fn = true;
+  CHECK(built(map, s) == expect({SPECKEY_SYMB}), "Fn alone");
+  s.word = {'p'};
+  CHECK(built(map, s) == expect({SPECKEY_SYMB, SPECKEY_P}), "Fn+P");
+  s = KeysState();
+  s.shift = true;
+  CHECK(built(map, s) == expect({SPECKEY_SHIFT}), "Shift alone");
+  s.word = {'7'};
+  CHECK(built(map, s) == expect({SPECKEY_SHIFT, SPECKEY_7}), "Shift+7");
+  s = KeysState();
+  s.del = true;
+  CHECK(built(map, s) == expect({SPECKEY_SHIFT, SPECKEY_0}), "Del");
+  s.word = {'q', 'w'};
+  CHECK(built(map, s) == expect({SPECKEY_SHIFT, SPECKEY_0, SPECKEY_Q, SPECKEY_W}), "Del+Q+W");
+  s = KeysState();
+  s.enter = true;
+  s.space = true;
+  s.shift = true;
+  s.fn = true;
+  CHECK(built(map, s) == expect({SPECKEY_ENTER, SPECKEY_SPACE, SPECKEY_SHIFT, SPECKEY_SYMB}), "Enter+Space+Shift+Fn");
+  CHECK(built(map, typed({(char)0x80, (char)0xC1, '\t'})) == expect({}), "non-ASCII/unmapped chars pressed keys");
+
+  // ═══ 5) Перестройка только по изменению ═══
+  // Как handleKeyboard(): beginScan() каждый опрос; rebuildDue() - если
+  // опрос дошёл до матрицы (false = вышли раньше: меню, Opt, хоткей)
+  KeyMap gate;
+  struct { bool changed; bool reachesMatrix; bool due; } scans[] = {
+    {false, true, false},   // Первый опрос, ничего не нажато
+    {true, true, true},     // Нажатие
+    {false, true, false},   // Держим
+    {false, true, false},
+    {true, false, false},   // Opt: матрицу не трогали, строки сброшены
+    {false, true, true},    // → перестроить, хотя isChange уже false
+    {false, true, false},
+    {false, false, false},  // Меню
+    {false, false, false},
+    {false, true, true},
+    {true, true, true}      // Отпускание
+  };
+  for (size_t i = 0; i < sizeof(scans) / sizeof(scans[0]); i++) {
+    gate.beginScan();
+    if (!scans[i].reachesMatrix) continue;
+    bool due = gate.rebuildDue(scans[i].changed);
+    CHECK(due == scans[i].due, "scan %zu: rebuildDue %d, expected %d", i, due, scans[i].due);
+  }
+
+  // ═══ 6) Замер build() на типичном состоянии ═══
+  KeysState busy = typed({'q', 'a', 'o', 'p'});
+  busy.space = true;
+  busy.shift = true;
+  const int REPS = 1000000;
+  uint8_t rows[8];
+  unsigned sink = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  for (int k = 0; k < REPS; k++) {
+    map.build(busy, rows);
+    sink += rows[k & 7];
+  }
+  double ns = hostSecondsSince(t0) / REPS * 1e9;
+  printf("keymap: build %.1f ns (4 chars + 2 modifiers, sink %u)\n", ns, sink & 1);
+
+  return hostReport("test_keymap");
+}
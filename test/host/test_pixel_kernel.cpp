@@ -0,0 +1,65 @@
+// Пиксельное ядро (V3.141): zxExpandCells бит-в-бит = zxExpandCellsRef,
+// + скорость обоих на строке 32 знакомест
+#include "host_test.h"
+#include "zx_pixel_kernel.h"
+#include <random>
+#include <vector>
+
+int main() {
+  std::mt19937 rng(29);
+  static uint16_t lut[256][2];
+  for (int a = 0; a < 256; a++) {
+    lut[a][0] = rng();
+    lut[a][1] = rng();
+  }
+
+  // Все байты bitmap × все атрибуты, разные длины и смещения в буфере
+  uint8_t bitmap[256], attrs[256];
+  for (int round = 0; round < 256; round++) {
+    for (int i = 0; i < 256; i++) {
+      bitmap[i] = i;
+      attrs[i] = (i + round * 37) & 0xFF;
+    }
+    int count = 1 + rng() % 256;
+    int start = rng() % (257 - count);
+    alignas(16) uint16_t ref[256 * 8 + 8], fast[256 * 8 + 8];
+    memset(ref, 0xAA, sizeof(ref));
+    memset(fast, 0xAA, sizeof(fast));
+    zxExpandCellsRef(ref + 2, bitmap + start, attrs + start, count, lut);
+    zxExpandCells(fast + 2, bitmap + start, attrs + start, count, lut);
+    CHECK(memcmp(ref, fast, sizeof(ref)) == 0, "round %d count %d start %d", round, count, start);
+  }
+
+  // Бенчмарк: строка экрана (32 знакоместа), случайные данные
+  const int LINES = 200000;
+  std::vector<uint8_t> bm(32 * 192), at(32 * 192);
+  for (auto& b : bm) b = rng();
+  for (auto& b : at) b = rng();
+  alignas(16) static uint16_t line[256];
+  uint32_t sink = 0;
+
+  auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < LINES; i++) {
+    int y = i % 192;
+    zxExpandCellsRef(line, &bm[y * 32], &at[y * 32], 32, lut);
+    sink += line[i & 255];
+  }
+  double refS = hostSecondsSince(t0);
+
+  t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < LINES; i++) {
+    int y = i % 192;
+    zxExpandCells(line, &bm[y * 32], &at[y * 32], 32, lut);
+    sink += line[i & 255];
+  }
+  double fastS = hostSecondsSince(t0);
+
+  printf("pixel kernel%s: ref %.1f ns/line, kernel %.1f ns/line (x%.1f) [%u]\n",
+#ifdef ZX_PIXEL_KERNEL_VEC128
+         " (VEC128)",
+#else
+         "",
+#endif
+         refS / LINES * 1e9, fastS / LINES * 1e9, refS / fastS, (unsigned)(sink & 1));
+  return hostReport("test_pixel_kernel");
+}
@@ -0,0 +1,140 @@
+// Перемотка (V3.161) на настоящем ядре: ROM 48K + "игра", которая пишет
+// в RAM через poke (как программа - с флагами dirty). После каждой точки
+// запоминаем RAM и состояние; шаг назад должен вернуть ровно их. Плюс
+// вытеснение по кольцу байт и по индексу точек, шаг назад через
+// restoreImage (загрузка слота) и одна точка = некуда.
+#include "host_test.h"
+#include "spectrum_mini.h"
+#include "rewind_buffer.h"
+#include <random>
+#include <vector>
+
+HardwareSerial Serial;
+
+extern "C" {
+  byte Z80MemRead(uint16_t address, void* userInfo) { return ((ZXSpectrum*)userInfo)->z80_peek(address); }
+  void Z80MemWrite(uint16_t address, byte data, void* userInfo) { ((ZXSpectrum*)userInfo)->z80_poke(address, data); }
+  byte Z80InPort(uint16_t port, void* userInfo) { return ((ZXSpectrum*)userInfo)->z80_in(port); }
+  void Z80OutPort(uint16_t port, byte data, void* userInfo) { ((ZXSpectrum*)userInfo)->z80_out(port, data); }
+}
+
+typedef std::vector<uint8_t> Bytes;
+
+// Машина в точке: RAM + регистры/порты (MachineSnapshot::captureState)
+struct PointImage {
+  Bytes ram;
+  Bytes state;
+};
+
+static ZXSpectrum* spec;
+static RewindBuffer rewindBuffer;
+static std::vector<PointImage> history;   // history[k] - точка k от последней базы
+static std::mt19937 rng(11);
+
+static PointImage now() {
+  PointImage p;
+  p.ram.assign(spec->mem.ram, spec->mem.ram + MachineSnapshot::RAM_SIZE);
+  p.state.resize(MachineSnapshot::STATE_SIZE);
+  MachineSnapshot::captureState(spec, p.state.data());
+  return p;
+}
+
+static bool same(const PointImage& a, const PointImage& b) {
+  return a.ram == b.ram && a.state == b.state;
+}
+
+// CAPTURE_EVERY кадров; pokes случайных записей в 0x8000-0xEFFF на кадр
+// (стек BASIC у RAMTOP не трогаем). Точка снимается на последнем кадре
+static void runPoint(int pokes) {
+  for (int f = 0; f < RewindBuffer::CAPTURE_EVERY; f++) {
+    for (int i = 0; i < pokes; i++) spec->mem.poke(0x8000 + rng() % 0x7000, rng());
+    spec->runForFrame();
+    rewindBuffer.frameDone(spec);
+  }
+  history.push_back(now());
+}
+
+// Назад на steps точек: отошли на сколько просили (или до базы) и
+// машина = запомненная точка. Лишние точки истории отбрасываются
+static int stepBackAndCheck(int steps, const char* what) {
+  int latest = (int)history.size() - 1;
+  int stepped = rewindBuffer.stepBack(spec, steps);
+  CHECK(stepped >= 0 && stepped <= steps && stepped <= latest, "%s: stepped %d of %d", what, stepped, steps);
+  history.resize(latest - stepped + 1);
+  CHECK(same(now(), history.back()), "%s: machine differs %d points back", what, stepped);
+  return stepped;
+}
+
+static void restart() {
+  rewindBuffer.clear();
+  history.clear();
+}
+
+int main() {
+  spec = new ZXSpectrum();
+  spec->reset();
+  spec->init_48k();
+  spec->reset_spectrum();
+  while (!spec->romReady()) spec->runForFrame();
+  CHECK(rewindBuffer.begin(), "begin");
+  Serial.quiet = true;
+
+  // ═══ 1) Одна точка (только база): назад некуда, машина не тронута ═══
+  restart();
+  runPoint(20);
+  for (int f = 0; f < 3; f++) spec->runForFrame();   // Живая машина ушла от точки
+  PointImage live = now();
+  CHECK(rewindBuffer.stepBack(spec, 10) == 0, "stepBack from a lone base point");
+  CHECK(same(now(), live), "lone base point: machine was rewound anyway");
+
+  // ═══ 2) Назад на N точек, дальше снова вперёд и назад ═══
+  restart();
+  for (int k = 0; k < 60; k++) runPoint(50);
+  for (int f = 0; f < 2; f++) spec->runForFrame();
+  CHECK(stepBackAndCheck(10, "step 10") == 10, "step 10 short");
+  CHECK(stepBackAndCheck(1, "step 1") == 1, "step 1 short");
+  for (int k = 0; k < 15; k++) runPoint(50);
+  CHECK(stepBackAndCheck(7, "step 7 after new points") == 7, "step 7 short");
+  int all = stepBackAndCheck(1000, "step to base");
+  CHECK(history.size() == 1, "not at base after %d steps", all);
+  CHECK(rewindBuffer.stepBack(spec, 1) == 0, "stepped past the base");
+
+  // ═══ 3) Кольцо байт переполняется: старые точки вытесняются ═══
+  restart();
+  for (int k = 0; k < 200; k++) runPoint(3000);   // Почти все блоки грязные
+  int deep = stepBackAndCheck(1000, "after ring wrap");
+  CHECK(deep > 0 && deep < 199, "ring wrap: %d points kept of 200", deep + 1);
+  printf("rewind: ring wrap keeps %d of 200 heavy points\n", deep + 1);
+  for (int k = 0; k < 30; k++) runPoint(3000);     // После перемотки - снова вперёд по кольцу
+  stepBackAndCheck(12, "after wrap, forward, back");
+
+  // ═══ 4) Индекс точек переполняется раньше кольца (мелкие дельты) ═══
+  restart();
+  for (int k = 0; k < RewindBuffer::MAX_POINTS + 100; k++) runPoint(1);
+  int kept = stepBackAndCheck(100000, "point index wrap");
+  CHECK(kept == RewindBuffer::MAX_POINTS - 1, "point index wrap: stepped %d", kept);
+
+  // ═══ 5) Назад через restoreImage (загрузка слота сохранения) ═══
+  restart();
+  for (int k = 0; k < 10; k++) runPoint(50);
+  Bytes slot(MachineSnapshot::SERIAL_SIZE);
+  MachineSnapshot::captureImage(spec, slot.data());
+  for (int k = 0; k < 10; k++) runPoint(50);
+  PointImage beforeLoad = history.back();
+  size_t loadAt = history.size() - 1;
+  CHECK(MachineSnapshot::restoreImage(slot.data(), slot.size(), spec), "restoreImage");
+  for (int k = 0; k < 5; k++) runPoint(50);
+  stepBackAndCheck((int)(history.size() - 1 - loadAt), "back to just before the load");
+  CHECK(same(now(), beforeLoad), "state before the slot load not restored");
+  stepBackAndCheck(4, "further back before the load");
+
+  // ═══ 6) Замер снятия точки ═══
+  RewindStats st;
+  rewindBuffer.takeStats(st);
+  restart();
+  for (int k = 0; k < 100; k++) runPoint(50);
+  rewindBuffer.takeStats(st);
+  printf("rewind: point %u us avg, %u B, %u blocks (50 pokes/frame)\n", st.avgUs, st.avgBytes, st.avgBlocks);
+
+  return hostReport("test_rewind_buffer");
+}
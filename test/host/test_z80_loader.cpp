@@ -0,0 +1,224 @@
+// Загрузка .Z80 (V3.162): потоковый RLE (Z80RleStream) и Z80Loader
+// на файлах "с карты" в памяти (stubs/SD.h). Корпус: случайные образы
+// RAM → эталонный компрессор → v1 / v3 → загрузка, RAM и PC совпадают.
+// Z80RleStream на мусорных потоках при любых размерах кусков сверяется
+// с прежним decompressBlock (весь блок в куче). Плюс замер обоих путей.
+#include "host_test.h"
+#include "spectrum_mini.h"
+#include "z80_loader.h"
+#include <random>
+#include <vector>
+
+HardwareSerial Serial;
+SDFS SD;
+
+extern "C" {
+  byte Z80MemRead(uint16_t address, void* userInfo) { return ((ZXSpectrum*)userInfo)->z80_peek(address); }
+  void Z80MemWrite(uint16_t address, byte data, void* userInfo) { ((ZXSpectrum*)userInfo)->z80_poke(address, data); }
+  byte Z80InPort(uint16_t port, void* userInfo) { return ((ZXSpectrum*)userInfo)->z80_in(port); }
+  void Z80OutPort(uint16_t port, byte data, void* userInfo) { ((ZXSpectrum*)userInfo)->z80_out(port, data); }
+}
+
+static const size_t RAM_SIZE = 49152;
+static const char* const PATH = "/test.z80";
+
+typedef std::vector<uint8_t> Bytes;
+
+// Эталонный компрессор по спецификации .z80: повтор ≥5 (или ≥2 для ED)
+// → ED ED n v; байт сразу после одиночного ED в блок не берётся
+static void compress(const uint8_t* data, size_t len, Bytes& out) {
+  size_t i = 0;
+  while (i < len) {
+    size_t run = 1;
+    while (i + run < len && data[i + run] == data[i] && run < 255) run++;
+    if (run >= 5 || (data[i] == 0xED && run >= 2)) {
+      out.insert(out.end(), {0xED, 0xED, (uint8_t)run, data[i]});
+      i += run;
+    } else if (data[i] == 0xED) {
+      out.push_back(data[i++]);
+      if (i < len) out.push_back(data[i++]);
+    } else {
+      out.push_back(data[i++]);
+    }
+  }
+}
+
+// Прежний Z80Loader::decompressBlock (до V3.162) - эталон для потокового
+static bool oldDecompress(const uint8_t* in, size_t inSize, uint8_t* out, size_t outSize) {
+  size_t inPos = 0;
+  size_t outPos = 0;
+  while (inPos < inSize && outPos < outSize) {
+    uint8_t b = in[inPos++];
+    if (b == 0xED && inPos < inSize && in[inPos] == 0xED) {
+      inPos++;
+      if (inPos + 1 >= inSize) return false;
+      uint8_t count = in[inPos++];
+      uint8_t value = in[inPos++];
+      if (count == 0 && value == 0) break;
+      for (int i = 0; i < count && outPos < outSize; i++) out[outPos++] = value;
+    } else {
+      out[outPos++] = b;
+    }
+  }
+  return true;
+}
+
+// Образ RAM кусками: нули, сплошные ED, ED через байт, повторы, шум
+static void makeRam(std::mt19937& rng, uint8_t* ram, bool loneEd) {
+  for (size_t i = 0; i < RAM_SIZE;) {
+    int kind = rng() % 6;
+    int len = 1 + rng() % 300;
+    uint8_t v = rng();
+    for (int k = 0; k < len && i < RAM_SIZE; k++, i++) {
+      ram[i] = kind == 0 ? 0 : kind == 1 ? 0xED : kind == 2 ? ((k & 1) ? 0xED : v) : kind == 3 ? v : (uint8_t)rng();
+    }
+    if (loneEd && (i % 7) == 0 && i < RAM_SIZE) ram[i++] = 0xED;
+  }
+}
+
+// 30 байт заголовка: A=0x12, SP=0xFF00, flags1 (бит 5 = сжато), IM 1.
+// v1: PC в заголовке; v2/v3: PC = 0 и дальше расширенный заголовок
+static Bytes header(uint16_t pc, uint8_t flags1) {
+  Bytes h(30, 0);
+  h[0] = 0x12;
+  h[6] = pc & 0xFF;
+  h[7] = pc >> 8;
+  h[9] = 0xFF;
+  h[12] = flags1;
+  h[29] = 1;
+  return h;
+}
+
+static Bytes makeV1(const uint8_t* ram) {
+  Bytes f = header(0x1234, 0x20);
+  compress(ram, RAM_SIZE, f);
+  f.insert(f.end(), {0x00, 0xED, 0xED, 0x00});
+  return f;
+}
+
+// v3: страницы 8/4/5 (0x4000/0x8000/0xC000), rawPage - без сжатия (0xFFFF)
+static Bytes makeV3(const uint8_t* ram, int rawPage) {
+  Bytes f = header(0, 0x20);
+  Bytes ext(2 + 54, 0);
+  ext[0] = 54;
+  ext[3] = 0x78;   // PC = 0x7800
+  f.insert(f.end(), ext.begin(), ext.end());
+  const int pages[3] = {8, 4, 5};
+  for (int p = 0; p < 3; p++) {
+    const uint8_t* src = ram + p * 16384;
+    Bytes block;
+    uint16_t len;
+    if (p == rawPage) {
+      block.assign(src, src + 16384);
+      len = 0xFFFF;
+    } else {
+      compress(src, 16384, block);
+      len = block.size();
+    }
+    f.insert(f.end(), {(uint8_t)(len & 0xFF), (uint8_t)(len >> 8), (uint8_t)pages[p]});
+    f.insert(f.end(), block.begin(), block.end());
+  }
+  return f;
+}
+
+static bool loadFile(ZXSpectrum* spec, const Bytes& file) {
+  SD.files[PATH] = std::make_shared<Bytes>(file);
+  memset(spec->mem.ram, 0x55, RAM_SIZE);
+  Z80Loader loader;
+  return loader.loadZ80(PATH, spec);
+}
+
+int main() {
+  ZXSpectrum* spec = new ZXSpectrum();
+  spec->reset();
+  spec->init_48k();
+  spec->reset_spectrum();
+  Serial.quiet = true;   // Загрузчик подробно пишет каждый файл
+
+  std::mt19937 rng(7);
+  static uint8_t ram[RAM_SIZE];
+  int loads = 0;
+
+  // ═══ 1) Корпус: v1 сжатый, v3 с одной несжатой страницей ═══
+  for (int t = 0; t < 200; t++) {
+    makeRam(rng, ram, t & 1);
+
+    bool ok = loadFile(spec, makeV1(ram));
+    CHECK(ok && memcmp(spec->mem.ram, ram, RAM_SIZE) == 0 && spec->z80Regs->PC.W == 0x1234,
+          "v1 image %d (ok %d, PC %04X)", t, ok, spec->z80Regs->PC.W);
+
+    int rawPage = rng() % 4;   // 3 = все сжаты
+    ok = loadFile(spec, makeV3(ram, rawPage));
+    CHECK(ok && memcmp(spec->mem.ram, ram, RAM_SIZE) == 0 && spec->z80Regs->PC.W == 0x7800,
+          "v3 image %d raw page %d (ok %d, PC %04X)", t, rawPage, ok, spec->z80Regs->PC.W);
+    loads += 2;
+  }
+
+  // ═══ 2) Битые файлы: ошибка, а не чтение за концом ═══
+  makeRam(rng, ram, false);
+  Bytes v3 = makeV3(ram, 3);
+  CHECK(!loadFile(spec, Bytes(v3.begin(), v3.begin() + 20)), "truncated header accepted");
+  Bytes v1 = header(0x1234, 0x20);
+  v1.insert(v1.end(), {0x01, 0x02, 0x03, 0xED, 0xED, 0x07});   // Оборван посреди ED ED xx yy
+  CHECK(!loadFile(spec, v1), "v1 cut inside an RLE block accepted");
+  CHECK(!Z80Loader().loadZ80("/missing.z80", spec), "missing file accepted");
+
+  // ═══ 3) Мусорные потоки кусками любого размера = прежний декодер ═══
+  int streams = 0;
+  for (int t = 0; t < 3000; t++) {
+    size_t n = 1 + rng() % 3000;
+    Bytes in(n);
+    for (auto& b : in) b = (rng() % 3 == 0) ? 0xED : (rng() % 4 == 0 ? 0 : rng());
+    size_t outSize = 1 + rng() % 20000;
+    Bytes expect(outSize, 0x11), got(outSize, 0x11);
+    bool okOld = oldDecompress(in.data(), n, expect.data(), outSize);
+
+    size_t chunk = 1 + rng() % 600;
+    Z80RleStream rle;
+    rle.begin(got.data(), outSize);
+    bool more = true;
+    for (size_t i = 0; i < n && more; i += chunk) more = rle.feed(&in[i], std::min(chunk, n - i));
+    bool okNew = more ? rle.finish() : true;
+
+    CHECK(okOld == okNew && (!okOld || expect == got), "stream %d: %zu bytes, out %zu, chunk %zu, old %d new %d",
+          t, n, outSize, chunk, okOld, okNew);
+    streams++;
+  }
+  printf("z80_loader: %d loads, %d streams\n", loads, streams);
+
+  // ═══ 4) Замер: файл целиком в куче + decompressBlock + memcpy против потока ═══
+  makeRam(rng, ram, false);
+  Bytes packed;
+  compress(ram, RAM_SIZE, packed);
+  const int REPS = 2000;
+  auto t0 = std::chrono::steady_clock::now();
+  for (int k = 0; k < REPS; k++) {
+    uint8_t* file = (uint8_t*)malloc(packed.size());
+    memcpy(file, packed.data(), packed.size());
+    uint8_t* out = (uint8_t*)malloc(RAM_SIZE);
+    oldDecompress(file, packed.size(), out, RAM_SIZE);
+    memcpy(spec->mem.ram, out, RAM_SIZE);
+    free(out);
+    free(file);
+  }
+  double oldUs = hostSecondsSince(t0) / REPS * 1e6;
+
+  t0 = std::chrono::steady_clock::now();
+  uint8_t chunk[Z80Loader::CHUNK_SIZE];
+  for (int k = 0; k < REPS; k++) {
+    Z80RleStream rle;
+    rle.begin(spec->mem.ram, RAM_SIZE);
+    for (size_t i = 0; i < packed.size(); i += sizeof(chunk)) {
+      size_t n = std::min(sizeof(chunk), packed.size() - i);
+      memcpy(chunk, &packed[i], n);   // Как file.read в буфер на стеке
+      if (!rle.feed(chunk, n)) break;
+    }
+    rle.finish();
+  }
+  double newUs = hostSecondsSince(t0) / REPS * 1e6;
+  CHECK(memcmp(spec->mem.ram, ram, RAM_SIZE) == 0, "benchmark image differs");
+  printf("z80_loader: %zu B compressed → 48K: heap %.1f us (%zu B malloc), stream %.1f us (0 B)\n",
+         packed.size(), oldUs, packed.size() + RAM_SIZE, newUs);
+
+  return hostReport("test_z80_loader");
+}